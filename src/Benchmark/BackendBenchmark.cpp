@@ -0,0 +1,265 @@
+/**
+ * @file BackendBenchmark.cpp
+ * @author Timo Lange
+ * @brief Benchmarks of the MQTT library wrappers and of the loopback backend
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+#ifdef IMQTT_USE_MOSQ
+#include <mqtt_protocol.h>
+
+#include "Mosquitto/MosquittoClient.h"
+#endif
+#ifdef IMQTT_USE_PAHO
+#include "Paho/PahoClient.h"
+#endif
+
+using namespace std;
+using namespace i_mqtt_client;
+
+#if defined(IMQTT_USE_MOSQ) || defined(IMQTT_USE_PAHO) || defined(IMQTT_USE_LOOPBACK)
+static constexpr size_t batchSize{1024U};
+#endif
+
+#ifdef IMQTT_USE_LOOPBACK
+/*counts the messages received, the benchmark waits for each message it published*/
+class ReceiveCallbacks final : public IMqttMessageCallbacks {
+private:
+    mutable mutex              receiveMutex;
+    mutable condition_variable receiveAwaiter;
+    mutable size_t             received{0U};
+
+public:
+    void
+    OnMqttMessage(upMqttMessage_t) const override
+    {
+        {
+            lock_guard<mutex> lock(receiveMutex);
+            received++;
+        }
+        receiveAwaiter.notify_one();
+    }
+
+    void
+    WaitFor(size_t count) const
+    {
+        unique_lock<mutex> lock(receiveMutex);
+        receiveAwaiter.wait(lock, [this, count] { return received >= count; });
+    }
+};
+
+/*A message is published by one client and received by another one, both connected to the in-process broker, before the
+ * next one is published. So this is the latency of the whole path through the library, without a network. Messages
+ * are created in batches, outside of the timing.*/
+static void
+loopbackPublishReceive(benchmark::State& state)
+{
+    NullCallbacks                     callbacks;
+    ReceiveCallbacks                  receiver;
+    IMqttClient::InitializeParameters params;
+    params.hostAddress = "benchmark";
+    params.clientId    = "subscriber";
+    auto subscriber{MqttClientFactory::Create(
+        IMqttClient::Backend::LOOPBACK, params, &receiver, &callbacks, &callbacks, &callbacks)};
+    params.clientId = "publisher";
+    auto publisher{MqttClientFactory::Create(
+        IMqttClient::Backend::LOOPBACK, params, &callbacks, &callbacks, &callbacks, &callbacks)};
+    auto qos{static_cast<IMqttMessage::QOS>(state.range(1))};
+    if (ReasonCode::OKAY != subscriber->ConnectAsync() || ReasonCode::OKAY != publisher->ConnectAsync() ||
+        ReasonCode::OKAY != subscriber->SubscribeAsync("benchmark/topic", qos)) {
+        state.SkipWithError("loopback clients can not subscribe");
+        return;
+    }
+
+    size_t                  published{0U};
+    vector<upMqttMessage_t> messages;
+    for (auto _ : state) {
+        if (messages.empty()) {
+            state.PauseTiming();
+            for (size_t i{0U}; i < batchSize; i++) {
+                messages.push_back(CreateMessage(static_cast<size_t>(state.range(0)), qos));
+            }
+            state.ResumeTiming();
+        }
+        if (ReasonCode::OKAY != publisher->PublishAsync(move(messages.back()))) {
+            state.SkipWithError("loopback client can not publish");
+            break;
+        }
+        messages.pop_back();
+        receiver.WaitFor(++published);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(loopbackPublishReceive)->ArgsProduct({{16, 1024, 65536}, {0, 1, 2}})->UseRealTime();
+#endif
+
+#if defined(IMQTT_USE_MOSQ) || defined(IMQTT_USE_PAHO)
+
+/*The client is not connected, so the MQTT library rejects the message right after the wrapper converted it. Messages
+ * are created in batches, outside of the timing.*/
+static void
+publishAsync(benchmark::State& state, IMqttClient::Backend backend)
+{
+    NullCallbacks                     callbacks;
+    IMqttClient::InitializeParameters params;
+    params.clientId = "benchmark";
+    auto client{MqttClientFactory::Create(backend, params, &callbacks, &callbacks, &callbacks, &callbacks)};
+
+    vector<upMqttMessage_t> messages;
+    for (auto _ : state) {
+        if (messages.empty()) {
+            state.PauseTiming();
+            for (size_t i{0U}; i < batchSize; i++) {
+                messages.push_back(CreateMessage(static_cast<size_t>(state.range(0)), IMqttMessage::QOS::QOS_0));
+            }
+            state.ResumeTiming();
+        }
+        benchmark::DoNotOptimize(client->PublishAsync(move(messages.back())));
+        messages.pop_back();
+    }
+}
+#endif
+#ifdef IMQTT_USE_MOSQ
+BENCHMARK_CAPTURE(publishAsync, mosquitto, IMqttClient::Backend::MOSQUITTO)->Arg(16)->Arg(1024)->Arg(65536);
+#endif
+#ifdef IMQTT_USE_PAHO
+BENCHMARK_CAPTURE(publishAsync, paho, IMqttClient::Backend::PAHO)->Arg(16)->Arg(1024)->Arg(65536);
+#endif
+
+#ifdef IMQTT_USE_MOSQ
+/*converts a message as received by the message callback, the properties are read from the same message again and
+ * again, Mosquitto does not hand over their ownership*/
+static void
+mosquittoOnMessage(benchmark::State& state)
+{
+    NullCallbacks callbacks;
+
+    string                             topic{"benchmark/topic"};
+    vector<IMqttMessage::payloadRaw_t> payload(static_cast<size_t>(state.range(0)), 0x55U);
+    vector<IMqttMessage::payloadRaw_t> correlationData{1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U};
+    mosquitto_property*                pProps{nullptr};
+    (void)mosquitto_property_add_string_pair(&pProps, MQTT_PROP_USER_PROPERTY, "key1", "value1");
+    (void)mosquitto_property_add_string_pair(&pProps, MQTT_PROP_USER_PROPERTY, "key2", "value2");
+    (void)mosquitto_property_add_binary(
+        &pProps, MQTT_PROP_CORRELATION_DATA, correlationData.data(), static_cast<uint16_t>(correlationData.size()));
+    (void)mosquitto_property_add_string(&pProps, MQTT_PROP_RESPONSE_TOPIC, "benchmark/response");
+    (void)mosquitto_property_add_string(&pProps, MQTT_PROP_CONTENT_TYPE, "application/octet-stream");
+    (void)mosquitto_property_add_byte(&pProps, MQTT_PROP_PAYLOAD_FORMAT_INDICATOR, 1U);
+    (void)mosquitto_property_add_varint(&pProps, MQTT_PROP_SUBSCRIPTION_IDENTIFIER, 1U);
+
+    mosquitto_message msg;
+    msg.mid        = 1;
+    msg.topic      = &topic[0];
+    msg.payload    = payload.data();
+    msg.payloadlen = static_cast<int>(payload.size());
+    msg.qos        = 1;
+    msg.retain     = false;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MosquittoToMqttMessage(&msg, pProps, &callbacks));
+    }
+    mosquitto_property_free_all(&pProps);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(mosquittoOnMessage)->Arg(16)->Arg(1024)->Arg(65536);
+#endif
+
+#ifdef IMQTT_USE_PAHO
+static void
+addPahoProperty(MQTTAsync_message* msg, MQTTPropertyCodes identifier, char const* data, char const* value = nullptr)
+{
+    MQTTProperty prop;
+    prop.identifier      = identifier;
+    prop.value.data.data = const_cast<char*>(data);
+    prop.value.data.len  = static_cast<int>(strlen(data));
+    if (value) {
+        prop.value.value.data = const_cast<char*>(value);
+        prop.value.value.len  = static_cast<int>(strlen(value));
+    }
+    (void)MQTTProperties_add(&msg->properties, &prop);
+}
+
+/*a message as allocated by Paho, the message callback takes over topic and message and frees them*/
+static pair<char*, MQTTAsync_message*>
+createPahoMessage(size_t payloadSize)
+{
+    static char const topic[]{"benchmark/topic"};
+    auto              pTopic{static_cast<char*>(MQTTAsync_malloc(sizeof(topic)))};
+    memcpy(pTopic, topic, sizeof(topic));
+
+    MQTTAsync_message init MQTTAsync_message_initializer;
+    auto              msg{static_cast<MQTTAsync_message*>(MQTTAsync_malloc(sizeof(MQTTAsync_message)))};
+    *msg            = init;
+    msg->payload    = MQTTAsync_malloc(payloadSize);
+    msg->payloadlen = static_cast<int>(payloadSize);
+    memset(msg->payload, 0x55, payloadSize);
+    msg->qos   = 1;
+    msg->msgid = 1;
+    addPahoProperty(msg, MQTTPROPERTY_CODE_USER_PROPERTY, "key1", "value1");
+    addPahoProperty(msg, MQTTPROPERTY_CODE_USER_PROPERTY, "key2", "value2");
+    addPahoProperty(msg, MQTTPROPERTY_CODE_CORRELATION_DATA, "12345678");
+    addPahoProperty(msg, MQTTPROPERTY_CODE_RESPONSE_TOPIC, "benchmark/response");
+    addPahoProperty(msg, MQTTPROPERTY_CODE_CONTENT_TYPE, "application/octet-stream");
+    MQTTProperty prop;
+    prop.identifier = MQTTPROPERTY_CODE_PAYLOAD_FORMAT_INDICATOR;
+    prop.value.byte = 1U;
+    (void)MQTTProperties_add(&msg->properties, &prop);
+    prop.identifier     = MQTTPROPERTY_CODE_SUBSCRIPTION_IDENTIFIER;
+    prop.value.integer4 = 1U;
+    (void)MQTTProperties_add(&msg->properties, &prop);
+    return make_pair(pTopic, msg);
+}
+
+/*converts a message as received by the message callback, messages are allocated in batches, outside of the timing,
+ * freeing them is part of the callback*/
+static void
+pahoOnMessage(benchmark::State& state)
+{
+    NullCallbacks callbacks;
+
+    vector<pair<char*, MQTTAsync_message*>> messages;
+    for (auto _ : state) {
+        if (messages.empty()) {
+            state.PauseTiming();
+            for (size_t i{0U}; i < batchSize; i++) {
+                messages.push_back(createPahoMessage(static_cast<size_t>(state.range(0))));
+            }
+            state.ResumeTiming();
+        }
+        auto msg{messages.back()};
+        messages.pop_back();
+        benchmark::DoNotOptimize(
+            PahoToMqttMessage(msg.first, static_cast<int>(strlen(msg.first)), msg.second, &callbacks));
+        MQTTAsync_freeMessage(&msg.second);
+        MQTTAsync_free(msg.first);
+    }
+    for (auto& msg : messages) {
+        MQTTAsync_freeMessage(&msg.second);
+        MQTTAsync_free(msg.first);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(pahoOnMessage)->Arg(16)->Arg(1024)->Arg(65536);
+#endif
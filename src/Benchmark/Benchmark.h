@@ -0,0 +1,77 @@
+/**
+ * @file Benchmark.h
+ * @author Timo Lange
+ * @brief Helpers shared by the benchmarks
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/*Callbacks doing nothing, such that the benchmarks measure the library only*/
+class NullCallbacks final : public IMqttClientCallbacks {
+public:
+    NullCallbacks(void)
+    {
+        SetMinLogLevel(LogLevel::FATAL);
+    }
+
+    void
+    Log(LogLevel, std::string const&) const override
+    {
+    }
+    void
+    OnMqttMessage(upMqttMessage_t) const override
+    {
+    }
+    void
+    OnConnectionStatusChanged(ConnectionType, Mqtt5ReasonCode) const override
+    {
+    }
+    void
+    OnSubscribe(token_t) const override
+    {
+    }
+    void
+    OnUnSubscribe(token_t) const override
+    {
+    }
+    void
+    OnPublish(token_t, Mqtt5ReasonCode) const override
+    {
+    }
+};
+
+/*a message with all MQTTv5 properties set, that the MQTT library wrappers convert*/
+inline upMqttMessage_t
+CreateMessage(size_t payloadSize, IMqttMessage::QOS qos)
+{
+    auto msg{MqttMessageFactory::Create(
+        std::string("benchmark/topic"), std::vector<IMqttMessage::payloadRaw_t>(payloadSize, 0x55U), qos)};
+    msg->userProps              = {{"key1", "value1"}, {"key2", "value2"}};
+    msg->correlationDataProps   = {1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U};
+    msg->responseTopic          = "benchmark/response";
+    msg->payloadFormatIndicator = IMqttMessage::FormatIndicator::UTF8;
+    msg->payloadContentType     = "application/octet-stream";
+    return msg;
+}
+}  // namespace i_mqtt_client
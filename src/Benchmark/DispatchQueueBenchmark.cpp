@@ -0,0 +1,96 @@
+/**
+ * @file DispatchQueueBenchmark.cpp
+ * @author Timo Lange
+ * @brief Benchmarks of the dispatch queue
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IDispatchQueue.h"
+#include "LatencyHistogram.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace i_mqtt_client;
+
+/*message handler of the queue, measures the time from enqueuing a message until it is delivered*/
+class Receiver final : public IMqttMessageCallbacks {
+public:
+    mutable atomic<uint64_t> delivered{0U};
+    mutable LatencyHistogram latency;
+
+    void
+    OnMqttMessage(upMqttMessage_t msg) const override
+    {
+        steady_clock::rep enqueued;
+        memcpy(&enqueued, msg->payload.data(), sizeof(enqueued));
+        latency.Record(duration_cast<microseconds>(steady_clock::now().time_since_epoch() -
+                                                   steady_clock::duration(enqueued)));
+        delivered.fetch_add(1U, memory_order_release);
+    }
+};
+
+static unique_ptr<Receiver>       receiver;
+static unique_ptr<IDispatchQueue> dispatchQueue;
+static atomic<uint64_t>           sent{0U};
+
+/*threads enqueue messages carrying the time of enqueuing, the queue delivers them from its own thread, the message
+ * creation is included (see messageFactoryCreateMove)*/
+static void
+dispatchQueueEnqueueToDelivery(benchmark::State& state)
+{
+    if (0 == state.thread_index()) {
+        receiver.reset(new Receiver());
+        dispatchQueue = DispatchQueueFactory::Create(nullptr, *receiver);
+        sent.store(0U, memory_order_relaxed);
+    }
+    string const topic{"benchmark/topic"};
+    for (auto _ : state) {
+        auto now{steady_clock::now().time_since_epoch().count()};
+        auto raw{reinterpret_cast<IMqttMessage::payloadRaw_t const*>(&now)};
+        dispatchQueue->OnMqttMessage(MqttMessageFactory::Create(
+            string(topic), vector<IMqttMessage::payloadRaw_t>(raw, raw + sizeof(now)), IMqttMessage::QOS::QOS_0));
+        sent.fetch_add(1U, memory_order_relaxed);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    if (0 == state.thread_index()) {
+        /*all threads left the loop, the queue is drained before reading the latencies*/
+        auto drainStart{steady_clock::now()};
+        while (receiver->delivered.load(memory_order_acquire) < sent.load(memory_order_relaxed)) {
+            this_thread::yield();
+        }
+        IMqttClient::PublishLatencySnapshot snapshot;
+        receiver->latency.Snapshot(snapshot);
+        state.counters["drain_us"] =
+            static_cast<double>(duration_cast<microseconds>(steady_clock::now() - drainStart).count());
+        state.counters["latency_p50_us"]  = static_cast<double>(snapshot.p50.count());
+        state.counters["latency_p99_us"]  = static_cast<double>(snapshot.p99.count());
+        state.counters["latency_p999_us"] = static_cast<double>(snapshot.p999.count());
+        state.counters["latency_max_us"]  = static_cast<double>(snapshot.max.count());
+        dispatchQueue.reset();
+        receiver.reset();
+    }
+}
+BENCHMARK(dispatchQueueEnqueueToDelivery)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,94 @@
+/**
+ * @file MessageBenchmark.cpp
+ * @author Timo Lange
+ * @brief Benchmarks of creating messages and of the string representations of reason codes
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "IMqttClient.h"
+
+using namespace std;
+using namespace i_mqtt_client;
+
+/*copies the payload, as the MQTT library wrappers do with the buffer of the MQTT library*/
+static void
+messageFactoryCreate(benchmark::State& state)
+{
+    string const                       topic{"benchmark/topic"};
+    vector<IMqttMessage::payloadRaw_t> payload(static_cast<size_t>(state.range(0)), 0x55U);
+    for (auto _ : state) {
+        auto msg{MqttMessageFactory::Create(topic, IMqttMessage::payload_t(payload), IMqttMessage::QOS::QOS_1)};
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(messageFactoryCreate)->Arg(0)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+/*takes over topic and payload, which are filled from a buffer once*/
+static void
+messageFactoryCreateMove(benchmark::State& state)
+{
+    string const                       topic{"benchmark/topic"};
+    vector<IMqttMessage::payloadRaw_t> payload(static_cast<size_t>(state.range(0)), 0x55U);
+    for (auto _ : state) {
+        auto msg{MqttMessageFactory::Create(string(topic),
+                                            vector<IMqttMessage::payloadRaw_t>(payload.begin(), payload.end()),
+                                            IMqttMessage::QOS::QOS_1)};
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(messageFactoryCreateMove)->Arg(0)->RangeMultiplier(16)->Range(16, 1 << 20);
+
+/*cycles through all reason codes and the first unknown one after them*/
+static void
+reasonCodeToStringRepr(benchmark::State& state)
+{
+    constexpr int reasonCodeCycle{static_cast<int>(ReasonCode::ERROR_TIMEOUT) + 2};
+    int           rc{0};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(IMqttClient::ReasonCodeToStringRepr(static_cast<ReasonCode>(rc)));
+        rc = (rc + 1) % reasonCodeCycle;
+    }
+}
+BENCHMARK(reasonCodeToStringRepr);
+
+static void
+mqttReasonCodeToStringRepr(benchmark::State& state)
+{
+    int rc{0};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(IMqttClient::MqttReasonCodeToStringRepr(rc));
+        rc = (rc + 1) % 8;
+    }
+}
+BENCHMARK(mqttReasonCodeToStringRepr);
+
+static void
+mqtt5ReasonCodeToStringRepr(benchmark::State& state)
+{
+    int rc{0};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(IMqttClient::Mqtt5ReasonCodeToStringRepr(rc));
+        rc = (rc + 1) % 256;
+    }
+}
+BENCHMARK(mqtt5ReasonCodeToStringRepr);
@@ -0,0 +1,201 @@
+/**
+ * @file AsyncLog.cpp
+ * @author Timo Lange
+ * @brief Implementation of the asynchronous log sink
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "AsyncLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace i_mqtt_client {
+/*bounds the time a wake up of the drainer may get lost, as producers notify without locking*/
+static constexpr chrono::milliseconds drainerIdleWait{10};
+
+static size_t
+roundUpToPowerOfTwo(size_t value)
+{
+    size_t result{1U};
+    while (result < value) {
+        result <<= 1U;
+    }
+    return result;
+}
+
+AsyncLog::AsyncLog(IMqttLogCallbacks* log, MmqttLibLogCb_t libLog, IMqttAsyncLog::Parameters const& params)
+  : logCb(log)
+  , libLogCb(move(libLog))
+  , mask(roundUpToPowerOfTwo(max(params.records, size_t{2U})) - 1U)
+  , textLength(params.textLength)
+  , records(new Record[mask + 1U])
+  , texts((mask + 1U) * params.textLength)
+{
+    if (!params.textLength) {
+        throw runtime_error("async log without text length");
+    }
+    for (size_t i{0U}; i <= mask; i++) {
+        records[i].sequence.store(i, memory_order_relaxed);
+    }
+    /*not virtual while constructing, so the level is not written back*/
+    if (logCb) {
+        IMqttLogCallbacks::SetMinLogLevel(logCb->GetMinLogLevel());
+    }
+    drainerThread = thread(&AsyncLog::drainerWorker, this);
+}
+
+AsyncLog::~AsyncLog() noexcept
+{
+    {
+        lock_guard<mutex> lock(drainerMutex);
+        drainerExit = true;
+    }
+    drainerAwaiter.notify_all();
+    if (drainerThread.joinable()) {
+        drainerThread.join();
+    }
+}
+
+void
+AsyncLog::push(bool lib, int lvl, string const& txt) const
+{
+    auto pos{enqueuePos.load(memory_order_relaxed)};
+    for (;;) {
+        auto& record = records[pos & mask];
+        auto  diff{static_cast<intptr_t>(record.sequence.load(memory_order_acquire)) - static_cast<intptr_t>(pos)};
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1U, memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            /*the drainer did not yet free the record of the previous round, so the ring is full*/
+            (lib ? droppedLib : dropped).fetch_add(1U, memory_order_relaxed);
+            return;
+        }
+        else {
+            pos = enqueuePos.load(memory_order_relaxed);
+        }
+    }
+    auto& record = records[pos & mask];
+    record.lib    = lib;
+    record.lvl    = lvl;
+    record.length = min(txt.size(), textLength);
+    if (record.length < txt.size()) {
+        truncated.fetch_add(1U, memory_order_relaxed);
+    }
+    memcpy(&texts[(pos & mask) * textLength], txt.data(), record.length);
+    record.sequence.store(pos + 1U, memory_order_release);
+    if (drainerSleeping.load(memory_order_acquire)) {
+        drainerAwaiter.notify_one();
+    }
+}
+
+bool
+AsyncLog::drainOne(void)
+{
+    auto& record = records[dequeuePos & mask];
+    if (record.sequence.load(memory_order_acquire) != dequeuePos + 1U) {
+        return false;
+    }
+    string txt(&texts[(dequeuePos & mask) * textLength], record.length);
+    auto   lib{record.lib};
+    auto   lvl{record.lvl};
+    /*the record is free for producers of the next round from here*/
+    record.sequence.store(dequeuePos + mask + 1U, memory_order_release);
+    dequeuePos++;
+    if (lib) {
+        if (libLogCb) {
+            libLogCb(static_cast<LogLevelLib>(lvl), txt);
+        }
+    }
+    else if (logCb && logCb->IsLogged(static_cast<LogLevel>(lvl))) {
+        logCb->Log(static_cast<LogLevel>(lvl), txt);
+    }
+    else {
+        /*queued before the level was raised, or by a caller not checking it*/
+        return true;
+    }
+    logged.fetch_add(1U, memory_order_relaxed);
+    return true;
+}
+
+void
+AsyncLog::drainerWorker(void)
+{
+    while (!drainerExit) {
+        if (drainOne()) {
+            continue;
+        }
+        unique_lock<mutex> lock(drainerMutex);
+        drainerSleeping = true;
+        /*a record published before the flag was set would not notify*/
+        if (records[dequeuePos & mask].sequence.load(memory_order_acquire) != dequeuePos + 1U) {
+            drainerAwaiter.wait_for(lock, drainerIdleWait);
+        }
+        drainerSleeping = false;
+    }
+    /*hand over what was queued until the destruction*/
+    while (drainOne()) {
+    }
+}
+
+void
+AsyncLog::Log(LogLevel lvl, string const& txt) const
+{
+    push(false, static_cast<int>(lvl), txt);
+}
+
+void
+AsyncLog::LogLib(LogLevelLib lvl, string const& txt) const
+{
+    push(true, static_cast<int>(lvl), txt);
+}
+
+void
+AsyncLog::SetMinLogLevel(LogLevel lvl) noexcept
+{
+    IMqttLogCallbacks::SetMinLogLevel(lvl);
+    if (logCb) {
+        logCb->SetMinLogLevel(lvl);
+    }
+}
+
+IMqttAsyncLog::Status
+AsyncLog::GetStatus(void) const noexcept
+{
+    Status status;
+    status.logged     = logged.load(memory_order_relaxed);
+    status.dropped    = dropped.load(memory_order_relaxed);
+    status.droppedLib = droppedLib.load(memory_order_relaxed);
+    status.truncated  = truncated.load(memory_order_relaxed);
+    return status;
+}
+
+unique_ptr<IMqttAsyncLog>
+MqttAsyncLogFactory::Create(IMqttLogCallbacks*               log,
+                            MmqttLibLogCb_t                  libLog,
+                            IMqttAsyncLog::Parameters const& params)
+{
+    return unique_ptr<IMqttAsyncLog>(new AsyncLog(log, move(libLog), params));
+}
+}  // namespace i_mqtt_client
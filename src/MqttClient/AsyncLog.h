@@ -0,0 +1,77 @@
+/**
+ * @file AsyncLog.h
+ * @author Timo Lange
+ * @brief Class definition for the asynchronous log sink
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "IMqttAsyncLog.h"
+
+namespace i_mqtt_client {
+/*Bounded multi producer, single consumer ring. Each record carries a sequence number, that tells producers and the
+ * consumer whose turn it is, so producers only contend on the enqueue position.*/
+class AsyncLog final : public IMqttAsyncLog {
+private:
+    struct Record final {
+        std::atomic_size_t sequence{0U};
+        bool               lib{false};
+        int                lvl{0};
+        size_t             length{0U};
+    };
+
+    IMqttLogCallbacks* const  logCb;
+    MmqttLibLogCb_t const     libLogCb;
+    size_t const              mask;
+    size_t const              textLength;
+    std::unique_ptr<Record[]> records;
+    mutable std::vector<char> texts;
+
+    mutable std::atomic_size_t      enqueuePos{0U};
+    size_t                          dequeuePos{0U};
+    mutable std::atomic_uint64_t    dropped{0U};
+    mutable std::atomic_uint64_t    droppedLib{0U};
+    mutable std::atomic_uint64_t    truncated{0U};
+    std::atomic_uint64_t            logged{0U};
+    std::atomic_bool                drainerSleeping{false};
+    std::atomic_bool                drainerExit{false};
+    std::mutex                      drainerMutex;
+    mutable std::condition_variable drainerAwaiter;
+    std::thread                     drainerThread;
+
+    void push(bool lib, int lvl, std::string const&) const;
+    bool drainOne(void);
+    void drainerWorker(void);
+
+    void Log(LogLevel, std::string const&) const override;
+    void LogLib(LogLevelLib, std::string const&) const override;
+    void SetMinLogLevel(LogLevel) noexcept override;
+
+public:
+    AsyncLog(IMqttLogCallbacks*, MmqttLibLogCb_t, IMqttAsyncLog::Parameters const&);
+    ~AsyncLog() noexcept;
+
+    Status GetStatus(void) const noexcept override;
+};
+}  // namespace i_mqtt_client
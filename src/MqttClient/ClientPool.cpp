@@ -0,0 +1,552 @@
+/**
+ * @file ClientPool.cpp
+ * @author Timo Lange
+ * @brief Implementation of a pool of connections behind the IMqttClient interface
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "ClientPool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+ClientPool::Member::Member(ClientPool& clientPool, size_t memberIndex, IMqttClient::InitializeParameters const& params)
+  : pool(clientPool)
+  , index(memberIndex)
+  , clientId(params.clientId)
+{
+    /*the client must not format logs the pool does not log, also after the level of the pool was changed*/
+    FollowMinLogLevel(pool.logCb);
+    client = MqttClientFactory::Create(params, this, this, this, this);
+}
+
+void
+ClientPool::Member::Log(LogLevel lvl, string const& txt) const
+{
+    if (pool.logCb->IsLogged(lvl)) {
+        pool.logCb->Log(lvl, clientId + ": " + txt);
+    }
+}
+
+void
+ClientPool::Member::OnSubscribe(token_t token) const
+{
+    pool.complete(*this, token, false, [this](int poolToken) { pool.cmdCb->OnSubscribe(poolToken); });
+}
+
+void
+ClientPool::Member::OnUnSubscribe(token_t token) const
+{
+    pool.complete(*this, token, false, [this](int poolToken) { pool.cmdCb->OnUnSubscribe(poolToken); });
+}
+
+void
+ClientPool::Member::OnPublish(token_t token, Mqtt5ReasonCode rc) const
+{
+    pool.complete(*this, token, true, [this, rc](int poolToken) { pool.cmdCb->OnPublish(poolToken, rc); });
+}
+
+void
+ClientPool::Member::OnSubscribeResults(token_t token, vector<Mqtt5ReasonCode> const& rcs) const
+{
+    pool.complete(
+        *this, token, true, [this, rcs](int poolToken) { pool.cmdCb->OnSubscribeResults(poolToken, rcs); });
+}
+
+void
+ClientPool::Member::OnUnSubscribeResults(token_t token, vector<Mqtt5ReasonCode> const& rcs) const
+{
+    pool.complete(
+        *this, token, true, [this, rcs](int poolToken) { pool.cmdCb->OnUnSubscribeResults(poolToken, rcs); });
+}
+
+void
+ClientPool::Member::OnMqttMessage(upMqttMessage_t msg) const
+{
+    pool.msgCb->OnMqttMessage(move(msg));
+}
+
+void
+ClientPool::Member::OnConnectionStatusChanged(ConnectionType type, Mqtt5ReasonCode mqttRc) const
+{
+    pool.onMemberConnection(index, type, mqttRc);
+}
+
+ClientPool::ClientPool(InitializeParameters const&     params,
+                       unsigned                        connections,
+                       IMqttMessageCallbacks const*    msg,
+                       IMqttLogCallbacks const*        log,
+                       IMqttCommandCallbacks const*    cmd,
+                       IMqttConnectionCallbacks const* con)
+  : IMqttClient(log, cmd, msg, con)
+{
+    if (!connections) {
+        throw runtime_error("client pool needs at least one connection");
+    }
+    logCb->Log<LogLevel::INFO>([&] { return "Creating client pool with " + to_string(connections) + " connections"; });
+    for (size_t i{0U}; i < connections; i++) {
+        auto clientParams{params};
+        clientParams.clientId     = params.clientId + "-" + to_string(i);
+        clientParams.cleanSession = true;
+        clientParams.externalLoop = false; /*there is no loop driving the members*/
+        members.emplace_back(new Member(*this, i, clientParams));
+    }
+    libVersion = members.front()->client->GetLibVersion();
+}
+
+ClientPool::~ClientPool() noexcept
+{
+    /*members may report a disconnect while being destroyed*/
+    stopping = true;
+    vector<unique_ptr<Member>> stopped;
+    {
+        lock_guard<mutex> lock(poolMutex);
+        stopped = move(members);
+    }
+    /*destroyed unlocked, as it joins the threads of the members, which may be waiting for the lock*/
+    stopped.clear();
+}
+
+ClientPool::Member&
+ClientPool::publisher(string const& topic) const
+{
+    /*stick to the member of the topic while it is connected, in order to keep the order of the topic's messages*/
+    auto preferred{hash<string>()(topic) % members.size()};
+    for (size_t i{0U}; i < members.size(); i++) {
+        auto& member = *members[(preferred + i) % members.size()];
+        if (member.connected) {
+            return member;
+        }
+    }
+    return *members[preferred];
+}
+
+ReasonCode
+ClientPool::submit(Member& member, function<ReasonCode(int*)> const& func, int* token)
+{
+    {
+        lock_guard<mutex> lock(member.tokenMutex);
+        member.submitting++;
+    }
+    int  memberToken{-1};
+    auto status{func(&memberToken)};
+    /*tokens of different members overlap, so they are replaced by tokens of the pool, others are passed as they are*/
+    auto                          poolToken{memberToken};
+    vector<pair<bool, deliver_t>> early;
+    {
+        lock_guard<mutex> lock(member.tokenMutex);
+        member.submitting--;
+        if (ReasonCode::OKAY == status && memberToken > 0) {
+            poolToken = static_cast<int>(nextToken++ % 0x7FFFFFFFU) + 1;
+            auto stashed{member.earlyCompletions.find(memberToken)};
+            if (stashed != member.earlyCompletions.end()) {
+                early = move(stashed->second);
+                member.earlyCompletions.erase(stashed);
+            }
+            if (none_of(early.begin(), early.end(), [](pair<bool, deliver_t> const& c) { return c.first; })) {
+                member.tokens[memberToken] = poolToken;
+            }
+        }
+        if (!member.submitting) {
+            member.earlyCompletions.clear();
+        }
+    }
+    if (token) {
+        *token = poolToken;
+    }
+    for (auto const& completion : early) {
+        completion.second(poolToken);
+    }
+    return status;
+}
+
+void
+ClientPool::complete(Member const& member, int token, bool last, deliver_t const& deliver) const
+{
+    auto poolToken{token > 0 ? -1 : token};
+    {
+        lock_guard<mutex> lock(member.tokenMutex);
+        auto              mapped{member.tokens.find(token)};
+        if (mapped != member.tokens.end()) {
+            poolToken = mapped->second;
+            if (last) {
+                member.tokens.erase(mapped);
+            }
+        }
+        else if (member.submitting && token > 0) {
+            /*the completion overtook the submission*/
+            member.earlyCompletions[token].push_back(make_pair(last, deliver));
+            return;
+        }
+    }
+    deliver(poolToken);
+}
+
+void
+ClientPool::onMemberConnection(size_t index, IMqttConnectionCallbacks::ConnectionType type, Mqtt5ReasonCode mqttRc)
+{
+    if (stopping) {
+        return;
+    }
+    auto connected{IMqttConnectionCallbacks::ConnectionType::CONNECT == type && Mqtt5ReasonCode::SUCCESS == mqttRc};
+    auto wasConnected{false};
+    auto isConnected{false};
+    {
+        lock_guard<mutex> lock(poolMutex);
+        auto&             member = *members[index];
+        wasConnected             = IsConnected();
+        if (member.connected != connected) {
+            logCb->Log<LogLevel::INFO>([&] {
+                return "Pool connection " + member.clientId + (connected ? " connected" : " disconnected");
+            });
+            member.connected = connected;
+        }
+        if (!connected) {
+            /*completions of what was in flight on the lost connection may never come, late ones are reported as -1*/
+            lock_guard<mutex> tokenLock(member.tokenMutex);
+            member.tokens.clear();
+        }
+        if (!members[subscriber]->connected) {
+            for (size_t i{0U}; i < members.size(); i++) {
+                if (members[i]->connected) {
+                    moveSubscriptions(i);
+                    break;
+                }
+            }
+        }
+        isConnected = IsConnected();
+    }
+    /*the pool is connected as long as any member is, failed connects are reported while none is*/
+    auto failedConnect{IMqttConnectionCallbacks::ConnectionType::CONNECT == type && !connected};
+    if (connected ? !wasConnected : !isConnected && (wasConnected || failedConnect)) {
+        conCb->OnConnectionStatusChanged(type, mqttRc);
+    }
+}
+
+void
+ClientPool::moveSubscriptions(size_t to)
+{
+    auto from{subscriber};
+    subscriber = to;
+    if (from == to || subscriptions.empty()) {
+        return;
+    }
+    logCb->Log<LogLevel::INFO>([&] {
+        return "Moving " + to_string(subscriptions.size()) + " subscriptions from " + members[from]->clientId + " to " +
+               members[to]->clientId;
+    });
+    vector<string>            filters;
+    vector<TopicSubscription> plain;
+    for (auto const& subscription : subscriptions) {
+        filters.push_back(subscription.first);
+        if (subscription.second.handlers.empty()) {
+            plain.push_back(subscription.second.subscription);
+        }
+    }
+    /*the lost connection can not unsubscribe, but forgets about the subscriptions, so it does not restore them*/
+    (void)members[from]->client->UnSubscribeManyAsync(filters);
+    auto& client = *members[to]->client;
+    for (auto& subscription : subscriptions) {
+        auto const& topicSubscription = subscription.second.subscription;
+        for (auto& handler : subscription.second.handlers) {
+            (void)client.SubscribeAsync(topicSubscription.topic,
+                                        topicSubscription.qos,
+                                        handler.second.handler,
+                                        nullptr,
+                                        topicSubscription.getRetained,
+                                        &handler.second.memberId);
+        }
+    }
+    if (!plain.empty()) {
+        (void)client.SubscribeManyAsync(plain);
+    }
+}
+
+ReasonCode
+ClientPool::ConnectAsync(void)
+{
+    auto status{ReasonCode::OKAY};
+    /*not locked, connection callbacks may be invoked from within ConnectAsync*/
+    for (auto& member : members) {
+        auto rc{member->client->ConnectAsync()};
+        if (ReasonCode::OKAY != rc) {
+            logCb->Log<LogLevel::ERROR>([&] { return "Pool connection " + member->clientId + " failed to connect"; });
+            status = rc;
+        }
+    }
+    return status;
+}
+
+ReasonCode
+ClientPool::DisconnectAsync(Mqtt5ReasonCode rc)
+{
+    auto status{ReasonCode::OKAY};
+    for (auto& member : members) {
+        auto memberStatus{member->client->DisconnectAsync(rc)};
+        if (ReasonCode::OKAY != memberStatus) {
+            status = memberStatus;
+        }
+    }
+    return status;
+}
+
+ReasonCode
+ClientPool::SubscribeAsync(string const& topic, IMqttMessage::QOS qos, int* token, bool getRetained)
+{
+    TopicSubscription subscription;
+    subscription.topic       = topic;
+    subscription.qos         = qos;
+    subscription.getRetained = getRetained;
+    return SubscribeManyAsync(vector<TopicSubscription>{subscription}, token);
+}
+
+ReasonCode
+ClientPool::SubscribeAsync(string const&     topic,
+                           IMqttMessage::QOS qos,
+                           messageHandler_t  handler,
+                           int*              token,
+                           bool              getRetained,
+                           uint64_t*         handlerId)
+{
+    lock_guard<mutex> lock(poolMutex);
+    auto&             member = *members[subscriber];
+    uint64_t          memberId{0U};
+    auto              status{submit(
+        member,
+        [&](int* memberToken) {
+            return member.client->SubscribeAsync(topic, qos, handler, memberToken, getRetained, &memberId);
+        },
+        token)};
+    if (ReasonCode::OKAY == status) {
+        auto& subscription{subscriptions[topic]};
+        subscription.subscription.topic       = topic;
+        subscription.subscription.qos         = qos;
+        subscription.subscription.getRetained = getRetained;
+        /*ids of the members change when the subscriptions are moved, so the pool hands out its own*/
+        subscription.handlers[++nextHandlerId] = Handler{handler, memberId};
+        if (handlerId) {
+            *handlerId = nextHandlerId;
+        }
+    }
+    return status;
+}
+
+ReasonCode
+ClientPool::SubscribeManyAsync(vector<TopicSubscription> const& topicSubscriptions, int* token)
+{
+    lock_guard<mutex> lock(poolMutex);
+    auto&             member = *members[subscriber];
+    auto              status{submit(
+        member,
+        [&](int* memberToken) { return member.client->SubscribeManyAsync(topicSubscriptions, memberToken); },
+        token)};
+    if (ReasonCode::OKAY == status) {
+        for (auto const& subscription : topicSubscriptions) {
+            subscriptions[subscription.topic].subscription = subscription;
+        }
+    }
+    return status;
+}
+
+ReasonCode
+ClientPool::UnSubscribeAsync(string const& topic, int* token)
+{
+    return UnSubscribeManyAsync(vector<string>{topic}, token);
+}
+
+ReasonCode
+ClientPool::UnSubscribeAsync(string const& topic, uint64_t handlerId, int* token)
+{
+    lock_guard<mutex> lock(poolMutex);
+    auto              subscription{subscriptions.find(topic)};
+    if (subscription == subscriptions.end()) {
+        return ReasonCode::ERROR_GENERAL;
+    }
+    auto handler{subscription->second.handlers.find(handlerId)};
+    if (handler == subscription->second.handlers.end()) {
+        return ReasonCode::ERROR_GENERAL;
+    }
+    auto memberId{handler->second.memberId};
+    subscription->second.handlers.erase(handler);
+    if (subscription->second.handlers.empty()) {
+        subscriptions.erase(subscription);
+    }
+    auto& member = *members[subscriber];
+    return submit(
+        member,
+        [&](int* memberToken) { return member.client->UnSubscribeAsync(topic, memberId, memberToken); },
+        token);
+}
+
+ReasonCode
+ClientPool::UnSubscribeManyAsync(vector<string> const& topics, int* token)
+{
+    lock_guard<mutex> lock(poolMutex);
+    for (auto const& topic : topics) {
+        subscriptions.erase(topic);
+    }
+    auto& member = *members[subscriber];
+    return submit(
+        member, [&](int* memberToken) { return member.client->UnSubscribeManyAsync(topics, memberToken); }, token);
+}
+
+ReasonCode
+ClientPool::PublishAsync(upMqttMessage_t mqttMsg, int* token)
+{
+    auto& member = publisher(mqttMsg->topic);
+    return submit(
+        member, [&](int* memberToken) { return member.client->PublishAsync(move(mqttMsg), memberToken); }, token);
+}
+
+bool
+ClientPool::IsConnected(void) const noexcept
+{
+    return any_of(members.begin(), members.end(), [](unique_ptr<Member> const& member) -> bool {
+        return member->connected;
+    });
+}
+
+Mqtt5ReasonCode
+ClientPool::Publish(upMqttMessage_t mqttMsg, milliseconds timeout, ReasonCode* pRc)
+{
+    auto& member = publisher(mqttMsg->topic);
+    return member.client->Publish(move(mqttMsg), timeout, pRc);
+}
+
+Mqtt5ReasonCode
+ClientPool::Subscribe(
+    string const& topic, IMqttMessage::QOS qos, milliseconds timeout, ReasonCode* pRc, bool getRetained)
+{
+    IMqttClient* client{nullptr};
+    {
+        /*recorded upfront, in order to be moved along with the others while waiting*/
+        lock_guard<mutex> lock(poolMutex);
+        TopicSubscription subscription;
+        subscription.topic       = topic;
+        subscription.qos         = qos;
+        subscription.getRetained = getRetained;
+        subscriptions[topic].subscription = subscription;
+        client                            = members[subscriber]->client.get();
+    }
+    /*not locked while waiting, the connection callbacks of the member would be blocked*/
+    auto rc{ReasonCode::OKAY};
+    auto mqttRc{client->Subscribe(topic, qos, timeout, &rc, getRetained)};
+    if (ReasonCode::OKAY != rc || mqttRc >= Mqtt5ReasonCode::UNSPECIFIED_ERROR) {
+        lock_guard<mutex> lock(poolMutex);
+        auto              subscription{subscriptions.find(topic)};
+        if (subscription != subscriptions.end() && subscription->second.handlers.empty()) {
+            subscriptions.erase(subscription);
+        }
+    }
+    if (pRc) {
+        *pRc = rc;
+    }
+    return mqttRc;
+}
+
+IMqttClient::PublishRateLimiterStatus
+ClientPool::GetPublishRateLimiterStatus(void) const
+{
+    PublishRateLimiterStatus status;
+    for (auto const& member : members) {
+        auto memberStatus{member->client->GetPublishRateLimiterStatus()};
+        status.enabled = memberStatus.enabled;
+        status.globalTokens += memberStatus.globalTokens;
+        status.queued += memberStatus.queued;
+        status.passed += memberStatus.passed;
+        status.delayed += memberStatus.delayed;
+        status.rejected += memberStatus.rejected;
+        /*all members use the same topic filters*/
+        if (status.topicTokens.empty()) {
+            status.topicTokens = memberStatus.topicTokens;
+            continue;
+        }
+        for (size_t i{0U}; i < status.topicTokens.size() && i < memberStatus.topicTokens.size(); i++) {
+            status.topicTokens[i].second += memberStatus.topicTokens[i].second;
+        }
+    }
+    return status;
+}
+
+IMqttClient::PublishLatencySnapshot
+ClientPool::GetPublishLatency(IMqttMessage::QOS qos) const
+{
+    PublishLatencySnapshot snapshot;
+    for (auto const& member : members) {
+        auto memberSnapshot{member->client->GetPublishLatency(qos)};
+        snapshot.inFlight += memberSnapshot.inFlight;
+        if (!memberSnapshot.completed) {
+            continue;
+        }
+        if (!snapshot.completed) {
+            snapshot.min = memberSnapshot.min;
+        }
+        auto completed{snapshot.completed + memberSnapshot.completed};
+        snapshot.min  = min(snapshot.min, memberSnapshot.min);
+        snapshot.max  = max(snapshot.max, memberSnapshot.max);
+        snapshot.mean = microseconds(static_cast<microseconds::rep>(
+            (static_cast<double>(snapshot.mean.count()) * snapshot.completed +
+             static_cast<double>(memberSnapshot.mean.count()) * memberSnapshot.completed) /
+            completed));
+        /*histograms of the members are not available, the percentiles are an upper bound*/
+        snapshot.p50       = max(snapshot.p50, memberSnapshot.p50);
+        snapshot.p90       = max(snapshot.p90, memberSnapshot.p90);
+        snapshot.p99       = max(snapshot.p99, memberSnapshot.p99);
+        snapshot.p999      = max(snapshot.p999, memberSnapshot.p999);
+        snapshot.completed = completed;
+    }
+    return snapshot;
+}
+
+IMqttClient::SubscriptionRestoreStatus
+ClientPool::GetSubscriptionRestoreStatus(void) const
+{
+    SubscriptionRestoreStatus status;
+    for (auto const& member : members) {
+        auto memberStatus{member->client->GetSubscriptionRestoreStatus()};
+        status.subscriptions += memberStatus.subscriptions;
+        status.restores += memberStatus.restores;
+        status.skipped += memberStatus.skipped;
+        status.pending += memberStatus.pending;
+        status.restoredFilters += memberStatus.restoredFilters;
+        status.failedFilters += memberStatus.failedFilters;
+        status.lastGap = max(status.lastGap, memberStatus.lastGap);
+        status.estimatedMissedMessages += memberStatus.estimatedMissedMessages;
+    }
+    return status;
+}
+
+IMqttExternalLoop*
+ClientPool::GetExternalLoop(void) noexcept
+{
+    return nullptr;
+}
+
+unique_ptr<IMqttClient>
+MqttClientPoolFactory::Create(IMqttClient::InitializeParameters const& params,
+                              unsigned                                 connections,
+                              IMqttMessageCallbacks const*             msg,
+                              IMqttLogCallbacks const*                 log,
+                              IMqttCommandCallbacks const*             cmd,
+                              IMqttConnectionCallbacks const*          con)
+{
+    return unique_ptr<IMqttClient>(new ClientPool(params, connections, msg, log, cmd, con));
+}
+}  // namespace i_mqtt_client
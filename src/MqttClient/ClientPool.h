@@ -0,0 +1,132 @@
+/**
+ * @file ClientPool.h
+ * @author Timo Lange
+ * @brief Class definition for a pool of connections behind the IMqttClient interface
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "IMqttClientPool.h"
+
+namespace i_mqtt_client {
+class ClientPool final : public IMqttClient {
+private:
+    using deliver_t = std::function<void(int token)>;
+
+    class Member final
+      : public IMqttLogCallbacks
+      , public IMqttCommandCallbacks
+      , public IMqttMessageCallbacks
+      , public IMqttConnectionCallbacks {
+    private:
+        ClientPool& pool;
+
+        void Log(LogLevel, std::string const&) const override;
+        void OnSubscribe(token_t) const override;
+        void OnUnSubscribe(token_t) const override;
+        void OnPublish(token_t, Mqtt5ReasonCode) const override;
+        void OnSubscribeResults(token_t, std::vector<Mqtt5ReasonCode> const&) const override;
+        void OnUnSubscribeResults(token_t, std::vector<Mqtt5ReasonCode> const&) const override;
+        void OnMqttMessage(upMqttMessage_t) const override;
+        void OnConnectionStatusChanged(ConnectionType, Mqtt5ReasonCode) const override;
+
+    public:
+        size_t const      index;
+        std::string const clientId;
+        std::atomic_bool  connected{false};
+        /*member tokens to pool tokens, completions may overtake the submission, see ClientPool::submit*/
+        mutable std::mutex                   tokenMutex;
+        mutable std::unordered_map<int, int> tokens;
+        /*completions of tokens not known yet, true if the completion is the last one of the token*/
+        mutable std::unordered_map<int, std::vector<std::pair<bool, deliver_t>>> earlyCompletions;
+        mutable unsigned                                                          submitting{0U};
+        /*created last, as it may invoke callbacks right away*/
+        std::unique_ptr<IMqttClient> client;
+
+        Member(ClientPool&, size_t, IMqttClient::InitializeParameters const&);
+    };
+
+    struct Handler final {
+        messageHandler_t handler;
+        std::uint64_t    memberId; /*id of the handler at the member holding the subscriptions*/
+    };
+
+    struct Subscription final {
+        TopicSubscription subscription;
+        /*by pool handler id, empty for messages handed over to IMqttMessageCallbacks*/
+        std::map<std::uint64_t, Handler> handlers;
+    };
+
+    std::atomic<std::uint32_t>           nextToken{0U};
+    std::uint64_t                        nextHandlerId{0U};
+    std::atomic_bool                     stopping{false};
+    mutable std::mutex                   poolMutex;
+    std::map<std::string, Subscription>  subscriptions;
+    size_t                               subscriber{0U}; /*index of the member holding all subscriptions*/
+    std::vector<std::unique_ptr<Member>> members;
+
+    Member&    publisher(std::string const& topic) const;
+    ReasonCode submit(Member&, std::function<ReasonCode(int*)> const&, int* token);
+    void       complete(Member const&, int token, bool last, deliver_t const&) const;
+    void       onMemberConnection(size_t, IMqttConnectionCallbacks::ConnectionType, Mqtt5ReasonCode);
+    void       moveSubscriptions(size_t to);
+
+    ReasonCode                ConnectAsync(void) override;
+    ReasonCode                DisconnectAsync(Mqtt5ReasonCode) override;
+    ReasonCode                SubscribeAsync(std::string const&, IMqttMessage::QOS, int*, bool) override;
+    ReasonCode                SubscribeAsync(std::string const&,
+                                             IMqttMessage::QOS,
+                                             messageHandler_t,
+                                             int*,
+                                             bool,
+                                             std::uint64_t*) override;
+    ReasonCode                SubscribeManyAsync(std::vector<TopicSubscription> const&, int*) override;
+    ReasonCode                UnSubscribeAsync(std::string const&, int*) override;
+    ReasonCode                UnSubscribeAsync(std::string const&, std::uint64_t, int*) override;
+    ReasonCode                UnSubscribeManyAsync(std::vector<std::string> const&, int*) override;
+    ReasonCode                PublishAsync(upMqttMessage_t, int*) override;
+    bool                      IsConnected(void) const noexcept override;
+    Mqtt5ReasonCode           Publish(upMqttMessage_t, std::chrono::milliseconds, ReasonCode*) override;
+    Mqtt5ReasonCode           Subscribe(std::string const&,
+                                        IMqttMessage::QOS,
+                                        std::chrono::milliseconds,
+                                        ReasonCode*,
+                                        bool) override;
+    PublishRateLimiterStatus  GetPublishRateLimiterStatus(void) const override;
+    PublishLatencySnapshot    GetPublishLatency(IMqttMessage::QOS) const override;
+    SubscriptionRestoreStatus GetSubscriptionRestoreStatus(void) const override;
+    IMqttExternalLoop*        GetExternalLoop(void) noexcept override;
+
+public:
+    ClientPool(InitializeParameters const&,
+               unsigned,
+               IMqttMessageCallbacks const*,
+               IMqttLogCallbacks const*,
+               IMqttCommandCallbacks const*,
+               IMqttConnectionCallbacks const*);
+    virtual ~ClientPool() noexcept;
+};
+}  // namespace i_mqtt_client
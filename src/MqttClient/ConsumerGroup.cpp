@@ -0,0 +1,257 @@
+/**
+ * @file ConsumerGroup.cpp
+ * @author Timo Lange
+ * @brief Implementation of a group of MQTT clients consuming shared subscriptions
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "ConsumerGroup.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+static seconds const rateWindow{1};
+
+ConsumerGroup::Member::Member(ConsumerGroup&                           consumerGroup,
+                              size_t                                   memberIndex,
+                              IMqttClient::InitializeParameters const& clientParams)
+  : group(consumerGroup)
+  , index(memberIndex)
+  , clientId(clientParams.clientId)
+  , windowStart(clock_t::now().time_since_epoch().count())
+  , client(MqttClientFactory::Create(clientParams, this, consumerGroup.logCb, nullptr, this))
+{
+}
+
+void
+ConsumerGroup::Member::OnMqttMessage(upMqttMessage_t msg) const
+{
+    auto count{messages.fetch_add(1U, memory_order_relaxed) + 1U};
+    auto now{clock_t::now()};
+    auto start{clock_t::time_point(clock_t::duration(windowStart.load(memory_order_relaxed)))};
+    if (now - start >= rateWindow) {
+        auto elapsed{duration_cast<duration<double>>(now - start).count()};
+        windowRate.store(static_cast<double>(count - windowMessages.load(memory_order_relaxed)) / elapsed,
+                         memory_order_relaxed);
+        windowMessages.store(count, memory_order_relaxed);
+        windowStart.store(now.time_since_epoch().count(), memory_order_relaxed);
+    }
+    group.msgCb.OnMqttMessage(move(msg));
+}
+
+void
+ConsumerGroup::Member::OnConnectionStatusChanged(ConnectionType type, Mqtt5ReasonCode mqttRc) const
+{
+    group.onMemberConnection(index, ConnectionType::CONNECT == type && Mqtt5ReasonCode::SUCCESS == mqttRc);
+}
+
+ConsumerGroup::ConsumerGroup(Parameters const&            parameters,
+                             IMqttMessageCallbacks const& msg,
+                             IMqttLogCallbacks const*     log)
+  : params(parameters)
+  , msgCb(msg)
+  , logCb(log)
+{
+    if (params.group.empty() || params.group.find_first_of("/+#") != string::npos) {
+        throw runtime_error("consumer group name must not be empty or contain '/', '+' or '#'");
+    }
+    if (!params.members || params.subscriptions.empty()) {
+        throw runtime_error("consumer group needs at least one member and one subscription");
+    }
+    for (size_t i{0U}; i < params.members; i++) {
+        auto clientParams{params.clientParameters};
+        clientParams.clientId             = params.clientParameters.clientId + "-" + to_string(i);
+        clientParams.cleanSession         = true;
+        clientParams.restoreSubscriptions = false; /*subscriptions are reassigned by the group on every connect*/
+        clientParams.externalLoop = false; /*there is no loop driving the members*/
+        members.emplace_back(new Member(*this, i, clientParams));
+    }
+}
+
+ConsumerGroup::~ConsumerGroup() noexcept
+{
+    /*members may report a disconnect while being destroyed*/
+    stopping = true;
+    lock_guard<mutex> lock(groupMutex);
+    members.clear();
+}
+
+void
+ConsumerGroup::onMemberConnection(size_t index, bool connected)
+{
+    if (stopping) {
+        return;
+    }
+    lock_guard<mutex> lock(groupMutex);
+    auto& member = *members[index];
+    if (member.connected == connected) {
+        return;
+    }
+    log<LogLevel::INFO>([&] {
+        return "Consumer group member " + member.clientId + (connected ? " connected" : " disconnected");
+    });
+    member.connected = connected;
+    if (!connected) {
+        /*with a clean session, subscriptions do not survive the connection*/
+        member.subscriptions.clear();
+    }
+    /*while stopping, the filters of a disconnected member must not move to the ones still connected*/
+    if (running) {
+        rebalance();
+    }
+}
+
+void
+ConsumerGroup::rebalance(void)
+{
+    vector<Member*> live;
+    for (auto& member : members) {
+        if (member->connected) {
+            live.push_back(member.get());
+        }
+    }
+    vector<set<size_t>> assignment(members.size());
+    if (!live.empty()) {
+        auto perFilter{params.membersPerFilter && params.membersPerFilter < live.size() ? params.membersPerFilter
+                                                                                       : live.size()};
+        /*round robin, such that filters are spread evenly and stay with their members as long as possible*/
+        for (size_t filter{0U}; filter < params.subscriptions.size(); filter++) {
+            for (size_t i{0U}; i < perFilter; i++) {
+                assignment[live[(filter + i) % live.size()]->index].insert(filter);
+            }
+        }
+    }
+
+    for (auto member : live) {
+        auto const&    assigned = assignment[member->index];
+        vector<size_t> added;
+        vector<size_t> removed;
+        set_difference(assigned.begin(),
+                       assigned.end(),
+                       member->subscriptions.begin(),
+                       member->subscriptions.end(),
+                       back_inserter(added));
+        set_difference(member->subscriptions.begin(),
+                       member->subscriptions.end(),
+                       assigned.begin(),
+                       assigned.end(),
+                       back_inserter(removed));
+        if (!added.empty()) {
+            vector<IMqttClient::TopicSubscription> subscriptions;
+            for (auto filter : added) {
+                auto subscription{params.subscriptions[filter]};
+                subscription.topic = "$share/" + params.group + "/" + subscription.topic;
+                subscriptions.push_back(subscription);
+            }
+            if (ReasonCode::OKAY != member->client->SubscribeManyAsync(subscriptions)) {
+                log<LogLevel::ERROR>([&] {
+                    return "Consumer group member " + member->clientId + " failed to subscribe";
+                });
+                continue;
+            }
+        }
+        if (!removed.empty()) {
+            vector<string> topics;
+            for (auto filter : removed) {
+                topics.push_back("$share/" + params.group + "/" + params.subscriptions[filter].topic);
+            }
+            if (ReasonCode::OKAY != member->client->UnSubscribeManyAsync(topics)) {
+                log<LogLevel::ERROR>([&] {
+                    return "Consumer group member " + member->clientId + " failed to unsubscribe";
+                });
+            }
+        }
+        member->subscriptions = assigned;
+    }
+}
+
+ReasonCode
+ConsumerGroup::Start(void)
+{
+    log<LogLevel::INFO>([&] {
+        return "Starting consumer group " + params.group + " with " + to_string(members.size()) + " members";
+    });
+    auto status{ReasonCode::OKAY};
+    {
+        lock_guard<mutex> lock(groupMutex);
+        running = true;
+    }
+    /*not locked, connection callbacks may be invoked from within ConnectAsync*/
+    for (auto& member : members) {
+        auto rc{member->client->ConnectAsync()};
+        if (ReasonCode::OKAY != rc) {
+            log<LogLevel::ERROR>([&] { return "Consumer group member " + member->clientId + " failed to connect"; });
+            status = rc;
+        }
+    }
+    return status;
+}
+
+void
+ConsumerGroup::Stop(void)
+{
+    log<LogLevel::INFO>([&] { return "Stopping consumer group " + params.group; });
+    {
+        lock_guard<mutex> lock(groupMutex);
+        running = false;
+    }
+    for (auto& member : members) {
+        (void)member->client->DisconnectAsync(Mqtt5ReasonCode::SUCCESS);
+    }
+}
+
+vector<IMqttConsumerGroup::MemberStatus>
+ConsumerGroup::GetStatus(void) const
+{
+    vector<MemberStatus> status;
+    auto                 now{clock_t::now()};
+    lock_guard<mutex>    lock(groupMutex);
+    for (auto const& member : members) {
+        MemberStatus memberStatus;
+        memberStatus.clientId  = member->clientId;
+        memberStatus.connected = member->connected;
+        memberStatus.messages  = member->messages.load(memory_order_relaxed);
+        for (auto filter : member->subscriptions) {
+            memberStatus.topics.push_back(params.subscriptions[filter].topic);
+        }
+        /*a window not completed for longer than its length means, no message was received since*/
+        auto start{clock_t::time_point(clock_t::duration(member->windowStart.load(memory_order_relaxed)))};
+        if (now - start >= rateWindow) {
+            auto received{memberStatus.messages - member->windowMessages.load(memory_order_relaxed)};
+            memberStatus.messagesPerSecond =
+                static_cast<double>(received) / duration_cast<duration<double>>(now - start).count();
+        }
+        else {
+            memberStatus.messagesPerSecond = member->windowRate.load(memory_order_relaxed);
+        }
+        status.push_back(memberStatus);
+    }
+    return status;
+}
+
+unique_ptr<IMqttConsumerGroup>
+MqttConsumerGroupFactory::Create(IMqttConsumerGroup::Parameters const& params,
+                                 IMqttMessageCallbacks const&          msg,
+                                 IMqttLogCallbacks const*              log)
+{
+    return unique_ptr<IMqttConsumerGroup>(new ConsumerGroup(params, msg, log));
+}
+}  // namespace i_mqtt_client
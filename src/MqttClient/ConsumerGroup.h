@@ -0,0 +1,93 @@
+/**
+ * @file ConsumerGroup.h
+ * @author Timo Lange
+ * @brief Class definition for a group of MQTT clients consuming shared subscriptions
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "IMqttConsumerGroup.h"
+
+namespace i_mqtt_client {
+class ConsumerGroup final : public IMqttConsumerGroup {
+private:
+    using clock_t = std::chrono::steady_clock;
+
+    class Member final
+      : public IMqttMessageCallbacks
+      , public IMqttConnectionCallbacks {
+    private:
+        ConsumerGroup& group;
+
+        void OnMqttMessage(upMqttMessage_t) const override;
+        void OnConnectionStatusChanged(ConnectionType, Mqtt5ReasonCode) const override;
+
+    public:
+        size_t const                       index;
+        std::string const                  clientId;
+        mutable std::atomic<std::uint64_t> messages{0U};
+        /*receive rate window, only written by the message callback of the member*/
+        mutable std::atomic<clock_t::rep>  windowStart;
+        mutable std::atomic<std::uint64_t> windowMessages{0U};
+        mutable std::atomic<double>        windowRate{0.0};
+        /*guarded by groupMutex*/
+        bool             connected{false};
+        std::set<size_t> subscriptions;
+        /*created last, as it may invoke callbacks right away*/
+        std::unique_ptr<IMqttClient> client;
+
+        Member(ConsumerGroup&, size_t, IMqttClient::InitializeParameters const&);
+    };
+
+    Parameters const                     params;
+    IMqttMessageCallbacks const&         msgCb;
+    IMqttLogCallbacks const*             logCb;
+    std::atomic_bool                     stopping{false};
+    mutable std::mutex                   groupMutex;
+    /*guarded by groupMutex, members are not rebalanced between Stop and Start*/
+    bool running{false};
+    std::vector<std::unique_ptr<Member>> members;
+
+    void onMemberConnection(size_t, bool);
+    void rebalance(void);
+
+    template <LogLevel lvl, class Formatter>
+    void
+    log(Formatter const& formatter) const
+    {
+        if (logCb) {
+            logCb->Log<lvl>(formatter);
+        }
+    }
+
+    ReasonCode                Start(void) override;
+    void                      Stop(void) override;
+    std::vector<MemberStatus> GetStatus(void) const override;
+
+public:
+    ConsumerGroup(Parameters const&, IMqttMessageCallbacks const&, IMqttLogCallbacks const*);
+    virtual ~ConsumerGroup() noexcept;
+};
+}  // namespace i_mqtt_client
@@ -20,12 +20,19 @@
 
 #include "DispatchQueue.h"
 
+#include "IMqttMetrics.h"
+#include "IMqttTracer.h"
+
 using namespace std;
+using namespace std::chrono;
 
 namespace i_mqtt_client {
-DispatchQueue::DispatchQueue(IMqttLogCallbacks const* log, IMqttMessageCallbacks const& msg)
+DispatchQueue::DispatchQueue(IMqttLogCallbacks const*     log,
+                             IMqttMessageCallbacks const& msg,
+                             shared_ptr<IMqttMetrics>     metricsRegistry)
   : logCb(log)
   , msgCb(msg)
+  , metrics(move(metricsRegistry))
   , messageDispatcherThread(&DispatchQueue::messageDispatcherWorker, this)
 {
 }
@@ -41,7 +48,10 @@ DispatchQueue::~DispatchQueue() noexcept
         lock_guard<mutex> lock(messageDispatcherMutex);
         auto              num{messageDispatcherQueue.size()};
         if (num) {
-            log(LogLevel::WARNING, "Lost " + to_string(num) + " MQTT messages in queue on shutdown");
+            log<LogLevel::WARNING>([&] { return "Lost " + to_string(num) + " MQTT messages in queue on shutdown"; });
+            if (metrics) {
+                metrics->DispatchQueueChanged(-static_cast<int64_t>(num));
+            }
         }
     }
 }
@@ -52,7 +62,13 @@ DispatchQueue::OnMqttMessage(upMqttMessage_t msg) const
     if (!messageDispatcherExit) {
         {
             lock_guard<mutex> lock(messageDispatcherMutex);
+            if (msg->trace) {
+                msg->trace->enqueued = IMqttMessage::Trace::clock_t::now();
+            }
             messageDispatcherQueue.push(move(msg));
+            if (metrics) {
+                metrics->DispatchQueueChanged(1);
+            }
         }
         messageDispatcherAwaiter.notify_one();
     }
@@ -62,36 +78,64 @@ DispatchQueue::OnMqttMessage(upMqttMessage_t msg) const
 void
 DispatchQueue::messageDispatcherWorker(void)
 {
-    log(LogLevel::DEBUG, "Starting MQTT message dispatcher");
+    log<LogLevel::DEBUG>([] { return "Starting MQTT message dispatcher"; });
     unique_lock<mutex> lock(messageDispatcherMutex);
     while (!messageDispatcherExit) {
-        log(LogLevel::DEBUG,
-            "Number of MQTT messages still to be processed: " + to_string(messageDispatcherQueue.size()));
+        if (logCb) {
+            logCb->Log<LogLevel::DEBUG>([this] {
+                return "Number of MQTT messages still to be processed: " + to_string(messageDispatcherQueue.size());
+            });
+        }
         messageDispatcherAwaiter.wait(lock,
                                       [this] { return (messageDispatcherQueue.size() || messageDispatcherExit); });
         if (!messageDispatcherExit && messageDispatcherQueue.size()) {
             auto msg{move(messageDispatcherQueue.front())};
             messageDispatcherQueue.pop();
+            if (metrics) {
+                metrics->DispatchQueueChanged(-1);
+            }
+            if (msg->trace) {
+                msg->trace->dequeued = IMqttMessage::Trace::clock_t::now();
+            }
             lock.unlock();
-            msgCb.OnMqttMessage(move(msg));
+            if (!metrics && !msg->trace) {
+                msgCb.OnMqttMessage(move(msg));
+            }
+            else {
+                deliver(move(msg));
+            }
             lock.lock();
         }
     }
-    log(LogLevel::INFO, "Exiting MQTT message dispatcher");
+    log<LogLevel::INFO>([] { return "Exiting MQTT message dispatcher"; });
 }
 
 void
-DispatchQueue::log(LogLevel lvl, std::string const& txt) const
+DispatchQueue::deliver(upMqttMessage_t msg) const
 {
-    if (logCb) {
-        logCb->Log(lvl, txt);
+    auto trace{msg->trace};
+    auto start{steady_clock::now()};
+    msgCb.OnMqttMessage(move(msg));
+    auto end{steady_clock::now()};
+    if (metrics) {
+        metrics->CallbackDuration(IMqttMetrics::Callback::DISPATCH, duration_cast<microseconds>(end - start));
+    }
+    if (trace) {
+        trace->handlerStart = start;
+        trace->handlerEnd   = end;
+        auto tracer{trace->tracer.lock()};
+        if (tracer) {
+            tracer->Complete(*trace);
+        }
     }
 }
 
 unique_ptr<IDispatchQueue>
-DispatchQueueFactory::Create(IMqttLogCallbacks const* log, IMqttMessageCallbacks const& msg)
+DispatchQueueFactory::Create(IMqttLogCallbacks const*     log,
+                             IMqttMessageCallbacks const& msg,
+                             shared_ptr<IMqttMetrics>     metrics)
 {
-    return unique_ptr<IDispatchQueue>(new DispatchQueue(log, msg));
+    return unique_ptr<IDispatchQueue>(new DispatchQueue(log, msg, move(metrics)));
 }
 
 }  // namespace i_mqtt_client
\ No newline at end of file
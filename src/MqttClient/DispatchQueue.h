@@ -22,6 +22,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <queue>
 #include <thread>
 
@@ -33,19 +34,30 @@ class DispatchQueue : public IDispatchQueue {
 private:
     IMqttLogCallbacks const*            logCb;
     IMqttMessageCallbacks const&        msgCb;
+    std::shared_ptr<IMqttMetrics> const metrics;
     mutable std::mutex                  messageDispatcherMutex;
     mutable std::queue<upMqttMessage_t> messageDispatcherQueue;
     mutable std::condition_variable     messageDispatcherAwaiter;
-    std::thread                         messageDispatcherThread;
+    /*has to be initialized before the worker thread starts reading it*/
     std::atomic_bool                    messageDispatcherExit{false};
+    std::thread                         messageDispatcherThread;
 
     void messageDispatcherWorker(void);
-    void log(LogLevel, std::string const&) const;
+    void deliver(upMqttMessage_t) const;
+
+    template <LogLevel lvl, class Formatter>
+    void
+    log(Formatter const& formatter) const
+    {
+        if (logCb) {
+            logCb->Log<lvl>(formatter);
+        }
+    }
 
     virtual void OnMqttMessage(upMqttMessage_t) const override;
 
 public:
-    DispatchQueue(IMqttLogCallbacks const*, IMqttMessageCallbacks const&);
+    DispatchQueue(IMqttLogCallbacks const*, IMqttMessageCallbacks const&, std::shared_ptr<IMqttMetrics>);
     virtual ~DispatchQueue() noexcept;
 };
 }  // namespace i_mqtt_client
@@ -26,14 +26,14 @@
 using namespace std;
 
 namespace i_mqtt_client {
-string IMqttClient::libVersion{"UNKNOWN"};
-
 static const map<ReasonCode, ReasonCodeRepr_t> reasonCodeToString{
     {ReasonCode::OKAY, {"OKAY", "The operation was successful"}},
     {ReasonCode::ERROR_GENERAL, {"ERROR_GENERAL", "A general error occured"}},
     {ReasonCode::ERROR_NO_CONNECTION, {"ERROR_NO_CONNECTION", "No connection to the broker"}},
     {ReasonCode::ERROR_TLS, {"ERROR_TLS", "A TLS error occured"}},
-    {ReasonCode::NOT_ALLOWED, {"NOT_ALLOWED", "The broker refused the connection"}}};
+    {ReasonCode::NOT_ALLOWED, {"NOT_ALLOWED", "The broker refused the connection"}},
+    {ReasonCode::ERROR_RATE_LIMITED, {"ERROR_RATE_LIMITED", "The publish rate limit was exceeded"}},
+    {ReasonCode::ERROR_TIMEOUT, {"ERROR_TIMEOUT", "The operation did not finish in time"}}};
 
 ReasonCodeRepr_t
 IMqttClient::ReasonCodeToStringRepr(ReasonCode rc)
@@ -192,6 +192,8 @@ IMqttClient::IMqttClient(IMqttLogCallbacks const*        log,
   , msgCb(this)
   , conCb(this)
 {
+    /*used as log callback, if the user has none, which drops all logs*/
+    DisableLogs();
     SetCallbacks(log);
     SetCallbacks(cmd);
     SetCallbacks(msg);
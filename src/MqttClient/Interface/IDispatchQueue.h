@@ -25,6 +25,8 @@
 #include "IMqttClientCallbacks.h"
 
 namespace i_mqtt_client {
+class IMqttMetrics;
+
 /**
  * @brief MQTT library implementations usually rely on callbacks, that are invoked by the MQTT library to handover the
  * MQTT message to the user. These callbacks usually have to be done very quick in order to not block the MQTT library
@@ -64,9 +66,13 @@ public:
      *
      * @param log reference to an object providing a log callback
      * @param msg reference to an object providig a message callback in order to deliver messages to the user
+     * @param metrics optionally records the queue depth and the durations of the message callback, see
+     * IMqttMetrics.h
      * @return unique pointer to a DispatchQueue hidden behind an IDispatchQueue interface
      */
-    static std::unique_ptr<IDispatchQueue> Create(IMqttLogCallbacks const* log, IMqttMessageCallbacks const& msg);
+    static std::unique_ptr<IDispatchQueue> Create(IMqttLogCallbacks const*      log,
+                                                  IMqttMessageCallbacks const&  msg,
+                                                  std::shared_ptr<IMqttMetrics> metrics = nullptr);
     DispatchQueueFactory() = delete;
 };
 }  // namespace i_mqtt_client
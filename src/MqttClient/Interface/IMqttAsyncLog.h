@@ -0,0 +1,110 @@
+/**
+ * @file IMqttAsyncLog.h
+ * @author Timo Lange
+ * @brief Interface definition for an asynchronous log sink
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "IMqttClientCallbacks.h"
+
+namespace i_mqtt_client {
+/**
+ * @brief Decouples logging from the threads of the clients and of the MQTT libraries. Used as IMqttLogCallbacks of the
+ * clients (and via LogLib for the MQTT library logs, see IMqttLogCallbacks::InitLogMqttLib), it copies each log into a
+ * preallocated ring of fixed size records without locking and returns. A background thread hands the logs over to the
+ * actual log callbacks, in order. If the ring is full, logs are dropped and counted instead of blocking the caller.
+ * Texts longer than Parameters::textLength are truncated. The sink shares the level set via SetMinLogLevel with the log
+ * callbacks it wraps, so filtered logs are neither formatted nor queued.
+ */
+class IMqttAsyncLog : public IMqttLogCallbacks {
+protected:
+    IMqttAsyncLog(void) = default;
+
+public:
+    IMqttAsyncLog(const IMqttAsyncLog&) = delete;
+    IMqttAsyncLog(IMqttAsyncLog&&)      = delete;
+    IMqttAsyncLog& operator=(const IMqttAsyncLog&) = delete;
+    IMqttAsyncLog& operator=(IMqttAsyncLog&&) = delete;
+    void*          operator new[](size_t)     = delete;
+
+    virtual ~IMqttAsyncLog() noexcept = default;
+
+    /**
+     * @brief Parameters of an asynchronous log sink.
+     *
+     */
+    struct Parameters final {
+        size_t records{4096U};   /*!< number of records in the ring, rounded up to a power of two */
+        size_t textLength{256U}; /*!< maximum length of a log text, longer texts are truncated */
+    };
+
+    /**
+     * @brief State of the log sink.
+     *
+     */
+    struct Status final {
+        std::uint64_t logged{0U};     /*!< logs handed over to the log callbacks */
+        std::uint64_t dropped{0U};    /*!< logs dropped, as the ring was full */
+        std::uint64_t droppedLib{0U}; /*!< logs of the MQTT libraries dropped, as the ring was full */
+        std::uint64_t truncated{0U};  /*!< logs with a truncated text */
+    };
+
+    /**
+     * @brief Queues a log of the MQTT library, to be handed over to the MmqttLibLogCb_t the sink was created with.
+     * Bind it to the callback of IMqttLogCallbacks::InitLogMqttLib.
+     *
+     * @param lvl the log level of the message
+     * @param txt the message text
+     */
+    virtual void LogLib(LogLevelLib lvl, std::string const& txt) const = 0;
+
+    /**
+     * @brief Returns the state of the log sink.
+     *
+     * @return snapshot of the counters
+     */
+    virtual Status GetStatus(void) const noexcept = 0;
+};
+
+/**
+ * @brief Used to instantiate an AsyncLog object behind an IMqttAsyncLog interface.
+ *
+ */
+class MqttAsyncLogFactory final {
+public:
+    /**
+     * @brief Generates an AsyncLog object behind an IMqttAsyncLog interface. The user is responsible for object
+     * lifetime management, it has to outlive all clients using it. Logs still queued on destruction are handed over
+     * before it returns.
+     *
+     * @param log pointer to an object providing the log callback, invoked from the thread of the sink, the sink starts
+     * with its minimum log level and forwards changes of its own level to it
+     * @param libLog callback for logs of the MQTT library, invoked from the thread of the sink, may be nullptr
+     * @param params parameters of the sink
+     * @return unique pointer to an AsyncLog object hidden by an abstract IMqttAsyncLog interface
+     */
+    static std::unique_ptr<IMqttAsyncLog> Create(IMqttLogCallbacks*               log,
+                                                 MmqttLibLogCb_t                  libLog = nullptr,
+                                                 IMqttAsyncLog::Parameters const& params = IMqttAsyncLog::Parameters());
+    MqttAsyncLogFactory() = delete;
+};
+}  // namespace i_mqtt_client
@@ -20,13 +20,23 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <random>
 #include <string>
+#include <vector>
 
 #include "IMqttClientCallbacks.h"
 
 namespace i_mqtt_client {
+class IMqttExternalLoop;
+class IMqttMetrics;
+class IMqttTlsContext;
+class IMqttTracer;
+class IReconnectScheduler;
+
 /**
  * @brief Describes the abstract interface to be used in order to use the IMqttClient implementation. It hides the
  * underlying MQTT library.
@@ -37,11 +47,11 @@ private:
     // TODO: Return bool in order to indicate accept / reject message?
     virtual void OnMqttMessage(upMqttMessage_t) const override
     {
-        logCb->Log(LogLevel::WARNING, "Got MQTT message, but no handler installed");
+        logCb->Log<LogLevel::WARNING>([] { return "Got MQTT message, but no handler installed"; });
     }
 
 protected:
-    static std::string              libVersion;
+    std::string                     libVersion{"UNKNOWN"};
     std::default_random_engine      rndGenerator{std::random_device()()};
     IMqttLogCallbacks const*        logCb;
     IMqttCommandCallbacks const*    cmdCb;
@@ -61,6 +71,159 @@ public:
 
     virtual ~IMqttClient() noexcept = default;
 
+    /**
+     * @brief Handler for messages matching the topic filter it was subscribed with, see SubscribeAsync.
+     *
+     */
+    using messageHandler_t = std::function<void(IMqttMessage const&)>;
+
+    /**
+     * @brief Behaviour of the publish rate limiter, once no token is available for a message.
+     *
+     */
+    enum class RateLimitMode {
+        REJECT, /*!< PublishAsync returns ReasonCode::ERROR_RATE_LIMITED immediately */
+        DELAY,  /*!< PublishAsync blocks the caller until a token is available */
+        QUEUE /*!< the message is queued and published in the background once a token is available and the client is
+                 connected, PublishAsync returns immediately. The token of a queued message is not known to the caller,
+                 so IMqttCommandCallbacks::OnPublish can not be correlated with the PublishAsync call */
+    };
+
+    /**
+     * @brief Parameters of a single token bucket.
+     *
+     */
+    struct TokenBucketParameters final {
+        double   rate{0.0}; /*!< number of publishes per second refilled into the bucket, 0 disables the bucket */
+        unsigned burst{1U}; /*!< maximum number of tokens the bucket can hold, i.e. the maximum burst size */
+    };
+
+    /**
+     * @brief Token bucket applied to all publishes with a topic matching topicFilter.
+     *
+     */
+    struct TopicRateLimit final {
+        std::string           topicFilter{""}; /*!< MQTT topic filter, wildcards '+' and '#' are allowed */
+        TokenBucketParameters bucket;          /*!< the limit applied to matching topics */
+    };
+
+    /**
+     * @brief Parameters of the optional publish rate limiter. A publish has to obtain a token from the global bucket
+     * and from each bucket with a matching topic filter. The rate limiter is disabled, if neither the global bucket nor
+     * any topic bucket is set.
+     *
+     */
+    struct PublishRateLimitParameters final {
+        RateLimitMode               mode{RateLimitMode::REJECT}; /*!< what happens when the limit is exceeded */
+        TokenBucketParameters       global;                      /*!< limit applied to all publishes of the client */
+        std::vector<TopicRateLimit> topics{};                    /*!< limits applied to individual topic filters */
+        size_t maxQueued{1000U}; /*!< only for RateLimitMode::QUEUE, publishes exceeding the queue are rejected */
+    };
+
+    /**
+     * @brief Snapshot of the current state of the publish rate limiter.
+     *
+     */
+    struct PublishRateLimiterStatus final {
+        bool          enabled{false};    /*!< false, if no rate limit is configured */
+        double        globalTokens{0.0}; /*!< tokens currently available in the global bucket */
+        size_t        queued{0U};        /*!< number of messages currently waiting in the queue */
+        std::uint64_t passed{0U};        /*!< publishes that obtained a token without waiting */
+        std::uint64_t delayed{0U};       /*!< publishes that were delayed or queued before obtaining a token */
+        std::uint64_t rejected{0U};      /*!< publishes rejected with ReasonCode::ERROR_RATE_LIMITED */
+        std::vector<std::pair<std::string, double>> topicTokens{}; /*!< tokens available per topic filter */
+    };
+
+    /**
+     * @brief Snapshot of the round-trip latency of publishes, measured from handing the message over to the MQTT
+     * library until the library reports the completion. Percentiles are taken from a histogram with a relative
+     * precision of about 6 percent.
+     *
+     */
+    struct PublishLatencySnapshot final {
+        std::uint64_t             completed{0U}; /*!< number of completed publishes the latencies are based on */
+        std::uint64_t             inFlight{0U};  /*!< publishes handed over to the MQTT library, not completed yet,
+                                                      failed publishes are not counted and a disconnect resets it */
+        std::chrono::microseconds min{0};        /*!< minimum latency */
+        std::chrono::microseconds max{0};        /*!< maximum latency */
+        std::chrono::microseconds mean{0};       /*!< average latency */
+        std::chrono::microseconds p50{0};        /*!< median latency */
+        std::chrono::microseconds p90{0};        /*!< 90th percentile */
+        std::chrono::microseconds p99{0};        /*!< 99th percentile */
+        std::chrono::microseconds p999{0};       /*!< 99.9th percentile */
+    };
+
+    /**
+     * @brief State of the subscription registry, which restores the subscriptions of the client after a reconnect, if
+     * the broker did not keep the session. As MQTT does not tell about messages published while being disconnected,
+     * the number of missed messages is estimated from the message rate of the connection before.
+     *
+     */
+    struct SubscriptionRestoreStatus final {
+        size_t                    subscriptions{0U};   /*!< number of topic filters currently registered */
+        std::uint64_t             restores{0U};        /*!< connects, after which the subscriptions were restored */
+        std::uint64_t             skipped{0U};         /*!< connects, after which the broker kept the session */
+        size_t                    pending{0U};         /*!< SUBSCRIBE packets of the ongoing restore, not acked yet */
+        std::uint64_t             restoredFilters{0U}; /*!< topic filters successfully restored */
+        std::uint64_t             failedFilters{0U};   /*!< topic filters the restore failed for */
+        std::chrono::milliseconds lastGap{0}; /*!< time from the last disconnect until the last restore completed */
+        std::uint64_t estimatedMissedMessages{0U}; /*!< estimate of messages missed during all gaps, see above */
+    };
+
+    /**
+     * @brief A single topic filter of IMqttClient::SubscribeManyAsync.
+     *
+     */
+    struct TopicSubscription final {
+        std::string       topic{""};                     /*!< the topic filter to subscribe to */
+        IMqttMessage::QOS qos{IMqttMessage::QOS::QOS_0}; /*!< the Quality of Service used to subscribe */
+        bool              getRetained{true};             /*!< if set true, retained messages will be received */
+    };
+
+    /**
+     * @brief The MQTT library an IMqttClient is based on. Only the libraries enabled via CMake are available, see
+     * MqttClientFactory::IsAvailable.
+     *
+     */
+    enum class Backend {
+        DEFAULT,   /*!< the first available one of the backends below */
+        MOSQUITTO, /*!< Mosquitto, enabled via IMQTT_USE_MOSQ */
+        PAHO,      /*!< Paho, enabled via IMQTT_USE_PAHO */
+        NATIVE,    /*!< the built-in MQTTv5 client, enabled via IMQTT_USE_NATIVE */
+        LOOPBACK   /*!< the in-process broker, enabled via IMQTT_USE_LOOPBACK */
+    };
+
+    /**
+     * @brief Options of InitializeParameters, which are only used by Mosquitto.
+     *
+     */
+    struct MosquittoParameters final {
+        bool exponentialBackoff{false}; /*!< if true, the reconnect delay doubles up to reconnectDelayMax (always true
+                                           for the other backends) */
+    };
+
+    /**
+     * @brief Options of InitializeParameters, which are only used by Paho.
+     *
+     */
+    struct PahoParameters final {
+        bool disableDefaultCaStore{false}; /*!< if true, the systems default CA directory will not be considered */
+        bool autoReconnect{true};          /*!< if true, after connection loss, the MQTT library will try to reconnect
+                                              automatically (always true for the other backends) */
+        std::string httpProxy{""};  /*!< the http proxy address for MQTTWS connections, empty string means no proxy */
+        std::string httpsProxy{""}; /*!< the https proxy address for MQTTWSS connections, empty string means no proxy */
+    };
+
+    /**
+     * @brief Options of InitializeParameters, which are only used by the native client.
+     *
+     */
+    struct NativeParameters final {
+        std::uint32_t maxPacketSize{16U * 1024U * 1024U}; /*!< largest packet in bytes accepted from the broker, sent as
+                                                             Maximum Packet Size when connecting, the connection is
+                                                             closed on larger packets */
+    };
+
     /**
      * @brief Structure of (connection-) parameters handed over to IMqttClient at object instantiation.
      *
@@ -82,6 +245,28 @@ public:
                                                   (in case expinential backoff is enabled)*/
         bool allowLocalTopics{false}; /*!< when enabled, the client may receive its own messages, when subscribed to the
                                          topic published to */
+        PublishRateLimitParameters publishRateLimit; /*!< optional rate limiting of PublishAsync, disabled by default */
+        bool subscriptionIdentifiers{false}; /*!< assign MQTTv5 subscription identifiers to subscriptions, in order to
+                                                dispatch messages to handlers without matching the topic, only enable
+                                                for brokers reporting "Subscription Identifiers Available" */
+        bool restoreSubscriptions{false}; /*!< keep track of active subscriptions and restore them after a reconnect,
+                                             if the broker did not keep the session, subscribing again on
+                                             IMqttConnectionCallbacks::OnConnectionStatusChanged is not needed then.
+                                             Topic filters rejected by the broker are not restored. */
+        size_t restoreBatchSize{32U}; /*!< maximum number of topic filters per SUBSCRIBE packet, when restoring */
+        size_t lastValueCacheSize{0U}; /*!< bytes of an in-process cache of the last message per topic, handler
+                                          subscriptions of filters subscribed already share the subscription and are
+                                          answered from the cache by a thread of the client, 0 disables the cache */
+        std::shared_ptr<IReconnectScheduler> reconnectScheduler{nullptr}; /*!< decides on reconnects instead of
+                                                                             the reconnectDelay parameters, shared by
+                                                                             all clients, see IReconnectScheduler.h,
+                                                                             Mosquitto only waits whole seconds, so its
+                                                                             delays are rounded up to at least 1 s */
+        std::shared_ptr<IMqttMetrics> metrics{nullptr}; /*!< records messages, publish failures, reconnects and callback
+                                                           durations of the client, may be shared by many clients, see
+                                                           IMqttMetrics.h */
+        std::shared_ptr<IMqttTracer> tracer{nullptr}; /*!< attaches lifecycle timestamps to a share of the received
+                                                         messages, may be shared by many clients, see IMqttTracer.h */
 #ifdef IMQTT_WITH_TLS
         std::string caFilePath{""};         /*!< path to a file containing a CA certificate */
         std::string caDirPath{""};          /*!< path to a directory containing CA certificates */
@@ -89,23 +274,21 @@ public:
         std::string privateKeyFilePath{""}; /*!< path to a file containting the clients private key */
         std::string privateKeyPassword{
             ""}; /*!< password to encrpyt the private key, if not encrypted may be an empty string */
+        std::shared_ptr<IMqttTlsContext> tlsContext{nullptr}; /*!< TLS settings loaded once and shared by many clients,
+                                                                 used instead of the paths above (only on Mosquitto),
+                                                                 see IMqttTlsContext.h */
 #ifdef IMQTT_EXPERIMENTAL
         std::string clientCert{""}; /*!< the clients certificate as string */
         std::string privateKey{""}; /*!< the clients private key as string */
 #endif
 #endif
-#ifdef IMQTT_USE_PAHO
-        bool disableDefaultCaStore{false}; /*!< if true, the systems default CA directory will not be considered */
-        bool autoReconnect{true};          /*!< if true, after connection loss, the MQTT library will try to reconnect
-                                              automatically (true for Mosquitto always) */
-        std::string httpProxy{
-            ""}; /*!< the http proxy address for MQTTWS connections (only on Paho),empty string means no proxy */
-        std::string httpsProxy{
-            ""}; /*!< the https proxy address for MQTTWSS connections (only on Paho), empty string means no proxy */
-#endif
-#ifdef IMQTT_USE_MOSQ
-        bool exponentialBackoff{false}; /*true on PAHO*/
-#endif
+        Backend backend{Backend::DEFAULT}; /*!< the MQTT library the client is based on */
+        bool    externalLoop{false}; /*!< if true, no network thread is started, the network traffic has to be driven by
+                                        an external event loop via IMqttClient::GetExternalLoop, see IMqttExternalLoop.h
+                                        (only on Mosquitto and the native client) */
+        MosquittoParameters mosquitto; /*!< options only used by Backend::MOSQUITTO */
+        PahoParameters      paho;      /*!< options only used by Backend::PAHO */
+        NativeParameters    native;    /*!< options only used by Backend::NATIVE */
     };
 
     /**
@@ -202,10 +385,54 @@ public:
                                       int*               pToken      = nullptr,
                                       bool               getRetained = true) = 0;
 
+    /**
+     * @brief Same as SubscribeAsync above, but messages matching the topic filter are handed over to handler instead of
+     * IMqttMessageCallbacks::OnMqttMessage. Each message is handed over to all handlers with a matching topic filter,
+     * messages without any matching handler go to IMqttMessageCallbacks::OnMqttMessage. Matching is done with a trie of
+     * topic levels, so it does not get slower with the number of subscriptions. Handlers are invoked in the context of
+     * the MQTT library and must not block.
+     *
+     * @param topic the topic filter to subscribe to, wildcards and shared subscriptions are supported
+     * @param qos the Quality of Service used to subscribe
+     * @param handler invoked for each message matching topic, installed before the subscription is started
+     * @param pToken a token that is set after the method returned, can be used in order to correlate callbacks of
+     * IMqttCommandCallbacks::OnSubscribe, may be set to nullptr, if not needed
+     * @param getRetained if set true, messages retained at the broker will be received, when sharing a subscription
+     * via the last value cache, the cached messages are delivered instead, by a thread of the client and only to this
+     * handler, handlers subscribed before do not get them again
+     * @param pHandlerId set to an id of the handler, that can be passed to UnSubscribeAsync in order to remove only
+     * this handler again, may be set to nullptr, if not needed
+     * @return the IMqttClient ReasonCode, the handler is removed again, if not OKAY
+     */
+    virtual ReasonCode SubscribeAsync(std::string const& topic,
+                                      IMqttMessage::QOS  qos,
+                                      messageHandler_t   handler,
+                                      int*               pToken      = nullptr,
+                                      bool               getRetained = true,
+                                      std::uint64_t*     pHandlerId  = nullptr) = 0;
+
+    /**
+     * @brief Starts an attempt to Subscribe to multiple topic filters at once. Topic filters are sent in a single
+     * SUBSCRIBE packet, instead of one packet per filter. The subscription is done asynchronously, the method returns
+     * immediately. A return of OKAY means the attempt was started, not that the subscription finished. Use
+     * IMqttCommandCallbacks::OnSubscribeResults callbacks to obtain the result per topic filter.
+     *
+     * @param subscriptions the topic filters to subscribe to, each with its own Quality of Service and options
+     * @param pToken a token that is set after the method returned, can be used in order to correlate callbacks of
+     * IMqttCommandCallbacks::OnSubscribe and IMqttCommandCallbacks::OnSubscribeResults, may be set to nullptr, if not
+     * needed
+     * @warning Mosquitto only supports one Quality of Service and set of options per packet, topic filters differing
+     * in those are sent in one packet per combination. The callbacks are still invoked once for the whole call.
+     * @return the IMqttClient ReasonCode, if not OKAY some of the filters may have been subscribed nevertheless
+     */
+    virtual ReasonCode SubscribeManyAsync(std::vector<TopicSubscription> const& subscriptions,
+                                          int*                                  pToken = nullptr) = 0;
+
     /**
      * @brief Starts an attempt to Unsubscribe from a given topic. The unsubscription is done asynchronously, the method
      * returns immediately. A return of OKAY means the attempt was started, not that the unsubscription finished. Use
-     * IMqttCommandCallbacks::OnUnSubscribe callbacks to obtain further information.
+     * IMqttCommandCallbacks::OnUnSubscribe callbacks to obtain further information. All handlers installed for the
+     * topic via SubscribeAsync are removed immediately, use the overload taking a handler id to remove a single one.
      *
      * @param topic the topic to unsubscribe from
      * @param pToken a token that is set after the method returned, can be used in order to correlate callbacks of
@@ -215,6 +442,35 @@ public:
      */
     virtual ReasonCode UnSubscribeAsync(std::string const& topic, int* pToken = nullptr) = 0;
 
+    /**
+     * @brief Removes a single handler installed via SubscribeAsync, the other handlers of the topic filter are kept.
+     * Each handler counts as one user of the subscription, the topic filter is only unsubscribed at the broker once its
+     * last handler was removed. Until then, OKAY is returned without starting an unsubscription and the token is set to
+     * -1. Allows independent components to subscribe to and unsubscribe from the same topic filters.
+     *
+     * @param topic the topic filter the handler was installed for
+     * @param handlerId the id of the handler, as set by SubscribeAsync
+     * @param pToken a token that is set after the method returned, can be used in order to correlate callbacks of
+     * IMqttCommandCallbacks::OnUnSubscribe, may be set to nullptr, if not needed
+     * @return the IMqttClient ReasonCode, ERROR_GENERAL if the handler is not installed for the topic filter
+     */
+    virtual ReasonCode UnSubscribeAsync(std::string const& topic, std::uint64_t handlerId, int* pToken = nullptr) = 0;
+
+    /**
+     * @brief Starts an attempt to Unsubscribe from multiple topic filters in a single UNSUBSCRIBE packet. The
+     * unsubscription is done asynchronously, the method returns immediately. A return of OKAY means the attempt was
+     * started, not that the unsubscription finished. Use IMqttCommandCallbacks::OnUnSubscribeResults callbacks to
+     * obtain the result per topic filter. All handlers installed for the topics via SubscribeAsync are removed
+     * immediately.
+     *
+     * @param topics the topic filters to unsubscribe from
+     * @param pToken a token that is set after the method returned, can be used in order to correlate callbacks of
+     * IMqttCommandCallbacks::OnUnSubscribe and IMqttCommandCallbacks::OnUnSubscribeResults, may be set to nullptr, if
+     * not needed
+     * @return the IMqttClient ReasonCode
+     */
+    virtual ReasonCode UnSubscribeManyAsync(std::vector<std::string> const& topics, int* pToken = nullptr) = 0;
+
     /**
      * @brief Starts an attempt to Publish a message to a given topic. The publish is done asynchronously, the method
      * returns immediately. A return of OKAY means the attempt was started, not that the publish finished. Use
@@ -224,10 +480,81 @@ public:
      * @param pToken a token that is set after the method returned, can be used in order to correlate callbacks of
      * IMqttMessageCallbacks::OnPublish, may be set to nullptr, if not needed
      * @warning For Paho AND QOS0 the token is always set to 0 (fire and forget strategy)
+     * @warning When the message is queued by the rate limiter (RateLimitMode::QUEUE), the token is set to -1.
+     * IMqttCommandCallbacks::OnPublish is invoked with the token assigned once the message left the queue, correlating
+     * it with this call is not supported.
      * @return the IMqttClient ReasonCode
      */
     virtual ReasonCode PublishAsync(i_mqtt_client::upMqttMessage_t mqttMessage, int* pToken = nullptr) = 0;
     virtual bool       IsConnected(void) const noexcept                                                = 0;
+
+    /**
+     * @brief Publishes a message and blocks the caller until the publish finished or the timeout expired. For QOS0 the
+     * method returns as soon as the message was handed over to the MQTT library, as there is no acknowledgement.
+     * IMqttCommandCallbacks::OnPublish is still invoked.
+     *
+     * @param mqttMessage the message to publish
+     * @param timeout the maximum time to wait for the acknowledgement of the broker
+     * @param pRc set to the IMqttClient ReasonCode, ReasonCode::ERROR_TIMEOUT if the timeout expired, may be set to
+     * nullptr, if not needed
+     * @warning When the message is queued by the rate limiter (RateLimitMode::QUEUE), the method does not wait
+     * @return the Mqtt5ReasonCode reported by the broker, Mqtt5ReasonCode::UNSPECIFIED_ERROR if pRc is not OKAY
+     */
+    virtual Mqtt5ReasonCode Publish(i_mqtt_client::upMqttMessage_t mqttMessage,
+                                    std::chrono::milliseconds      timeout,
+                                    ReasonCode*                    pRc = nullptr) = 0;
+
+    /**
+     * @brief Subscribes to a given topic and blocks the caller until the subscription finished or the timeout expired.
+     * IMqttCommandCallbacks::OnSubscribe is still invoked.
+     *
+     * @param topic the topic to subscribe to
+     * @param qos the Quality of Service used to subscribe
+     * @param timeout the maximum time to wait for the acknowledgement of the broker
+     * @param pRc set to the IMqttClient ReasonCode, ReasonCode::ERROR_TIMEOUT if the timeout expired, may be set to
+     * nullptr, if not needed
+     * @param getRetained if set true, messages retained at the broker will be received
+     * @return the Mqtt5ReasonCode reported by the broker (the granted QoS on success),
+     * Mqtt5ReasonCode::UNSPECIFIED_ERROR if pRc is not OKAY
+     */
+    virtual Mqtt5ReasonCode Subscribe(std::string const&        topic,
+                                      IMqttMessage::QOS         qos,
+                                      std::chrono::milliseconds timeout,
+                                      ReasonCode*               pRc         = nullptr,
+                                      bool                      getRetained = true) = 0;
+
+    /**
+     * @brief Returns the current state of the publish rate limiter configured via
+     * InitializeParameters::publishRateLimit.
+     *
+     * @return snapshot of the rate limiter state
+     */
+    virtual PublishRateLimiterStatus GetPublishRateLimiterStatus(void) const = 0;
+
+    /**
+     * @brief Returns the round-trip latency of publishes with the given Quality of Service, since the client was
+     * created. Reading the snapshot does not lock and does not interfere with ongoing publishes.
+     *
+     * @param qos the Quality of Service, QOS0 is not tracked, as there is no acknowledgement
+     * @return snapshot of the latency histogram and the number of publishes in flight
+     */
+    virtual PublishLatencySnapshot GetPublishLatency(IMqttMessage::QOS qos) const = 0;
+
+    /**
+     * @brief Returns the state of the subscription registry configured via
+     * InitializeParameters::restoreSubscriptions.
+     *
+     * @return snapshot of the registry state
+     */
+    virtual SubscriptionRestoreStatus GetSubscriptionRestoreStatus(void) const = 0;
+
+    /**
+     * @brief Returns the hooks for driving the network traffic of the client from an external event loop, see
+     * IMqttExternalLoop.h. Only available, if enabled via InitializeParameters::externalLoop.
+     *
+     * @return the hooks, owned by the client, nullptr if the client runs its own network thread
+     */
+    virtual IMqttExternalLoop* GetExternalLoop(void) noexcept = 0;
 };
 
 /**
@@ -236,9 +563,17 @@ public:
  */
 class MqttClientFactory final {
 public:
+    /**
+     * @brief Tells, if the library was built with the given backend.
+     *
+     * @param backend the backend to check, Backend::DEFAULT is available, if any backend is
+     * @return true, if clients of the backend can be created
+     */
+    static bool IsAvailable(IMqttClient::Backend backend) noexcept;
+
     /**
      * @brief Generates an MqttClient object behind an IMqttClient interface. The user is responsible for object lifetime
-     * management.
+     * management. The client is based on InitializeParameters::backend, an exception is thrown if it is not available.
      *
      * @param msg pointer to an object providing a message callback
      * @param log pointer to an object providing a log callback for the IMqtt implementation, may be nullptr if not
@@ -254,6 +589,19 @@ public:
                                                IMqttLogCallbacks const*        log = nullptr,
                                                IMqttCommandCallbacks const*    cmd = nullptr,
                                                IMqttConnectionCallbacks const* con = nullptr);
+
+    /**
+     * @brief Same as Create above, but the client is based on backend instead of InitializeParameters::backend.
+     *
+     * @param backend the MQTT library to base the client on, an exception is thrown if it is not available
+     * @return unique pointer to an MqttClient object hidden by an abstract IMqttClient interface
+     */
+    static std::unique_ptr<IMqttClient> Create(IMqttClient::Backend                     backend,
+                                               IMqttClient::InitializeParameters const& params,
+                                               IMqttMessageCallbacks const*             msg,
+                                               IMqttLogCallbacks const*                 log = nullptr,
+                                               IMqttCommandCallbacks const*             cmd = nullptr,
+                                               IMqttConnectionCallbacks const*          con = nullptr);
     MqttClientFactory() = delete;
 };
 }  // namespace i_mqtt_client
@@ -0,0 +1,489 @@
+/**
+ * @file IMqttClientAwaitable.h
+ * @author Timo Lange
+ * @brief Optional C++20 coroutine front end for IMqttClient
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+/*This header is only active, when the including translation unit is compiled as C++20 with coroutine support*/
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/**
+ * @brief Describes where a coroutine suspended on an AwaitableMqttClient operation is resumed. Implement this interface
+ * in order to bind resumption to an existing executor (e.g. an event loop or a thread pool).
+ *
+ */
+class IAwaitableExecutor {
+protected:
+    IAwaitableExecutor(void) = default;
+
+public:
+    virtual ~IAwaitableExecutor() noexcept = default;
+
+    /**
+     * @brief Has to return true, if the calling thread already belongs to this executor. In this case the coroutine is
+     * resumed directly from within the MQTT library callback, without any additional thread switch.
+     *
+     * @return true if the calling thread is part of the executor
+     */
+    virtual bool IsCurrent(void) const noexcept = 0;
+
+    /**
+     * @brief Has to schedule the resumption of the given coroutine on the executor.
+     *
+     * @param handle the coroutine to be resumed
+     */
+    virtual void Post(std::coroutine_handle<> handle) = 0;
+};
+
+/**
+ * @brief Result of an awaited IMqttClient operation.
+ *
+ */
+struct AwaitResult final {
+    ReasonCode      rc{ReasonCode::OKAY};                /*!< result of starting the operation */
+    Mqtt5ReasonCode mqttRc{Mqtt5ReasonCode::SUCCESS}; /*!< MQTTv5 reason code reported on completion */
+};
+
+/**
+ * @brief Wraps an IMqttClient and makes ConnectAsync, PublishAsync, SubscribeAsync and message reception awaitable
+ * from C++20 coroutines. On construction it installs itself as connection, command and message callback of the given
+ * client, on destruction it removes itself again. The client must outlive this object. Connection and command callbacks
+ * are forwarded to the ones handed over on construction, so they are still invoked for every status change, publish
+ * and subscription, awaited or not. Received messages are only delivered via ReceiveAsync.
+ * Without an IAwaitableExecutor, coroutines are resumed directly on the thread of the underlying MQTT library, so the
+ * time spent until the next suspension point should be short (see IMqttMessageCallbacks::OnMqttMessage).
+ * @warning For QOS0 publishes no acknowledge exists, the operation completes as soon as the message was handed over to
+ * the MQTT library.
+ */
+class AwaitableMqttClient final : private IMqttConnectionCallbacks,
+                                  private IMqttCommandCallbacks,
+                                  private IMqttMessageCallbacks {
+public:
+    struct ReceiveAwaiter;
+
+private:
+    /*an operation waiting for completion, lives inside the coroutine frame while suspended*/
+    struct Operation {
+        AwaitableMqttClient&    owner;
+        AwaitResult             result;
+        std::coroutine_handle<> handle;
+        explicit Operation(AwaitableMqttClient& client)
+          : owner(client){};
+    };
+
+    IMqttClient&                    client;
+    IAwaitableExecutor*             executor;
+    IMqttConnectionCallbacks const* conCb;
+    IMqttCommandCallbacks const*    cmdCb;
+
+    mutable std::mutex                     awaitMutex;
+    mutable unsigned                       submitting{0U};
+    mutable std::map<int, Mqtt5ReasonCode> earlyCompletions;
+    mutable std::optional<Mqtt5ReasonCode> earlyConnect;
+    mutable std::map<int, Operation*>      publishWaiters;
+    mutable std::map<int, Operation*>      subscribeWaiters;
+    mutable std::vector<Operation*>        connectWaiters;
+    mutable std::deque<upMqttMessage_t>    receivedMessages;
+    mutable std::deque<ReceiveAwaiter*>    receiveWaiters;
+
+    void
+    resume(std::coroutine_handle<> handle) const
+    {
+        if (!executor || executor->IsCurrent()) {
+            handle.resume();
+        }
+        else {
+            executor->Post(handle);
+        }
+    }
+
+    void
+    complete(std::map<int, Operation*>& waiters, int token, Mqtt5ReasonCode mqttRc) const
+    {
+        std::unique_lock<std::mutex> lock(awaitMutex);
+        auto                         waiter{waiters.find(token)};
+        if (waiter == waiters.end()) {
+            /*completion overtook the caller, that is still registering its token*/
+            if (submitting) {
+                earlyCompletions[token] = mqttRc;
+            }
+            return;
+        }
+        auto op{waiter->second};
+        waiters.erase(waiter);
+        lock.unlock();
+        op->result.mqttRc = mqttRc;
+        resume(op->handle);
+    }
+
+    /*called after the client returned the token, decides whether the caller has to suspend*/
+    bool
+    registerToken(std::map<int, Operation*>& waiters, Operation& op, int token, bool waitForAck) const
+    {
+        std::lock_guard<std::mutex> lock(awaitMutex);
+        submitting--;
+        auto early{earlyCompletions.find(token)};
+        auto suspend{waitForAck && ReasonCode::OKAY == op.result.rc};
+        if (early != earlyCompletions.end()) {
+            if (suspend) {
+                op.result.mqttRc = early->second;
+                suspend          = false;
+            }
+            earlyCompletions.erase(early);
+        }
+        if (!submitting) {
+            earlyCompletions.clear();
+        }
+        if (suspend) {
+            waiters[token] = &op;
+        }
+        return suspend;
+    }
+
+    void
+    OnConnectionStatusChanged(ConnectionType type, Mqtt5ReasonCode mqttRc) const override
+    {
+        if (conCb) {
+            conCb->OnConnectionStatusChanged(type, mqttRc);
+        }
+        if (ConnectionType::CONNECT != type) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(awaitMutex);
+        if (connectWaiters.empty()) {
+            if (submitting) {
+                earlyConnect = mqttRc;
+            }
+            return;
+        }
+        auto waiters{std::move(connectWaiters)};
+        connectWaiters.clear();
+        lock.unlock();
+        for (auto op : waiters) {
+            op->result.mqttRc = mqttRc;
+            resume(op->handle);
+        }
+    }
+
+    void
+    OnPublish(token_t token, Mqtt5ReasonCode mqttRc) const override
+    {
+        if (cmdCb) {
+            cmdCb->OnPublish(token, mqttRc);
+        }
+        complete(publishWaiters, token, mqttRc);
+    }
+
+    void
+    OnSubscribe(token_t token) const override
+    {
+        if (cmdCb) {
+            cmdCb->OnSubscribe(token);
+        }
+    }
+
+    /*invoked on success and on failure of a subscription, unlike OnSubscribe, so it completes the awaiter*/
+    void
+    OnSubscribeResults(token_t token, std::vector<Mqtt5ReasonCode> const& mqttRcs) const override
+    {
+        if (cmdCb) {
+            cmdCb->OnSubscribeResults(token, mqttRcs);
+        }
+        complete(subscribeWaiters, token, mqttRcs.empty() ? Mqtt5ReasonCode::UNSPECIFIED_ERROR : mqttRcs.front());
+    }
+
+    void
+    OnUnSubscribe(token_t token) const override
+    {
+        if (cmdCb) {
+            cmdCb->OnUnSubscribe(token);
+        }
+    }
+
+    void
+    OnUnSubscribeResults(token_t token, std::vector<Mqtt5ReasonCode> const& mqttRcs) const override
+    {
+        if (cmdCb) {
+            cmdCb->OnUnSubscribeResults(token, mqttRcs);
+        }
+    }
+
+    void OnMqttMessage(upMqttMessage_t) const override;
+
+public:
+    /**
+     * @brief Awaiter returned by ConnectAsync, completes with the next connection status of type CONNECT.
+     *
+     */
+    struct ConnectAwaiter final : Operation {
+        using Operation::Operation;
+        bool
+        await_ready(void) const noexcept
+        {
+            return false;
+        }
+        bool
+        await_suspend(std::coroutine_handle<> h)
+        {
+            handle = h;
+            {
+                std::lock_guard<std::mutex> lock(owner.awaitMutex);
+                owner.submitting++;
+            }
+            result.rc = owner.client.ConnectAsync();
+            std::lock_guard<std::mutex> lock(owner.awaitMutex);
+            owner.submitting--;
+            auto suspend{ReasonCode::OKAY == result.rc};
+            if (suspend && owner.earlyConnect) {
+                result.mqttRc = *owner.earlyConnect;
+                suspend       = false;
+            }
+            if (!owner.submitting) {
+                owner.earlyConnect.reset();
+            }
+            if (suspend) {
+                owner.connectWaiters.push_back(this);
+            }
+            return suspend;
+        }
+        AwaitResult
+        await_resume(void) const noexcept
+        {
+            return result;
+        }
+    };
+
+    /**
+     * @brief Awaiter returned by PublishAsync, completes once IMqttCommandCallbacks::OnPublish was invoked for the
+     * message.
+     *
+     */
+    struct PublishAwaiter final : Operation {
+        upMqttMessage_t msg;
+        PublishAwaiter(AwaitableMqttClient& client, upMqttMessage_t mqttMessage)
+          : Operation(client)
+          , msg(std::move(mqttMessage)){};
+        bool
+        await_ready(void) const noexcept
+        {
+            return false;
+        }
+        bool
+        await_suspend(std::coroutine_handle<> h)
+        {
+            handle = h;
+            auto waitForAck{IMqttMessage::QOS::QOS_0 != msg->qos};
+            {
+                std::lock_guard<std::mutex> lock(owner.awaitMutex);
+                owner.submitting++;
+            }
+            int token{-1};
+            result.rc = owner.client.PublishAsync(std::move(msg), &token);
+            return owner.registerToken(owner.publishWaiters, *this, token, waitForAck);
+        }
+        AwaitResult
+        await_resume(void) const noexcept
+        {
+            return result;
+        }
+    };
+
+    /**
+     * @brief Awaiter returned by SubscribeAsync, completes once IMqttCommandCallbacks::OnSubscribeResults was invoked.
+     * AwaitResult::mqttRc holds the reason code of the SUBACK, i.e. the granted QoS or the reason of the failure.
+     *
+     */
+    struct SubscribeAwaiter final : Operation {
+        std::string       topic;
+        IMqttMessage::QOS qos;
+        bool              getRetained;
+        SubscribeAwaiter(AwaitableMqttClient& client, std::string const& t, IMqttMessage::QOS q, bool retained)
+          : Operation(client)
+          , topic(t)
+          , qos(q)
+          , getRetained(retained){};
+        bool
+        await_ready(void) const noexcept
+        {
+            return false;
+        }
+        bool
+        await_suspend(std::coroutine_handle<> h)
+        {
+            handle = h;
+            {
+                std::lock_guard<std::mutex> lock(owner.awaitMutex);
+                owner.submitting++;
+            }
+            int token{-1};
+            result.rc = owner.client.SubscribeAsync(topic, qos, &token, getRetained);
+            return owner.registerToken(owner.subscribeWaiters, *this, token, true);
+        }
+        AwaitResult
+        await_resume(void) const noexcept
+        {
+            return result;
+        }
+    };
+
+    /**
+     * @brief Awaiter returned by ReceiveAsync, completes with the next received MQTT message.
+     *
+     */
+    struct ReceiveAwaiter final {
+        AwaitableMqttClient&    owner;
+        upMqttMessage_t         msg;
+        std::coroutine_handle<> handle;
+        explicit ReceiveAwaiter(AwaitableMqttClient& client)
+          : owner(client){};
+        bool
+        await_ready(void) const noexcept
+        {
+            return false;
+        }
+        bool
+        await_suspend(std::coroutine_handle<> h)
+        {
+            handle = h;
+            std::lock_guard<std::mutex> lock(owner.awaitMutex);
+            if (!owner.receivedMessages.empty()) {
+                msg = std::move(owner.receivedMessages.front());
+                owner.receivedMessages.pop_front();
+                return false;
+            }
+            owner.receiveWaiters.push_back(this);
+            return true;
+        }
+        upMqttMessage_t
+        await_resume(void) noexcept
+        {
+            return std::move(msg);
+        }
+    };
+
+    /**
+     * @brief Creates the coroutine front end for an existing client.
+     *
+     * @param mqttClient the client to be wrapped, the user is responsible for object lifetimes
+     * @param exec executor used to resume coroutines, nullptr resumes directly on the MQTT library's thread
+     * @param con connection callbacks of the user, invoked before awaiters are resumed, may be nullptr
+     * @param cmd command callbacks of the user, invoked before awaiters are resumed, may be nullptr
+     */
+    explicit AwaitableMqttClient(IMqttClient&                    mqttClient,
+                                 IAwaitableExecutor*             exec = nullptr,
+                                 IMqttConnectionCallbacks const* con  = nullptr,
+                                 IMqttCommandCallbacks const*    cmd  = nullptr)
+      : client(mqttClient)
+      , executor(exec)
+      , conCb(con)
+      , cmdCb(cmd)
+    {
+        client.SetCallbacks<IMqttConnectionCallbacks>(this);
+        client.SetCallbacks<IMqttCommandCallbacks>(this);
+        client.SetCallbacks<IMqttMessageCallbacks>(this);
+    }
+
+    ~AwaitableMqttClient() noexcept
+    {
+        client.SetCallbacks<IMqttMessageCallbacks>();
+        client.SetCallbacks<IMqttCommandCallbacks>();
+        client.SetCallbacks<IMqttConnectionCallbacks>();
+    }
+
+    AwaitableMqttClient(const AwaitableMqttClient&) = delete;
+    AwaitableMqttClient(AwaitableMqttClient&&)      = delete;
+    AwaitableMqttClient& operator=(const AwaitableMqttClient&) = delete;
+    AwaitableMqttClient& operator=(AwaitableMqttClient&&) = delete;
+
+    /**
+     * @brief Awaitable version of IMqttClient::ConnectAsync, resumes with the result of the next CONNECT status.
+     *
+     * @return awaiter yielding an AwaitResult
+     */
+    ConnectAwaiter
+    ConnectAsync(void)
+    {
+        return ConnectAwaiter(*this);
+    }
+
+    /**
+     * @brief Awaitable version of IMqttClient::PublishAsync, resumes once the publish completed.
+     *
+     * @param mqttMessage the message to publish
+     * @return awaiter yielding an AwaitResult
+     */
+    PublishAwaiter
+    PublishAsync(upMqttMessage_t mqttMessage)
+    {
+        return PublishAwaiter(*this, std::move(mqttMessage));
+    }
+
+    /**
+     * @brief Awaitable version of IMqttClient::SubscribeAsync, resumes once the SUBACK was received or the
+     * subscription failed.
+     *
+     * @param topic the topic to subscribe to
+     * @param qos the Quality of Service used to subscribe
+     * @param getRetained if set true, messages retained at the broker will be received
+     * @return awaiter yielding an AwaitResult
+     */
+    SubscribeAwaiter
+    SubscribeAsync(std::string const& topic, IMqttMessage::QOS qos, bool getRetained = true)
+    {
+        return SubscribeAwaiter(*this, topic, qos, getRetained);
+    }
+
+    /**
+     * @brief Resumes with the next received MQTT message. Messages received while nobody awaits are buffered.
+     *
+     * @return awaiter yielding the received message
+     */
+    ReceiveAwaiter
+    ReceiveAsync(void)
+    {
+        return ReceiveAwaiter(*this);
+    }
+};
+
+inline void
+AwaitableMqttClient::OnMqttMessage(upMqttMessage_t mqttMessage) const
+{
+    std::unique_lock<std::mutex> lock(awaitMutex);
+    if (receiveWaiters.empty()) {
+        receivedMessages.push_back(std::move(mqttMessage));
+        return;
+    }
+    auto waiter{receiveWaiters.front()};
+    receiveWaiters.pop_front();
+    lock.unlock();
+    waiter->msg = std::move(mqttMessage);
+    resume(waiter->handle);
+}
+}  // namespace i_mqtt_client
+#endif
@@ -20,11 +20,23 @@
 
 #pragma once
 
+#include <atomic>
+#include <climits>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "IMqttMessage.h"
 
+/**
+ * @brief Logs below this level (see ::LogLevel) are removed at compile time. Set via the CMake cache variable of the
+ * same name and exported by the interface target, so IMqtt and the code using it always agree on it. Code not using
+ * the CMake target has to define the value IMqtt was built with, by default nothing is removed.
+ */
+#ifndef IMQTT_MIN_LOG_LEVEL
+#define IMQTT_MIN_LOG_LEVEL 1
+#endif
+
 namespace i_mqtt_client {
 
 /**
@@ -34,9 +46,43 @@ namespace i_mqtt_client {
 class IMqttLogCallbacks {
 private:
     static MqttLogInit_t mqttLibLogInitParams;
+    /*atomic, as the level can be changed while clients are logging*/
+    std::atomic_int minLogLevel{static_cast<int>(LogLevel::TRACE)};
+    /*logs also have to pass the level of this one, see FollowMinLogLevel*/
+    IMqttLogCallbacks const* levelSource{nullptr};
 
 protected:
     IMqttLogCallbacks(void) = default;
+    IMqttLogCallbacks(IMqttLogCallbacks const& other) noexcept
+      : minLogLevel(other.minLogLevel.load())
+      , levelSource(other.levelSource){};
+    IMqttLogCallbacks&
+    operator=(IMqttLogCallbacks const& other) noexcept
+    {
+        minLogLevel = other.minLogLevel.load();
+        levelSource = other.levelSource;
+        return *this;
+    }
+    /**
+     * @brief used internally, for objects forwarding their logs to other log callbacks, so logs are filtered by the
+     * level of those, also when it is changed later on. Has to be called before the object is used for logging.
+     *
+     * @param source the log callbacks the logs are forwarded to, it has to outlive this object
+     */
+    void
+    FollowMinLogLevel(IMqttLogCallbacks const* source) noexcept
+    {
+        levelSource = source;
+    }
+    /**
+     * @brief used internally, for objects that drop all logs anyway
+     *
+     */
+    void
+    DisableLogs(void) noexcept
+    {
+        minLogLevel = INT_MAX;
+    }
     /**
      * @brief used internally
      *
@@ -68,6 +114,61 @@ public:
         (void)lvl;
         (void)txt;
     };
+
+    /**
+     * @brief Logs below the given level are not formatted and Log is not invoked for them. Can be changed at any time.
+     * By default, all levels are logged, except the ones removed via IMQTT_MIN_LOG_LEVEL. Overrides have to invoke
+     * this implementation.
+     *
+     * @param lvl the lowest level to be logged
+     */
+    virtual void
+    SetMinLogLevel(LogLevel lvl) noexcept
+    {
+        minLogLevel = static_cast<int>(lvl);
+    }
+
+    /**
+     * @brief Returns the level set via SetMinLogLevel.
+     *
+     * @return the lowest level to be logged
+     */
+    LogLevel
+    GetMinLogLevel(void) const noexcept
+    {
+        return static_cast<LogLevel>(minLogLevel.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Tells, if Log would be invoked for the given level. Has to be checked before formatting a log message.
+     *
+     * @param lvl the log level of the message
+     * @return true, if the level is neither removed at compile time, nor below the level set via SetMinLogLevel
+     */
+    bool
+    IsLogged(LogLevel lvl) const noexcept
+    {
+        return static_cast<int>(lvl) >= IMQTT_MIN_LOG_LEVEL &&
+               static_cast<int>(lvl) >= minLogLevel.load(std::memory_order_relaxed) &&
+               (!levelSource || levelSource->IsLogged(lvl));
+    }
+
+    /**
+     * @brief Invokes Log, with the text returned by formatter, only if the level is logged. Formatting is deferred
+     * behind the level check, so a filtered log does not cost any string operations, e.g.
+     * logCb->Log<LogLevel::DEBUG>([&] { return "Publishing to topic: " + topic; });
+     *
+     * @tparam lvl the log level of the message
+     * @param formatter callable returning the message text
+     */
+    template <LogLevel lvl, class Formatter>
+    void
+    Log(Formatter const& formatter) const
+    {
+        if (IsLogged(lvl)) {
+            Log(lvl, formatter());
+        }
+    }
 };
 
 /**
@@ -154,7 +255,7 @@ public:
      * @brief Can be overriden by the user in order to obtain information about a preceeded call to
      * IMqttClient::SubscribeAsync. Currently is invoked, once the underlying MQTT library finished subscribing.
      * If not overriden, a default empty callback will be used.
-     * @todo This method should provide the MQTT v5 reason codes to the user.
+     * The MQTT v5 reason codes are provided by OnSubscribeResults.
      *
      * @param token a value indicating which preceeding call to IMqttClient::SubscribeAsync this callback belongs to.
      * @warning For Paho AND QOS0 operations, the token is always 0 (fire and forget strategy).
@@ -169,7 +270,7 @@ public:
      * @brief Can be overriden by the user in order to obtain information about a preceeded call to
      * IMqttClient::UnSubscribeAsync. Currently is invoked, once the underlying MQTT library finished unsubscribing.
      * If not overriden, a default empty callback will be used.
-     * @todo This method should provide the MQTT v5 reason codes to the user.
+     * The MQTT v5 reason codes are provided by OnUnSubscribeResults.
      *
      * @param token a value indicating which preceeding call to IMqttClient::UnSubscribeAsync this callback belongs to.
      * @warning For Paho AND QOS0 operations, the token is always 0 (fire and forget strategy).
@@ -181,6 +282,38 @@ public:
         /*by default, do nothing*/
     }
 
+    /**
+     * @brief Can be overriden by the user in order to obtain the per topic filter results of a preceeded call to
+     * IMqttClient::SubscribeAsync or IMqttClient::SubscribeManyAsync. Is invoked after OnSubscribe on success and
+     * without OnSubscribe, if the subscription failed. If not overriden, a default empty callback will be used.
+     *
+     * @param token a value indicating which preceeding call this callback belongs to.
+     * @param mqttRcs one MQTTv5 reason code per topic filter, in the order of the call. On success the reason code is
+     * the granted QoS (Mqtt5ReasonCode::GRANTED_QOS_0 to Mqtt5ReasonCode::GRANTED_QOS_2).
+     */
+    virtual void
+    OnSubscribeResults(token_t token, std::vector<Mqtt5ReasonCode> const& mqttRcs) const
+    {
+        (void)token;
+        (void)mqttRcs;
+    }
+
+    /**
+     * @brief Can be overriden by the user in order to obtain the per topic filter results of a preceeded call to
+     * IMqttClient::UnSubscribeAsync or IMqttClient::UnSubscribeManyAsync. Is invoked after OnUnSubscribe. If not
+     * overriden, a default empty callback will be used.
+     * @warning Mosquitto does not provide the reason codes of UNSUBACK, Mqtt5ReasonCode::SUCCESS is reported instead.
+     *
+     * @param token a value indicating which preceeding call this callback belongs to.
+     * @param mqttRcs one MQTTv5 reason code per topic filter, in the order of the call
+     */
+    virtual void
+    OnUnSubscribeResults(token_t token, std::vector<Mqtt5ReasonCode> const& mqttRcs) const
+    {
+        (void)token;
+        (void)mqttRcs;
+    }
+
     /**
      * @brief Can be overriden by the user in order to obtain information about a preceeded call to
      * IMqttClient::PublishAsync. Is invoked, once the underlying MQTT library finished publishing.
@@ -33,6 +33,8 @@ enum class ReasonCode {
     ERROR_NO_CONNECTION,
     ERROR_TLS,
     NOT_ALLOWED,
+    ERROR_RATE_LIMITED,
+    ERROR_TIMEOUT,
     /*When adding ReasonCodes, also add them to the string representation*/
 };
 
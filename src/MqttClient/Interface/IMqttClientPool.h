@@ -0,0 +1,66 @@
+/**
+ * @file IMqttClientPool.h
+ * @author Timo Lange
+ * @brief Factory for a pool of connections behind the IMqttClient interface
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/**
+ * @brief Used to instantiate a pool of MqttClient objects (connections) behind a single IMqttClient interface, in order
+ * to scale publish throughput beyond a single socket and network thread.
+ * Publishes are spread across the connections by hashing the topic, so messages of the same topic keep their order.
+ * While a connection is down, its publishes are taken over by the next connected one. Subscriptions are all placed on
+ * a single connection and move to another one, once it is lost.
+ * Tokens reported to IMqttCommandCallbacks are the tokens returned by the pool, operations the pool issued on its own
+ * (e.g. moving subscriptions) are reported with a token of -1. IMqttConnectionCallbacks report CONNECT once the first
+ * connection is established and DISCONNECT once the last one is lost. Statistics are summed up over all connections,
+ * latency percentiles are the maximum of all connections.
+ */
+class MqttClientPoolFactory final {
+public:
+    /**
+     * @brief Generates a pool of MqttClient objects behind an IMqttClient interface. The user is responsible for
+     * object lifetime management.
+     *
+     * @param params used for all connections, clientId is used as prefix and extended by "-<connection index>",
+     * cleanSession is always set, so subscriptions do not survive on a connection they were moved away from. Rate
+     * limits apply per connection.
+     * @param connections number of connections, at least 1
+     * @param msg pointer to an object providing a message callback, invoked concurrently by all connections
+     * @param log pointer to an object providing a log callback for the IMqtt implementation, may be nullptr if not
+     * needed
+     * @param cmd pointer to an object providing a command callback for the IMqtt implementation, may be nullptr if not
+     * needed
+     * @param con pointer to an object providing a connection status callback for the IMqtt implementation, may be
+     * nullptr if not needed
+     * @return unique pointer to a pool hidden by an abstract IMqttClient interface
+     */
+    static std::unique_ptr<IMqttClient> Create(IMqttClient::InitializeParameters const& params,
+                                               unsigned                                 connections,
+                                               IMqttMessageCallbacks const*             msg,
+                                               IMqttLogCallbacks const*                 log = nullptr,
+                                               IMqttCommandCallbacks const*             cmd = nullptr,
+                                               IMqttConnectionCallbacks const*          con = nullptr);
+    MqttClientPoolFactory() = delete;
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,121 @@
+/**
+ * @file IMqttConsumerGroup.h
+ * @author Timo Lange
+ * @brief Interface definition for a group of MQTT clients consuming shared subscriptions
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/**
+ * @brief Runs a number of IMqttClient instances (members) that consume the same topic filters via MQTTv5 shared
+ * subscriptions ($share/<group>/<filter>). The broker spreads the messages of a shared subscription across all
+ * members subscribed to it, so adding members adds capacity. Groups in multiple processes scale the same way, as long
+ * as they use the same group name and unique client IDs.
+ * Topic filters are spread across the connected members. Once a member loses its connection, its topic filters are
+ * taken over by the remaining members, until it is back.
+ */
+class IMqttConsumerGroup {
+protected:
+    IMqttConsumerGroup(void) = default;
+
+public:
+    IMqttConsumerGroup(const IMqttConsumerGroup&) = delete;
+    IMqttConsumerGroup(IMqttConsumerGroup&&)      = delete;
+    IMqttConsumerGroup& operator=(const IMqttConsumerGroup&) = delete;
+    IMqttConsumerGroup& operator=(IMqttConsumerGroup&&) = delete;
+    void*               operator new[](size_t)          = delete;
+
+    virtual ~IMqttConsumerGroup() noexcept = default;
+
+    /**
+     * @brief Parameters of a consumer group.
+     *
+     */
+    struct Parameters final {
+        std::string group{"group"}; /*!< name of the share group, has to be the same in all processes */
+        unsigned    members{1U};    /*!< number of client instances (members) run by this object */
+        unsigned    membersPerFilter{0U}; /*!< number of connected members subscribing to each topic filter, 0 for
+                                             all members */
+        std::vector<IMqttClient::TopicSubscription> subscriptions{}; /*!< topic filters without $share prefix */
+        IMqttClient::InitializeParameters clientParameters; /*!< used for all members, clientId is used as prefix and
+                                                               extended by "-<member index>", cleanSession is always
+                                                               set, so the share of a lost member is not queued */
+    };
+
+    /**
+     * @brief State of a single member.
+     *
+     */
+    struct MemberStatus final {
+        std::string              clientId{""};           /*!< client ID of the member */
+        bool                     connected{false};       /*!< true, if the member is connected to the broker */
+        std::vector<std::string> topics{};               /*!< topic filters the member is currently subscribed to */
+        std::uint64_t            messages{0U};           /*!< number of messages received by the member */
+        double                   messagesPerSecond{0.0}; /*!< receive rate of the last second */
+    };
+
+    /**
+     * @brief Starts connecting all members. Members subscribe, once they are connected.
+     *
+     * @return the IMqttClient ReasonCode, not OKAY if any member failed to start connecting
+     */
+    virtual ReasonCode Start(void) = 0;
+
+    /**
+     * @brief Disconnects all members. Topic filters of members, that are disconnected already, are not moved to the
+     * remaining members any more. Start can be called again afterwards.
+     *
+     */
+    virtual void Stop(void) = 0;
+
+    /**
+     * @brief Returns the state of all members.
+     *
+     * @return one entry per member, in the order of the member index
+     */
+    virtual std::vector<MemberStatus> GetStatus(void) const = 0;
+};
+
+/**
+ * @brief Used to instantiate a ConsumerGroup object behind an IMqttConsumerGroup interface.
+ *
+ */
+class MqttConsumerGroupFactory final {
+public:
+    /**
+     * @brief Generates a ConsumerGroup object behind an IMqttConsumerGroup interface. The user is responsible for
+     * object lifetime management.
+     *
+     * @param params parameters of the group
+     * @param msg reference to an object providing a message callback, invoked concurrently by all members
+     * @param log pointer to an object providing a log callback, may be nullptr if not needed
+     * @return unique pointer to a ConsumerGroup object hidden by an abstract IMqttConsumerGroup interface
+     */
+    static std::unique_ptr<IMqttConsumerGroup> Create(IMqttConsumerGroup::Parameters const& params,
+                                                      IMqttMessageCallbacks const&          msg,
+                                                      IMqttLogCallbacks const*              log = nullptr);
+    MqttConsumerGroupFactory() = delete;
+};
+}  // namespace i_mqtt_client
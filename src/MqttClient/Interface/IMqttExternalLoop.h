@@ -0,0 +1,109 @@
+/**
+ * @file IMqttExternalLoop.h
+ * @author Timo Lange
+ * @brief Hooks for driving the network traffic of an IMqttClient from an external event loop
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+
+#include "IMqttClientDefines.h"
+
+namespace i_mqtt_client {
+/**
+ * @brief Lets an external event loop (e.g. epoll or io_uring based) drive the network traffic of an IMqttClient,
+ * instead of a network thread per client. Obtained via IMqttClient::GetExternalLoop, if the client was created with
+ * InitializeParameters::externalLoop (Mosquitto and the native client only).
+ * The loop has to watch Socket() for readability and call Read(), watch it for writability as long as WantWrite()
+ * returns true and call Write(), and call Misc() at least once per second, in order to send keep alives and to retry
+ * messages. All callbacks of the client are invoked from the thread calling these methods.
+ * The MQTT library does not reconnect on its own, Reconnect() has to be called by the loop, after the connection got
+ * lost. IMqttReactor.h provides such a loop.
+ */
+class IMqttExternalLoop {
+public:
+    /**
+     * @brief Invoked whenever the client queued data to be sent from outside of the loop, e.g. by PublishAsync, or
+     * whenever the socket changed. The loop should then re-read Socket() and WantWrite(). May be invoked from any
+     * thread, so it has to be cheap and thread-safe, e.g. writing to an eventfd.
+     */
+    using wakeUp_t = std::function<void(void)>;
+
+    virtual ~IMqttExternalLoop() noexcept = default;
+
+    /**
+     * @brief Returns the socket of the connection to the broker.
+     *
+     * @return the file descriptor, -1 if there is no connection
+     */
+    virtual int Socket(void) const noexcept = 0;
+
+    /**
+     * @brief Reads and handles incoming packets, to be called once Socket() is readable.
+     *
+     * @return the IMqttClient ReasonCode, ERROR_NO_CONNECTION once the connection got lost
+     */
+    virtual ReasonCode Read(void) = 0;
+
+    /**
+     * @brief Writes queued packets, to be called once Socket() is writable.
+     *
+     * @return the IMqttClient ReasonCode, ERROR_NO_CONNECTION once the connection got lost
+     */
+    virtual ReasonCode Write(void) = 0;
+
+    /**
+     * @brief Handles keep alives and retries of messages, to be called at least once per second.
+     *
+     * @return the IMqttClient ReasonCode, ERROR_NO_CONNECTION if there is no connection
+     */
+    virtual ReasonCode Misc(void) = 0;
+
+    /**
+     * @brief Tells if there are packets waiting to be written.
+     *
+     * @return true, if the loop has to wait for Socket() to become writable
+     */
+    virtual bool WantWrite(void) const noexcept = 0;
+
+    /**
+     * @brief Tells if the connection got lost, without IMqttClient::DisconnectAsync being called, so the loop has to
+     * schedule Reconnect().
+     *
+     * @return true, if there is no connection but one was requested
+     */
+    virtual bool WantReconnect(void) const noexcept = 0;
+
+    /**
+     * @brief Starts a non-blocking attempt to reconnect with the parameters of the last IMqttClient::ConnectAsync, to
+     * be called after the connection got lost, respecting InitializeParameters::reconnectDelayMin and
+     * InitializeParameters::reconnectDelayMax.
+     *
+     * @return the IMqttClient ReasonCode
+     */
+    virtual ReasonCode Reconnect(void) = 0;
+
+    /**
+     * @brief Sets the function invoked when the loop has to re-check the socket, see wakeUp_t. Has to be set before
+     * IMqttClient::ConnectAsync is called.
+     *
+     * @param wakeUp the function to invoke, nullptr to disable
+     */
+    virtual void SetWakeUp(wakeUp_t wakeUp) = 0;
+};
+}  // namespace i_mqtt_client
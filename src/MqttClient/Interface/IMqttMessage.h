@@ -20,15 +20,19 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "IMqttClientDefines.h"
 
 namespace i_mqtt_client {
+class IMqttTracer;
 
 /**
  @brief Describes the abstract interface to be used in order to deal with MqttMessages. It hides the
@@ -41,6 +45,7 @@ public:
     using payload_t              = const std::vector<payloadRaw_t>;
     using userProps_t            = std::map<std::string, std::string>;
     using correlationDataProps_t = std::vector<payloadRaw_t>;
+    using subscriptionIds_t      = std::vector<std::uint32_t>;
     /**
      * @brief Payload Format Indicator as defined in the MQTTv5 standard
      *
@@ -51,6 +56,22 @@ public:
      *
      */
     enum class QOS : int { QOS_0 = 0, QOS_1 = 1, QOS_2 = 2 };
+    /**
+     * @brief Monotonic timestamps of the stages a received message passed, attached to sampled messages by an
+     * IMqttTracer. Stages the message did not pass stay at the epoch of the clock.
+     *
+     */
+    struct Trace final {
+        using clock_t = std::chrono::steady_clock;
+        std::uint64_t              id{0U};       /*!< number of the trace, counted per tracer */
+        std::string                topic;        /*!< the topic of the message */
+        clock_t::time_point        received;     /*!< handed over by the MQTT library */
+        clock_t::time_point        enqueued;     /*!< stored in a dispatch queue */
+        clock_t::time_point        dequeued;     /*!< taken from the dispatch queue */
+        clock_t::time_point        handlerStart; /*!< handed over to the message handler */
+        clock_t::time_point        handlerEnd;   /*!< returned from the message handler */
+        std::weak_ptr<IMqttTracer> tracer;       /*!< the tracer the completed trace is handed over to */
+    };
 
 private:
     IMqttMessage(const IMqttMessage&) = delete;
@@ -67,6 +88,13 @@ protected:
       , retain(retain)
     {
     }
+    IMqttMessage(std::string&& topic, std::vector<payloadRaw_t>&& payload, QOS qos, bool retain)
+      : topic(std::move(topic))
+      , payload(std::move(payload))
+      , qos(qos)
+      , retain(retain)
+    {
+    }
 
 public:
     virtual ~IMqttMessage() noexcept = default;
@@ -84,6 +112,8 @@ public:
     std::string            responseTopic{""};                                    /*!< a response topic as defined in the MQTTv5 standard */
     FormatIndicator        payloadFormatIndicator{FormatIndicator::UNSPECIFIED}; /*!< payload format indicator as defined in the MQTTv5 standard */
     std::string            payloadContentType{""};                               /*!< playload content type as defined in the MQTTv5 standard, string */
+    subscriptionIds_t      subscriptionIds{subscriptionIds_t()};                 /*!< identifiers of the matching subscriptions as defined in the MQTTv5 standard, only for received messages */
+    std::shared_ptr<Trace> trace{nullptr};                                       /*!< lifecycle timestamps, only for received messages sampled by an IMqttTracer */
 
     /**
      * @brief Returns the raw byte payload casted a C++ string. Depending on the payload not printable.
@@ -131,6 +161,21 @@ public:
                                   IMqttMessage::payload_t const&& payload,
                                   IMqttMessage::QOS               qos,
                                   bool                            retain = false);
+
+    /**
+     * @brief Like Create above, but takes over topic and payload instead of copying them.
+     *
+     * @param topic sets the message's topic
+     * @param payload sets the message's payload
+     * @param qos sets the message's qos flag
+     * @param retain sets the message's retain flag
+     * @return unique pointer to an MqttMessage behind an IMqttMessage interface, the user is responsible for object
+     * lifetimes
+     */
+    static upMqttMessage_t Create(std::string&&                             topic,
+                                  std::vector<IMqttMessage::payloadRaw_t>&& payload,
+                                  IMqttMessage::QOS                         qos,
+                                  bool                                      retain = false);
     MqttMessageFactory() = delete;
 };
 }  // namespace i_mqtt_client
\ No newline at end of file
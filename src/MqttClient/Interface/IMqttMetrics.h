@@ -0,0 +1,159 @@
+/**
+ * @file IMqttMetrics.h
+ * @author Timo Lange
+ * @brief Abstract interface class for the metrics of IMqttClient objects
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/**
+ * @brief Collects metrics of clients and dispatch queues, which are given the registry via
+ * InitializeParameters::metrics and DispatchQueueFactory::Create. A registry may be shared by many clients, it then
+ * sums up the metrics of all of them. Counters are spread over shards, each thread records into its own shard without
+ * locking, a snapshot sums them up. No network listener is started, the application exposes ToPrometheus as it likes.
+ * All methods are thread-safe.
+ */
+class IMqttMetrics {
+protected:
+    IMqttMetrics(void) = default;
+
+public:
+    IMqttMetrics(const IMqttMetrics&) = delete;
+    IMqttMetrics(IMqttMetrics&&)      = delete;
+    IMqttMetrics& operator=(const IMqttMetrics&) = delete;
+    IMqttMetrics& operator=(IMqttMetrics&&) = delete;
+    void*         operator new[](size_t)    = delete;
+
+    virtual ~IMqttMetrics() noexcept = default;
+
+    /**
+     * @brief Callbacks whose durations are measured.
+     *
+     */
+    enum class Callback {
+        MESSAGE, /*!< delivery of a received message on the thread of the MQTT library, including the handlers, unless
+                    a dispatch queue decouples them */
+        DISPATCH /*!< delivery of a message by a dispatch queue */
+    };
+
+    /**
+     * @brief Metrics summed up over all shards, indices of the per QoS arrays are the QoS levels.
+     *
+     */
+    struct Snapshot final {
+        std::array<std::uint64_t, 3>        messagesIn{};  /*!< messages received */
+        std::array<std::uint64_t, 3>        bytesIn{};     /*!< payload bytes received */
+        std::array<std::uint64_t, 3>        messagesOut{}; /*!< messages handed over to the MQTT library */
+        std::array<std::uint64_t, 3>        bytesOut{};    /*!< payload bytes handed over to the MQTT library */
+        std::map<ReasonCode, std::uint64_t> publishFailures; /*!< rejected publishes per reason, only reasons that
+                                                                occurred */
+        std::uint64_t reconnects{0U};                /*!< connections established after the first one */
+        std::int64_t  dispatchQueueDepth{0};         /*!< messages waiting in dispatch queues */
+        std::int64_t  dispatchQueueHighWaterMark{0}; /*!< maximum of dispatchQueueDepth */
+        IMqttClient::PublishLatencySnapshot messageCallback;        /*!< durations of Callback::MESSAGE, no inFlight */
+        IMqttClient::PublishLatencySnapshot dispatchCallback;       /*!< durations of Callback::DISPATCH, no inFlight */
+        std::chrono::microseconds           messageCallbackSum{0};  /*!< total duration of Callback::MESSAGE */
+        std::chrono::microseconds           dispatchCallbackSum{0}; /*!< total duration of Callback::DISPATCH */
+    };
+
+    /**
+     * @brief Records a message received from the broker.
+     *
+     * @param qos QoS of the message
+     * @param bytes size of the payload
+     */
+    virtual void MessageIn(IMqttMessage::QOS qos, size_t bytes) noexcept = 0;
+
+    /**
+     * @brief Records a message handed over to the MQTT library for publishing.
+     *
+     * @param qos QoS of the message
+     * @param bytes size of the payload
+     */
+    virtual void MessageOut(IMqttMessage::QOS qos, size_t bytes) noexcept = 0;
+
+    /**
+     * @brief Records a publish that was not handed over to the MQTT library.
+     *
+     * @param rc the reason returned to the caller
+     */
+    virtual void PublishFailed(ReasonCode rc) noexcept = 0;
+
+    /**
+     * @brief Records a connection established again, after a client was connected before.
+     *
+     */
+    virtual void Reconnected(void) noexcept = 0;
+
+    /**
+     * @brief Changes the number of messages waiting in dispatch queues.
+     *
+     * @param delta number of messages added, negative for messages removed
+     */
+    virtual void DispatchQueueChanged(std::int64_t delta) noexcept = 0;
+
+    /**
+     * @brief Records the duration of a callback.
+     *
+     * @param callback the callback
+     * @param duration time spent in the callback
+     */
+    virtual void CallbackDuration(Callback callback, std::chrono::microseconds duration) noexcept = 0;
+
+    /**
+     * @brief Returns the metrics recorded so far.
+     *
+     * @return snapshot of the metrics
+     */
+    virtual Snapshot GetSnapshot(void) const = 0;
+
+    /**
+     * @brief Returns the metrics recorded so far in the Prometheus text exposition format, callback durations as
+     * summaries in seconds.
+     *
+     * @param prefix prepended to the metric names, followed by an underscore
+     * @return text to be served e.g. by an HTTP endpoint of the application
+     */
+    virtual std::string ToPrometheus(std::string const& prefix = "imqtt") const = 0;
+};
+
+/**
+ * @brief Used to instantiate an MqttMetrics object behind an IMqttMetrics interface.
+ *
+ */
+class MqttMetricsFactory final {
+public:
+    /**
+     * @brief Generates an MqttMetrics object behind an IMqttMetrics interface. It is shared, as it has to outlive all
+     * clients and dispatch queues using it.
+     *
+     * @return shared pointer to an MqttMetrics object hidden by an abstract IMqttMetrics interface
+     */
+    static std::shared_ptr<IMqttMetrics> Create(void);
+    MqttMetricsFactory() = delete;
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,124 @@
+/**
+ * @file IMqttReactor.h
+ * @author Timo Lange
+ * @brief Event loops driving the network traffic of many IMqttClient instances
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/**
+ * @brief Runs a number of epoll based event loops (one per core by default), each driving the network traffic of many
+ * IMqttClient instances, in order to run thousands of clients without a thread per client. Clients have to be created
+ * with InitializeParameters::externalLoop and are assigned to the loop with the least clients.
+ * The loops send keep alives and reconnect lost connections with exponential backoff. All callbacks of a client are
+ * invoked from the thread of its loop, so they must not block.
+ * Only available on Linux.
+ */
+class IMqttReactor {
+protected:
+    IMqttReactor(void) = default;
+
+public:
+    IMqttReactor(const IMqttReactor&) = delete;
+    IMqttReactor(IMqttReactor&&)      = delete;
+    IMqttReactor& operator=(const IMqttReactor&) = delete;
+    IMqttReactor& operator=(IMqttReactor&&) = delete;
+    void*         operator new[](size_t)    = delete;
+
+    virtual ~IMqttReactor() noexcept = default;
+
+    /**
+     * @brief Parameters of a reactor.
+     *
+     */
+    struct Parameters final {
+        unsigned loops{0U};       /*!< number of event loops (threads), 0 for one per core */
+        bool     pinLoops{false}; /*!< pin each loop to a core, loop i runs on core i modulo the number of cores */
+        std::chrono::milliseconds tickInterval{1000}; /*!< interval of the keep alive handling, has to be well below
+                                                         InitializeParameters::keepAliveInterval */
+        std::chrono::seconds reconnectDelayMin{1};  /*!< delay before the first reconnect attempt */
+        std::chrono::seconds reconnectDelayMax{30}; /*!< the delay is doubled per failed attempt, up to this */
+        std::shared_ptr<IReconnectScheduler> reconnectScheduler{nullptr}; /*!< decides on reconnects instead of the
+                                                                             reconnectDelay parameters, see
+                                                                             IReconnectScheduler.h */
+    };
+
+    /**
+     * @brief State of a single event loop.
+     *
+     */
+    struct LoopStatus final {
+        size_t        clients{0U};    /*!< number of clients assigned to the loop */
+        std::uint64_t events{0U};     /*!< socket events handled */
+        std::uint64_t wakeUps{0U};    /*!< wake ups by clients, which queued data from outside of the loop */
+        std::uint64_t reconnects{0U}; /*!< reconnect attempts started */
+    };
+
+    /**
+     * @brief Assigns a client to the loop with the least clients. The client may be connected before or after.
+     *
+     * @param client the client, has to be created with InitializeParameters::externalLoop, the user is responsible
+     * for keeping it alive until it is removed
+     * @return the IMqttClient ReasonCode, ERROR_GENERAL if the client does not support an external loop or was added
+     * already
+     */
+    virtual ReasonCode Add(IMqttClient& client) = 0;
+
+    /**
+     * @brief Removes a client from its loop and blocks until the loop dropped it. Must not be called from callbacks of
+     * any client of the reactor.
+     *
+     * @param client the client to remove
+     * @return the IMqttClient ReasonCode, ERROR_GENERAL if the client was not added or called from a loop
+     */
+    virtual ReasonCode Remove(IMqttClient& client) = 0;
+
+    /**
+     * @brief Returns the state of all loops.
+     *
+     * @return one entry per loop
+     */
+    virtual std::vector<LoopStatus> GetStatus(void) const = 0;
+};
+
+/**
+ * @brief Used to instantiate a Reactor object behind an IMqttReactor interface.
+ *
+ */
+class MqttReactorFactory final {
+public:
+    /**
+     * @brief Generates a Reactor object behind an IMqttReactor interface and starts its loops. The user is responsible
+     * for object lifetime management, clients still assigned when it is destroyed are no longer driven.
+     *
+     * @param params parameters of the reactor
+     * @param log pointer to an object providing a log callback, may be nullptr if not needed
+     * @return unique pointer to a Reactor object hidden by an abstract IMqttReactor interface
+     */
+    static std::unique_ptr<IMqttReactor> Create(IMqttReactor::Parameters const& params,
+                                                IMqttLogCallbacks const*        log = nullptr);
+    MqttReactorFactory() = delete;
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,108 @@
+/**
+ * @file IMqttTlsContext.h
+ * @author Timo Lange
+ * @brief Interface definition for a TLS context shared by many clients
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+/*This header is only active, when the library is built with TLS support*/
+#ifdef IMQTT_WITH_TLS
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace i_mqtt_client {
+/**
+ * @brief TLS settings, that are loaded once and shared by many clients via InitializeParameters::tlsContext, instead
+ * of every client parsing the same certificates and keys again. TLS sessions negotiated with a broker are cached per
+ * server name, so reconnects, e.g. after a restart of the broker, resume them with an abbreviated handshake.
+ * Only the Mosquitto client makes use of it, Paho creates the TLS settings per connection internally.
+ * All methods are thread-safe.
+ */
+class IMqttTlsContext {
+protected:
+    IMqttTlsContext(void) = default;
+
+public:
+    IMqttTlsContext(const IMqttTlsContext&) = delete;
+    IMqttTlsContext(IMqttTlsContext&&)      = delete;
+    IMqttTlsContext& operator=(const IMqttTlsContext&) = delete;
+    IMqttTlsContext& operator=(IMqttTlsContext&&) = delete;
+    void*            operator new[](size_t)       = delete;
+
+    virtual ~IMqttTlsContext() noexcept = default;
+
+    /**
+     * @brief Parameters of a TLS context.
+     *
+     */
+    struct Parameters final {
+        std::string caFilePath{""};         /*!< path to a file containing a CA certificate */
+        std::string caDirPath{""};          /*!< path to a directory containing CA certificates, if neither this nor
+                                               caFilePath is set, the systems default CA store is used */
+        std::string clientCertFilePath{""}; /*!< path to a file containing the client certificate (chain) */
+        std::string privateKeyFilePath{""}; /*!< path to a file containting the clients private key */
+        std::string privateKeyPassword{""}; /*!< password of the private key, if not encrypted may be empty */
+        size_t      sessionCacheSize{64U};  /*!< number of servers a session is cached for, 0 disables resumption */
+    };
+
+    /**
+     * @brief State of the TLS context.
+     *
+     */
+    struct Status final {
+        std::uint64_t handshakes{0U};     /*!< completed handshakes of all clients */
+        std::uint64_t resumed{0U};        /*!< completed handshakes, that resumed a cached session */
+        size_t        cachedSessions{0U}; /*!< sessions currently cached */
+    };
+
+    /**
+     * @brief Returns the underlying OpenSSL context.
+     *
+     * @return the SSL_CTX
+     */
+    virtual void* NativeHandle(void) const noexcept = 0;
+
+    /**
+     * @brief Returns the state of the TLS context.
+     *
+     * @return snapshot of the TLS context state
+     */
+    virtual Status GetStatus(void) const = 0;
+};
+
+/**
+ * @brief Used to instantiate a TlsContext object behind an IMqttTlsContext interface.
+ *
+ */
+class MqttTlsContextFactory final {
+public:
+    /**
+     * @brief Generates a TlsContext object behind an IMqttTlsContext interface. Certificates and keys are loaded
+     * immediately, a std::runtime_error is thrown, if that fails. It is shared, as it has to outlive all clients using
+     * it.
+     *
+     * @param params parameters of the TLS context
+     * @return shared pointer to a TlsContext object hidden by an abstract IMqttTlsContext interface
+     */
+    static std::shared_ptr<IMqttTlsContext> Create(IMqttTlsContext::Parameters const& params);
+    MqttTlsContextFactory() = delete;
+};
+}  // namespace i_mqtt_client
+#endif
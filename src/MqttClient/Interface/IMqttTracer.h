@@ -0,0 +1,104 @@
+/**
+ * @file IMqttTracer.h
+ * @author Timo Lange
+ * @brief Abstract interface class for tracing the lifecycle of received messages
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <ostream>
+
+#include "IMqttMessage.h"
+
+namespace i_mqtt_client {
+/**
+ * @brief Traces where received messages spend their time: in the callback of the MQTT library, waiting in a dispatch
+ * queue or in the message handler. Clients given the tracer via InitializeParameters::tracer attach an
+ * IMqttMessage::Trace to a share of the received messages, which is completed once the handler returned, either by
+ * the client or by the dispatch queue the message went through. A tracer may be shared by many clients.
+ * All methods are thread-safe.
+ */
+class IMqttTracer {
+protected:
+    IMqttTracer(void) = default;
+
+public:
+    IMqttTracer(const IMqttTracer&) = delete;
+    IMqttTracer(IMqttTracer&&)      = delete;
+    IMqttTracer& operator=(const IMqttTracer&) = delete;
+    IMqttTracer& operator=(IMqttTracer&&) = delete;
+    void*        operator new[](size_t)   = delete;
+
+    virtual ~IMqttTracer() noexcept = default;
+
+    using emit_t = std::function<void(IMqttMessage::Trace const&)>;
+
+    /**
+     * @brief Parameters of a tracer.
+     *
+     */
+    struct Parameters final {
+        double sampleRate{0.01}; /*!< share of the received messages to trace, from 0 to 1, every n-th message is
+                                    traced, such that the share is met */
+        emit_t emit{nullptr};    /*!< invoked with each completed trace, from the thread that ran the handler, so it
+                                    should be quick, see MqttTracerFactory::ChromeTraceWriter */
+    };
+
+    /**
+     * @brief Attaches a trace to a received message, if it is sampled, and stamps IMqttMessage::Trace::received.
+     *
+     * @param msg the message just handed over by the MQTT library
+     */
+    virtual void Sample(IMqttMessage& msg) = 0;
+
+    /**
+     * @brief Hands over a trace to Parameters::emit, once the handler of the message returned.
+     *
+     * @param trace the completed trace
+     */
+    virtual void Complete(IMqttMessage::Trace const& trace) const = 0;
+};
+
+/**
+ * @brief Used to instantiate an MqttTracer object behind an IMqttTracer interface.
+ *
+ */
+class MqttTracerFactory final {
+public:
+    /**
+     * @brief Generates an MqttTracer object behind an IMqttTracer interface. It is shared, as it has to outlive all
+     * clients using it. Throws, if the sample rate is out of range or emit is not set.
+     *
+     * @param params parameters of the tracer
+     * @return shared pointer to an MqttTracer object hidden by an abstract IMqttTracer interface
+     */
+    static std::shared_ptr<IMqttTracer> Create(IMqttTracer::Parameters const& params);
+
+    /**
+     * @brief Returns an emitter writing completed traces as complete events of the Chrome trace event format in the
+     * JSON array format, one row per trace, which can be loaded into chrome://tracing or Perfetto. The closing bracket
+     * is left out, as allowed by the format, such that the output stays valid when the process is killed.
+     *
+     * @param out the stream to write to, has to outlive the tracer
+     * @return emitter to be set as IMqttTracer::Parameters::emit
+     */
+    static IMqttTracer::emit_t ChromeTraceWriter(std::ostream& out);
+    MqttTracerFactory() = delete;
+};
+}  // namespace i_mqtt_client
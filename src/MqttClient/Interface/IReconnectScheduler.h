@@ -0,0 +1,141 @@
+/**
+ * @file IReconnectScheduler.h
+ * @author Timo Lange
+ * @brief Reconnect scheduler shared by many IMqttClient instances
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/**
+ * @brief Decides when clients reconnect after losing their connection. Shared by all clients of a process via
+ * InitializeParameters::reconnectScheduler (or IMqttReactor::Parameters::reconnectScheduler), it spreads reconnects
+ * with exponential backoff and full jitter, redrawn on every attempt, and caps the reconnect attempts per second of
+ * all clients together, so a restarting broker is not hit by waves of reconnects.
+ * It also measures the time clients need to recover from a connection loss.
+ * All methods are thread-safe.
+ */
+class IReconnectScheduler {
+protected:
+    IReconnectScheduler(void) = default;
+
+public:
+    IReconnectScheduler(const IReconnectScheduler&) = delete;
+    IReconnectScheduler(IReconnectScheduler&&)      = delete;
+    IReconnectScheduler& operator=(const IReconnectScheduler&) = delete;
+    IReconnectScheduler& operator=(IReconnectScheduler&&) = delete;
+    void*                operator new[](size_t)           = delete;
+
+    virtual ~IReconnectScheduler() noexcept = default;
+
+    /**
+     * @brief Parameters of a reconnect scheduler.
+     *
+     */
+    struct Parameters final {
+        std::chrono::milliseconds backoffBase{1000}; /*!< upper bound of the delay before the first attempt */
+        std::chrono::milliseconds backoffCap{30000}; /*!< the bound doubles per failed attempt, up to this */
+        bool                      fullJitter{true}; /*!< draw each delay uniformly between 0 and the bound, anew for
+                                                       every attempt, otherwise the bound is used as delay */
+        IMqttClient::TokenBucketParameters connectRate; /*!< cap of the reconnect attempts per second of all clients,
+                                                           up to burst attempts may start at once, 0 disables it */
+    };
+
+    /**
+     * @brief State of the scheduler.
+     *
+     */
+    struct Status final {
+        size_t        disconnected{0U}; /*!< clients currently waiting to recover */
+        std::uint64_t attempts{0U};     /*!< reconnect attempts scheduled */
+        std::uint64_t rateLimited{0U};  /*!< attempts moved to a later time by connectRate */
+        std::uint64_t outages{0U};      /*!< periods with at least one client waiting to recover */
+        std::chrono::milliseconds lastOutage{0}; /*!< duration of the last finished period, from the first client losing
+                                                    its connection until the last one recovered */
+        IMqttClient::PublishLatencySnapshot timeToRecover; /*!< per client time from losing the connection until being
+                                                              connected again, inFlight is the number of clients
+                                                              waiting to recover */
+    };
+
+    /**
+     * @brief Returns the delay until the next reconnect attempt of a client, the attempt is already counted against
+     * Parameters::connectRate. The first call after the client lost its connection starts measuring its time to
+     * recover.
+     * @warning Mosquitto only supports reconnect delays in whole seconds, its clients round the delay up to the next
+     * second and wait at least one second, so delays below one second are not honored by them.
+     *
+     * @param client the client to reconnect
+     * @return the delay to wait before reconnecting
+     */
+    virtual std::chrono::milliseconds NextAttempt(IMqttClient const* client) = 0;
+
+    /**
+     * @brief Like NextAttempt, but invokes the attempt from the thread of the scheduler, once the delay expired. A
+     * pending attempt of the same client is replaced.
+     *
+     * @param client the client to reconnect
+     * @param attempt starts the reconnect, must not block
+     */
+    virtual void ScheduleAttempt(IMqttClient const* client, std::function<void(void)> attempt) = 0;
+
+    /**
+     * @brief Reports that a client is connected again, which finishes measuring its time to recover.
+     *
+     * @param client the client
+     */
+    virtual void Connected(IMqttClient const* client) = 0;
+
+    /**
+     * @brief Drops a client, e.g. as it disconnected on purpose or is destroyed. Cancels its pending attempt and
+     * blocks, while the attempt is being invoked, so it must not be called from within the attempt.
+     *
+     * @param client the client
+     */
+    virtual void Forget(IMqttClient const* client) = 0;
+
+    /**
+     * @brief Returns the state of the scheduler.
+     *
+     * @return snapshot of the scheduler state
+     */
+    virtual Status GetStatus(void) const = 0;
+};
+
+/**
+ * @brief Used to instantiate a ReconnectScheduler object behind an IReconnectScheduler interface.
+ *
+ */
+class ReconnectSchedulerFactory final {
+public:
+    /**
+     * @brief Generates a ReconnectScheduler object behind an IReconnectScheduler interface. It is shared, as it has to
+     * outlive all clients using it.
+     *
+     * @param params parameters of the scheduler
+     * @return shared pointer to a ReconnectScheduler object hidden by an abstract IReconnectScheduler interface
+     */
+    static std::shared_ptr<IReconnectScheduler> Create(IReconnectScheduler::Parameters const& params);
+    ReconnectSchedulerFactory() = delete;
+};
+}  // namespace i_mqtt_client
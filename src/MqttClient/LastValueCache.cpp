@@ -0,0 +1,142 @@
+/**
+ * @file LastValueCache.cpp
+ * @author Timo Lange
+ * @brief Implementation of the in-process cache of the last message per topic
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "LastValueCache.h"
+
+#include "TopicFilter.h"
+
+using namespace std;
+
+namespace i_mqtt_client {
+LastValueCache::LastValueCache(size_t size)
+  : capacity(size)
+{
+}
+
+size_t
+LastValueCache::sizeOf(IMqttMessage const& msg) noexcept
+{
+    auto size{sizeof(IMqttMessage) + msg.topic.size() + msg.payload.size() + msg.correlationDataProps.size() +
+              msg.responseTopic.size() + msg.payloadContentType.size()};
+    for (auto const& prop : msg.userProps) {
+        size += prop.first.size() + prop.second.size();
+    }
+    return size;
+}
+
+upMqttMessage_t
+LastValueCache::copy(IMqttMessage const& msg)
+{
+    auto mqttMsg{MqttMessageFactory::Create(msg.topic, IMqttMessage::payload_t(msg.payload), msg.qos, msg.retain)};
+    mqttMsg->messageId              = msg.messageId;
+    mqttMsg->userProps              = msg.userProps;
+    mqttMsg->correlationDataProps   = msg.correlationDataProps;
+    mqttMsg->responseTopic          = msg.responseTopic;
+    mqttMsg->payloadFormatIndicator = msg.payloadFormatIndicator;
+    mqttMsg->payloadContentType     = msg.payloadContentType;
+    mqttMsg->subscriptionIds        = msg.subscriptionIds;
+    return mqttMsg;
+}
+
+void
+LastValueCache::erase(unordered_map<string, lru_t::iterator>::iterator topic)
+{
+    used -= sizeOf(**topic->second);
+    lru.erase(topic->second);
+    topics.erase(topic);
+}
+
+void
+LastValueCache::Update(IMqttMessage const& msg)
+{
+    auto size{sizeOf(msg)};
+    /*copy outside of the lock*/
+    spMqttMessage_t cached;
+    if (!msg.payload.empty() && size <= capacity) {
+        cached = spMqttMessage_t(copy(msg).release());
+    }
+    lock_guard<mutex> lock(cacheMutex);
+    auto              topic{topics.find(msg.topic)};
+    if (topic != topics.end()) {
+        erase(topic);
+    }
+    if (!cached) {
+        return;
+    }
+    lru.push_front(move(cached));
+    topics[msg.topic] = lru.begin();
+    used += size;
+    while (used > capacity) {
+        erase(topics.find(lru.back()->topic));
+    }
+}
+
+vector<upMqttMessage_t>
+LastValueCache::Match(string const& filter) const
+{
+    auto                    stripped{StripSharePrefix(filter)};
+    vector<spMqttMessage_t> matches;
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        for (auto msg{lru.rbegin()}; msg != lru.rend(); msg++) {
+            if (TopicMatchesFilter(stripped, (*msg)->topic)) {
+                matches.push_back(*msg);
+            }
+        }
+    }
+    /*copy outside of the lock*/
+    vector<upMqttMessage_t> copies;
+    for (auto const& msg : matches) {
+        copies.push_back(copy(*msg));
+    }
+    return copies;
+}
+
+void
+LastValueCache::Subscribed(vector<IMqttClient::TopicSubscription> const& subscribed)
+{
+    lock_guard<mutex> lock(cacheMutex);
+    for (auto const& subscription : subscribed) {
+        subscriptions[subscription.topic] = subscription.qos;
+    }
+}
+
+void
+LastValueCache::Unsubscribed(string const& filter)
+{
+    lock_guard<mutex> lock(cacheMutex);
+    subscriptions.erase(filter);
+}
+
+void
+LastValueCache::Unsubscribed(void)
+{
+    lock_guard<mutex> lock(cacheMutex);
+    subscriptions.clear();
+}
+
+bool
+LastValueCache::IsSubscribed(string const& filter, IMqttMessage::QOS qos) const
+{
+    lock_guard<mutex> lock(cacheMutex);
+    auto              subscription{subscriptions.find(filter)};
+    return subscription != subscriptions.end() && subscription->second >= qos;
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,71 @@
+/**
+ * @file LastValueCache.h
+ * @author Timo Lange
+ * @brief Class definition for the in-process cache of the last message per topic
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/*Keeps a copy of the last message received per topic, bounded by the size of topics and payloads. Topics updated least
+ * recently are evicted first. Also keeps track of the topic filters subscribed at the broker, such that later local
+ * subscribers can share the subscription and be answered from the cache instead.*/
+class LastValueCache final {
+public:
+    using spMqttMessage_t = std::shared_ptr<IMqttMessage const>;
+
+private:
+    using lru_t = std::list<spMqttMessage_t>;
+
+    size_t const capacity;
+
+    mutable std::mutex                                 cacheMutex;
+    lru_t                                              lru; /*most recently updated first*/
+    std::unordered_map<std::string, lru_t::iterator>   topics;
+    std::unordered_map<std::string, IMqttMessage::QOS> subscriptions;
+    size_t                                             used{0U};
+
+    static size_t          sizeOf(IMqttMessage const&) noexcept;
+    static upMqttMessage_t copy(IMqttMessage const&);
+    void                   erase(std::unordered_map<std::string, lru_t::iterator>::iterator);
+
+public:
+    explicit LastValueCache(size_t capacity);
+
+    /*stores a copy of the message, an empty payload removes the topic, as for retained messages*/
+    void Update(IMqttMessage const&);
+    /*returns copies of the cached messages matching the topic filter, least recently updated first, to be delivered
+     * like received messages*/
+    std::vector<upMqttMessage_t> Match(std::string const& filter) const;
+
+    void Subscribed(std::vector<IMqttClient::TopicSubscription> const&);
+    void Unsubscribed(std::string const& filter);
+    /*forgets all subscriptions, e.g. when the session was lost*/
+    void Unsubscribed(void);
+    /*returns true, if the filter is subscribed at the broker with at least the given Quality of Service*/
+    bool IsSubscribed(std::string const& filter, IMqttMessage::QOS) const;
+};
+}  // namespace i_mqtt_client
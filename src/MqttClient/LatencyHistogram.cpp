@@ -0,0 +1,117 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @author Timo Lange
+ * @brief Implementation of a lock-free latency histogram
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "LatencyHistogram.h"
+
+#include <cmath>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+LatencyHistogram::LatencyHistogram(void) noexcept
+{
+    for (auto& bucket : buckets) {
+        bucket.store(0U, memory_order_relaxed);
+    }
+}
+
+unsigned
+LatencyHistogram::bucketIndex(uint64_t value) noexcept
+{
+    if (value < subBucketCount) {
+        return static_cast<unsigned>(value);
+    }
+    auto magnitude{static_cast<unsigned>(63 - __builtin_clzll(value))};
+    if (magnitude >= magnitudeCount) {
+        return bucketCount - 1U;
+    }
+    auto shift{magnitude - subBucketBits};
+    return subBucketCount * (shift + 1U) + static_cast<unsigned>((value >> shift) & (subBucketCount - 1U));
+}
+
+uint64_t
+LatencyHistogram::bucketValue(unsigned index) noexcept
+{
+    if (index < subBucketCount) {
+        return index;
+    }
+    auto shift{index / subBucketCount - 1U};
+    auto lower{static_cast<uint64_t>(subBucketCount + index % subBucketCount) << shift};
+    /*highest value that falls into the bucket*/
+    return lower + (uint64_t{1U} << shift) - 1U;
+}
+
+void
+LatencyHistogram::Record(microseconds latency) noexcept
+{
+    auto value{static_cast<uint64_t>(max(latency.count(), microseconds::rep{0}))};
+    buckets[bucketIndex(value)].fetch_add(1U, memory_order_relaxed);
+    recordSum.fetch_add(value, memory_order_relaxed);
+    auto current{recordMin.load(memory_order_relaxed)};
+    while (value < current && !recordMin.compare_exchange_weak(current, value, memory_order_relaxed)) {
+    }
+    current = recordMax.load(memory_order_relaxed);
+    while (value > current && !recordMax.compare_exchange_weak(current, value, memory_order_relaxed)) {
+    }
+    recordCount.fetch_add(1U, memory_order_release);
+}
+
+void
+LatencyHistogram::Snapshot(IMqttClient::PublishLatencySnapshot& snapshot) const noexcept
+{
+    snapshot.completed = recordCount.load(memory_order_acquire);
+    if (!snapshot.completed) {
+        return;
+    }
+    snapshot.min  = microseconds(recordMin.load(memory_order_relaxed));
+    snapshot.max  = microseconds(recordMax.load(memory_order_relaxed));
+    snapshot.mean = microseconds(recordSum.load(memory_order_relaxed) / snapshot.completed);
+
+    /*buckets are read one by one while recording may go on, so the total is taken from the buckets themselves*/
+    array<uint64_t, bucketCount> counts;
+    uint64_t                     total{0U};
+    for (unsigned i{0U}; i < bucketCount; i++) {
+        counts[i] = buckets[i].load(memory_order_relaxed);
+        total += counts[i];
+    }
+    auto percentile = [&](double p) {
+        auto     target{static_cast<uint64_t>(ceil(p * static_cast<double>(total)))};
+        uint64_t seen{0U};
+        for (unsigned i{0U}; i < bucketCount; i++) {
+            seen += counts[i];
+            if (seen >= target && seen > 0U) {
+                return microseconds(std::min(bucketValue(i), static_cast<uint64_t>(snapshot.max.count())));
+            }
+        }
+        return snapshot.max;
+    };
+    snapshot.p50  = percentile(0.5);
+    snapshot.p90  = percentile(0.9);
+    snapshot.p99  = percentile(0.99);
+    snapshot.p999 = percentile(0.999);
+}
+
+microseconds
+LatencyHistogram::Sum(void) const noexcept
+{
+    return microseconds(recordSum.load(memory_order_relaxed));
+}
+}  // namespace i_mqtt_client
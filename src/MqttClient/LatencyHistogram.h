@@ -0,0 +1,57 @@
+/**
+ * @file LatencyHistogram.h
+ * @author Timo Lange
+ * @brief Class definition for a lock-free latency histogram
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/*Log-linear histogram in the style of HdrHistogram: each power of two range is split into 16 linear sub-buckets,
+ * which gives a relative precision of about 6 percent. Recording and reading are lock-free.*/
+class LatencyHistogram final {
+private:
+    static constexpr unsigned subBucketBits{4U};
+    static constexpr unsigned subBucketCount{1U << subBucketBits};
+    static constexpr unsigned magnitudeCount{36U}; /*covers up to ~19 hours in microseconds*/
+    static constexpr unsigned bucketCount{subBucketCount * (magnitudeCount - subBucketBits + 1U)};
+
+    std::array<std::atomic<std::uint64_t>, bucketCount> buckets;
+    std::atomic<std::uint64_t>                          recordCount{0U};
+    std::atomic<std::uint64_t>                          recordSum{0U};
+    std::atomic<std::uint64_t>                          recordMin{UINT64_MAX};
+    std::atomic<std::uint64_t>                          recordMax{0U};
+
+    static unsigned      bucketIndex(std::uint64_t) noexcept;
+    static std::uint64_t bucketValue(unsigned) noexcept;
+
+public:
+    LatencyHistogram(void) noexcept;
+
+    void Record(std::chrono::microseconds) noexcept;
+    /*fills all fields except inFlight*/
+    void                      Snapshot(IMqttClient::PublishLatencySnapshot&) const noexcept;
+    std::chrono::microseconds Sum(void) const noexcept;
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,276 @@
+/**
+ * @file LoopbackBroker.cpp
+ * @author Timo Lange
+ * @brief Implementation of the in-process broker of the loopback client
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "LoopbackBroker.h"
+
+#include <algorithm>
+
+#include "LoopbackClient.h"
+#include "TopicFilter.h"
+
+using namespace std;
+
+namespace i_mqtt_client {
+mutex                                 LoopbackBroker::registryMutex;
+map<string, weak_ptr<LoopbackBroker>> LoopbackBroker::registry;
+
+static bool
+isValidFilter(string const& filter) noexcept
+{
+    if (filter.empty()) {
+        return false;
+    }
+    for (size_t i{0U}; i < filter.size(); i++) {
+        /*wildcards have to occupy an entire level, '#' has to be the last one*/
+        auto levelBegin{0U == i || '/' == filter[i - 1U]};
+        auto levelEnd{filter.size() - 1U == i || '/' == filter[i + 1U]};
+        if (('+' == filter[i] && (!levelBegin || !levelEnd)) ||
+            ('#' == filter[i] && (!levelBegin || filter.size() - 1U != i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+shared_ptr<LoopbackBroker>
+LoopbackBroker::Get(string const& hostAddress, int port)
+{
+    lock_guard<mutex> lock(registryMutex);
+    auto&             entry = registry[hostAddress + ":" + to_string(port)];
+    auto              broker{entry.lock()};
+    if (!broker) {
+        broker = make_shared<LoopbackBroker>();
+        entry  = broker;
+    }
+    return broker;
+}
+
+upMqttMessage_t
+LoopbackBroker::copyMessage(IMqttMessage const& msg, IMqttMessage::QOS qos, bool retain)
+{
+    auto copy{MqttMessageFactory::Create(
+        string(msg.topic), vector<IMqttMessage::payloadRaw_t>(msg.payload.begin(), msg.payload.end()), qos, retain)};
+    copy->userProps              = msg.userProps;
+    copy->correlationDataProps   = msg.correlationDataProps;
+    copy->responseTopic          = msg.responseTopic;
+    copy->payloadContentType     = msg.payloadContentType;
+    copy->payloadFormatIndicator = msg.payloadFormatIndicator;
+    return copy;
+}
+
+void
+LoopbackBroker::deliver(Session&                        session,
+                        IMqttMessage const&             msg,
+                        IMqttMessage::QOS               qos,
+                        bool                            retain,
+                        IMqttMessage::subscriptionIds_t subscriptionIds)
+{
+    auto copy{copyMessage(msg, qos, retain)};
+    if (IMqttMessage::QOS::QOS_0 != qos) {
+        session.lastMessageId = session.lastMessageId % 0xFFFF + 1;
+        copy->messageId       = session.lastMessageId;
+    }
+    copy->subscriptionIds = move(subscriptionIds);
+    session.client->OnMessage(move(copy));
+}
+
+void
+LoopbackBroker::Connect(LoopbackClient& client, string const& clientId, bool cleanStart)
+{
+    lock_guard<mutex> lock(brokerMutex);
+    auto              existing{sessions.find(clientId)};
+    auto              sessionPresent{existing != sessions.end() && !cleanStart};
+    if (existing != sessions.end() && existing->second.client && existing->second.client != &client) {
+        existing->second.client->OnDisconnect(Mqtt5ReasonCode::SESSION_TAKEN_OVER);
+    }
+    if (!sessionPresent) {
+        sessions[clientId] = Session();
+    }
+    sessions[clientId].client = &client;
+    client.OnConnAck(sessionPresent);
+}
+
+bool
+LoopbackBroker::Disconnect(LoopbackClient& client, string const& clientId, bool cleanSession)
+{
+    lock_guard<mutex> lock(brokerMutex);
+    auto              session{sessions.find(clientId)};
+    if (session == sessions.end() || session->second.client != &client) {
+        return false;
+    }
+    if (cleanSession) {
+        sessions.erase(session);
+    }
+    else {
+        session->second.client = nullptr;
+    }
+    return true;
+}
+
+bool
+LoopbackBroker::Subscribe(LoopbackClient&                             client,
+                          string const&                               clientId,
+                          vector<IMqttClient::TopicSubscription> const& subscriptions,
+                          uint32_t                                    subscriptionId,
+                          bool                                        noLocal,
+                          int                                         token)
+{
+    lock_guard<mutex> lock(brokerMutex);
+    auto              session{sessions.find(clientId)};
+    if (session == sessions.end() || session->second.client != &client) {
+        return false;
+    }
+    auto&                   subscribed = session->second.subscriptions;
+    vector<Mqtt5ReasonCode> rcs;
+    for (auto const& subscription : subscriptions) {
+        Subscription entry;
+        entry.filter         = subscription.topic;
+        entry.match          = StripSharePrefix(subscription.topic);
+        entry.qos            = subscription.qos;
+        entry.noLocal        = noLocal && entry.match == entry.filter; /*not allowed for shared subscriptions*/
+        entry.subscriptionId = subscriptionId;
+        if (!isValidFilter(entry.match)) {
+            rcs.push_back(Mqtt5ReasonCode::TOPIC_FILTER_INVALID);
+            continue;
+        }
+        rcs.push_back(static_cast<Mqtt5ReasonCode>(subscription.qos));
+        auto existing{find_if(subscribed.begin(), subscribed.end(), [&entry](Subscription const& s) {
+            return s.filter == entry.filter;
+        })};
+        if (existing != subscribed.end()) {
+            *existing = entry;
+        }
+        else {
+            subscribed.push_back(entry);
+        }
+    }
+    client.OnSubscribeAck(token, rcs);
+    /*retained messages are sent after the SUBACK, but not to shared subscriptions*/
+    for (size_t i{0U}; i < subscriptions.size(); i++) {
+        if (!subscriptions[i].getRetained || rcs[i] >= Mqtt5ReasonCode::UNSPECIFIED_ERROR ||
+            StripSharePrefix(subscriptions[i].topic) != subscriptions[i].topic) {
+            continue;
+        }
+        for (auto const& msg : retained) {
+            if (TopicMatchesFilter(subscriptions[i].topic, msg.first)) {
+                deliver(session->second,
+                        *msg.second,
+                        min(msg.second->qos, subscriptions[i].qos),
+                        true,
+                        subscriptionId ? IMqttMessage::subscriptionIds_t{subscriptionId}
+                                       : IMqttMessage::subscriptionIds_t());
+            }
+        }
+    }
+    return true;
+}
+
+bool
+LoopbackBroker::UnSubscribe(LoopbackClient& client, string const& clientId, vector<string> const& topics, int token)
+{
+    lock_guard<mutex> lock(brokerMutex);
+    auto              session{sessions.find(clientId)};
+    if (session == sessions.end() || session->second.client != &client) {
+        return false;
+    }
+    auto&                   subscribed = session->second.subscriptions;
+    vector<Mqtt5ReasonCode> rcs;
+    for (auto const& topic : topics) {
+        auto existing{find_if(subscribed.begin(), subscribed.end(), [&topic](Subscription const& s) {
+            return s.filter == topic;
+        })};
+        if (existing == subscribed.end()) {
+            rcs.push_back(Mqtt5ReasonCode::NO_SUBSCRIPTION_EXISTS);
+            continue;
+        }
+        subscribed.erase(existing);
+        rcs.push_back(Mqtt5ReasonCode::SUCCESS);
+    }
+    client.OnUnSubscribeAck(token, rcs);
+    return true;
+}
+
+bool
+LoopbackBroker::Publish(LoopbackClient& client, string const& clientId, IMqttMessage const& msg, int token)
+{
+    /*one delivery per client, with the highest QoS and all identifiers of its matching subscriptions*/
+    struct Target final {
+        IMqttMessage::QOS               qos{IMqttMessage::QOS::QOS_0};
+        IMqttMessage::subscriptionIds_t subscriptionIds;
+    };
+    lock_guard<mutex> lock(brokerMutex);
+    auto              sender{sessions.find(clientId)};
+    if (sender == sessions.end() || sender->second.client != &client) {
+        return false;
+    }
+    if (msg.retain) {
+        if (msg.payload.empty()) {
+            retained.erase(msg.topic);
+        }
+        else {
+            retained[msg.topic] = copyMessage(msg, msg.qos, true);
+        }
+    }
+
+    map<string, Target>                                    targets;
+    map<string, vector<pair<string, Subscription const*>>> shared;
+    for (auto& session : sessions) {
+        for (auto const& subscription : session.second.subscriptions) {
+            if (!TopicMatchesFilter(subscription.match, msg.topic)) {
+                continue;
+            }
+            if (subscription.match != subscription.filter) {
+                /*offline members of a shared subscription do not get messages of the group*/
+                if (session.second.client) {
+                    shared[subscription.filter].push_back(make_pair(session.first, &subscription));
+                }
+                continue;
+            }
+            if (!session.second.client || (subscription.noLocal && session.first == clientId)) {
+                continue;
+            }
+            auto& target = targets[session.first];
+            target.qos   = max(target.qos, subscription.qos);
+            if (subscription.subscriptionId) {
+                target.subscriptionIds.push_back(subscription.subscriptionId);
+            }
+        }
+    }
+    /*each shared subscription delivers to one of its members, in turns*/
+    for (auto const& group : shared) {
+        auto& cursor = shareCursors[group.first];
+        auto& member = group.second[cursor++ % group.second.size()];
+        auto& target = targets[member.first];
+        target.qos   = max(target.qos, member.second->qos);
+        if (member.second->subscriptionId) {
+            target.subscriptionIds.push_back(member.second->subscriptionId);
+        }
+    }
+    for (auto& target : targets) {
+        auto qos{min(msg.qos, target.second.qos)};
+        deliver(sessions[target.first], msg, qos, false, move(target.second.subscriptionIds));
+    }
+    client.OnPublishAck(token,
+                        IMqttMessage::QOS::QOS_0 == msg.qos || !targets.empty()
+                            ? Mqtt5ReasonCode::SUCCESS
+                            : Mqtt5ReasonCode::NO_MATCHING_SUBSCRIBERS);
+    return true;
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,84 @@
+/**
+ * @file LoopbackBroker.h
+ * @author Timo Lange
+ * @brief Class definition for the in-process broker of the loopback client
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+class LoopbackClient;
+
+/*Broker living in the process, shared by all loopback clients using the same broker address and port. It matches
+ * topics, acknowledges publishes and keeps retained messages and sessions, as long as at least one client uses it.
+ * Everything is handed over to the clients under the lock of the broker, such that each client receives its events in
+ * the order the broker processed them.*/
+class LoopbackBroker final {
+private:
+    struct Subscription final {
+        std::string       filter; /*as subscribed, including a "$share/<group>/" prefix*/
+        std::string       match;  /*the filter matched against topics*/
+        IMqttMessage::QOS qos{IMqttMessage::QOS::QOS_0};
+        bool              noLocal{false};
+        std::uint32_t     subscriptionId{0U};
+    };
+
+    struct Session final {
+        LoopbackClient*           client{nullptr}; /*nullptr, while the client is not connected*/
+        std::vector<Subscription> subscriptions;
+        int                       lastMessageId{0};
+    };
+
+    static std::mutex                                           registryMutex;
+    static std::map<std::string, std::weak_ptr<LoopbackBroker>> registry;
+
+    std::mutex                              brokerMutex;
+    std::map<std::string, Session>          sessions; /*ordered, to deliver in a deterministic order*/
+    std::map<std::string, upMqttMessage_t>  retained;
+    std::unordered_map<std::string, size_t> shareCursors; /*round robin per shared subscription*/
+
+    static upMqttMessage_t copyMessage(IMqttMessage const&, IMqttMessage::QOS, bool retain);
+
+    /*hands a copy of the message over to the connected client of the session*/
+    void deliver(Session&, IMqttMessage const&, IMqttMessage::QOS, bool retain, IMqttMessage::subscriptionIds_t);
+
+public:
+    /*returns the broker of the given address, creates it if nobody uses it yet*/
+    static std::shared_ptr<LoopbackBroker> Get(std::string const& hostAddress, int port);
+
+    void Connect(LoopbackClient&, std::string const& clientId, bool cleanStart);
+    bool Disconnect(LoopbackClient&, std::string const& clientId, bool cleanSession);
+    bool Subscribe(LoopbackClient&,
+                   std::string const& clientId,
+                   std::vector<IMqttClient::TopicSubscription> const&,
+                   std::uint32_t subscriptionId,
+                   bool          noLocal,
+                   int           token);
+    bool UnSubscribe(LoopbackClient&, std::string const& clientId, std::vector<std::string> const&, int token);
+    bool Publish(LoopbackClient&, std::string const& clientId, IMqttMessage const&, int token);
+};
+}  // namespace i_mqtt_client
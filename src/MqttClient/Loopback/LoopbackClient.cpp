@@ -0,0 +1,234 @@
+/**
+ * @file LoopbackClient.cpp
+ * @author Timo Lange
+ * @brief Implementation of the IMqttClient connected to an in-process broker
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "LoopbackClient.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace i_mqtt_client {
+LoopbackClient::LoopbackClient(IMqttClient::InitializeParameters const& parameters,
+                               IMqttMessageCallbacks const*             msg,
+                               IMqttLogCallbacks const*                 log,
+                               IMqttCommandCallbacks const*             cmd,
+                               IMqttConnectionCallbacks const*          con)
+  : MqttClientBase(parameters, msg, log, cmd, con)
+  , broker(LoopbackBroker::Get(params.hostAddress, params.port))
+{
+    libVersion = "loopback client";
+    logCb->Log<LogLevel::INFO>([] { return "Initializing loopback client"; });
+    logCb->Log<LogLevel::INFO>([&] { return "Broker-Address: " + params.hostAddress + ":" + to_string(params.port); });
+    eventThread = thread(&LoopbackClient::eventWorker, this);
+}
+
+LoopbackClient::~LoopbackClient() noexcept
+{
+    stopPublishing();
+    logCb->Log<LogLevel::INFO>([] { return "Deinitializing loopback client"; });
+    /*afterwards, the broker does not know this client any more*/
+    (void)broker->Disconnect(*this, params.clientId, params.cleanSession);
+    {
+        lock_guard<mutex> lock(eventMutex);
+        eventExit = true;
+    }
+    eventAwaiter.notify_all();
+    if (eventThread.joinable()) {
+        eventThread.join();
+    }
+}
+
+int
+LoopbackClient::nextToken(void) noexcept
+{
+    /*tokens are limited to the range of MQTT packet identifiers, like with the MQTT libraries*/
+    return static_cast<int>(static_cast<unsigned>(lastToken++) % 0xFFFFU) + 1;
+}
+
+void
+LoopbackClient::post(event_t event)
+{
+    {
+        lock_guard<mutex> lock(eventMutex);
+        events.push_back(move(event));
+    }
+    eventAwaiter.notify_one();
+}
+
+void
+LoopbackClient::eventWorker(void)
+{
+    unique_lock<mutex> lock(eventMutex);
+    while (!eventExit) {
+        if (events.empty()) {
+            eventAwaiter.wait(lock, [this] { return eventExit || !events.empty(); });
+            continue;
+        }
+        auto event{move(events.front())};
+        events.pop_front();
+        lock.unlock();
+        event();
+        lock.lock();
+    }
+}
+
+ReasonCode
+LoopbackClient::ConnectAsync(void)
+{
+    logCb->Log<LogLevel::INFO>([&] {
+        return "Connecting to loopback broker: " + params.hostAddress + ":" + to_string(params.port);
+    });
+    broker->Connect(*this, params.clientId, params.cleanSession);
+    return ReasonCode::OKAY;
+}
+
+ReasonCode
+LoopbackClient::DisconnectAsync(Mqtt5ReasonCode rc)
+{
+    logCb->Log<LogLevel::INFO>([] { return "Disconnecting from loopback broker"; });
+    if (!broker->Disconnect(*this, params.clientId, params.cleanSession)) {
+        logCb->Log<LogLevel::WARNING>([] { return "Loopback client is not connected"; });
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    connected = false;
+    post([this, rc] { notifyDisconnected(rc); });
+    return ReasonCode::OKAY;
+}
+
+ReasonCode
+LoopbackClient::subscribe(vector<TopicSubscription> const& subscriptions, uint32_t subscriptionId, int* token)
+{
+    for (auto const& subscription : subscriptions) {
+        logCb->Log<LogLevel::DEBUG>([&] { return "Subscribing to topic: \"" + subscription.topic + "\""; });
+    }
+    auto id{nextToken()};
+    if (token) {
+        *token = id;
+    }
+    if (!broker->Subscribe(*this, params.clientId, subscriptions, subscriptionId, !params.allowLocalTopics, id)) {
+        logCb->Log<LogLevel::WARNING>([] { return "Loopback client is not connected"; });
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    return ReasonCode::OKAY;
+}
+
+ReasonCode
+LoopbackClient::unSubscribe(vector<string> const& topics, int* token)
+{
+    for (auto const& topic : topics) {
+        logCb->Log<LogLevel::DEBUG>([&] { return "Unsubscribing from topic: \"" + topic + "\""; });
+    }
+    auto id{nextToken()};
+    if (token) {
+        *token = id;
+    }
+    if (!broker->UnSubscribe(*this, params.clientId, topics, id)) {
+        logCb->Log<LogLevel::WARNING>([] { return "Loopback client is not connected"; });
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    return ReasonCode::OKAY;
+}
+
+ReasonCode
+LoopbackClient::publish(upMqttMessage_t mqttMsg, int* token)
+{
+    logCb->Log<LogLevel::DEBUG>([&] { return "Publishing to topic: \"" + mqttMsg->topic + "\""; });
+    if (mqttMsg->topic.empty() || mqttMsg->topic.find_first_of("+#") != string::npos) {
+        logCb->Log<LogLevel::ERROR>([&] { return "Invalid topic: \"" + mqttMsg->topic + "\" - ignoring message"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    auto id{nextToken()};
+    if (token) {
+        *token = id;
+    }
+    if (!broker->Publish(*this, params.clientId, *mqttMsg, id)) {
+        logCb->Log<LogLevel::WARNING>([] { return "Loopback client is not connected"; });
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    return ReasonCode::OKAY;
+}
+
+bool
+LoopbackClient::IsConnected(void) const noexcept
+{
+    return connected;
+}
+
+void
+LoopbackClient::OnConnAck(bool sessionPresent)
+{
+    connected = true;
+    post([this, sessionPresent] {
+        logCb->Log<LogLevel::INFO>([] { return "Loopback client connected to broker"; });
+        notifyConnected(Mqtt5ReasonCode::SUCCESS, sessionPresent);
+    });
+}
+
+void
+LoopbackClient::OnDisconnect(Mqtt5ReasonCode rc)
+{
+    connected = false;
+    post([this, rc] {
+        logCb->Log<LogLevel::WARNING>([&] {
+            return "Loopback client disconnected by broker, rc: " + Mqtt5ReasonCodeToStringRepr(rc).first;
+        });
+        notifyDisconnected(rc);
+    });
+}
+
+void
+LoopbackClient::OnMessage(upMqttMessage_t mqttMsg)
+{
+    /*std::function requires copyable targets, so the message is handed over as shared_ptr*/
+    shared_ptr<upMqttMessage_t> msg{make_shared<upMqttMessage_t>(move(mqttMsg))};
+    post([this, msg] {
+        logCb->Log<LogLevel::DEBUG>([] { return "Loopback client received message"; });
+        notifyMessage(move(*msg));
+    });
+}
+
+void
+LoopbackClient::OnPublishAck(int token, Mqtt5ReasonCode rc)
+{
+    post([this, token, rc] { notifyPublish(token, rc); });
+}
+
+void
+LoopbackClient::OnSubscribeAck(int token, vector<Mqtt5ReasonCode> rcs)
+{
+    post([this, token, rcs] {
+        auto failed{all_of(rcs.begin(), rcs.end(), [](Mqtt5ReasonCode rc) {
+            return rc >= Mqtt5ReasonCode::UNSPECIFIED_ERROR;
+        })};
+        if (failed) {
+            notifySubscribeFailure(token, rcs);
+        }
+        else {
+            notifySubscribe(token, rcs);
+        }
+    });
+}
+
+void
+LoopbackClient::OnUnSubscribeAck(int token, vector<Mqtt5ReasonCode> rcs)
+{
+    post([this, token, rcs] { notifyUnSubscribe(token, rcs); });
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,80 @@
+/**
+ * @file LoopbackClient.h
+ * @author Timo Lange
+ * @brief Class definition for the IMqttClient connected to an in-process broker
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "LoopbackBroker.h"
+#include "MqttClientBase.h"
+
+namespace i_mqtt_client {
+/*Implements IMqttClient without any network, against the LoopbackBroker of InitializeParameters::hostAddress and port.
+ * Everything the broker reports is handed over to the callbacks by a thread of the client, like the network thread of
+ * an MQTT library would.*/
+class LoopbackClient : public MqttClientBase {
+private:
+    using event_t = std::function<void(void)>;
+
+    std::shared_ptr<LoopbackBroker> const broker;
+    std::atomic_bool                      connected{false};
+    std::atomic_int                       lastToken{0};
+
+    std::mutex              eventMutex;
+    std::condition_variable eventAwaiter;
+    std::deque<event_t>     events;
+    bool                    eventExit{false};
+    std::thread             eventThread;
+
+    int  nextToken(void) noexcept;
+    void post(event_t);
+    void eventWorker(void);
+
+    ReasonCode ConnectAsync(void) override;
+    ReasonCode DisconnectAsync(Mqtt5ReasonCode) override;
+    ReasonCode subscribe(std::vector<TopicSubscription> const&, std::uint32_t, int*) override;
+    ReasonCode unSubscribe(std::vector<std::string> const&, int*) override;
+    ReasonCode publish(upMqttMessage_t, int*) override;
+    bool       IsConnected(void) const noexcept override;
+
+public:
+    LoopbackClient(IMqttClient::InitializeParameters const&,
+                   IMqttMessageCallbacks const*,
+                   IMqttLogCallbacks const*,
+                   IMqttCommandCallbacks const*,
+                   IMqttConnectionCallbacks const*);
+    virtual ~LoopbackClient() noexcept;
+
+    /*invoked by the broker, while it is locked*/
+    void OnConnAck(bool sessionPresent);
+    void OnDisconnect(Mqtt5ReasonCode);
+    void OnMessage(upMqttMessage_t);
+    void OnPublishAck(int token, Mqtt5ReasonCode);
+    void OnSubscribeAck(int token, std::vector<Mqtt5ReasonCode>);
+    void OnUnSubscribeAck(int token, std::vector<Mqtt5ReasonCode>);
+};
+}  // namespace i_mqtt_client
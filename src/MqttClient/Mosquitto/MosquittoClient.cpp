@@ -25,9 +25,15 @@
 #include "openssl/ssl.h"
 #endif
 
+#include <algorithm>
+#include <map>
 #include <stdexcept>
 
+#include "IMqttTlsContext.h"
+#include "IReconnectScheduler.h"
+
 using namespace std;
+using namespace std::chrono;
 
 namespace i_mqtt_client {
 atomic_uint MosquittoClient::counter{0UL};
@@ -38,31 +44,30 @@ MosquittoClient::MosquittoClient(IMqttClient::InitializeParameters const& parame
                                  IMqttLogCallbacks const*                 log,
                                  IMqttCommandCallbacks const*             cmd,
                                  IMqttConnectionCallbacks const*          con)
-  : IMqttClient(log, cmd, msg, con)
-  , params(parameters)
+  : MqttClientBase(parameters, msg, log, cmd, con)
 {
     auto rc{static_cast<int>(MOSQ_ERR_SUCCESS)};
     {
         lock_guard<mutex> lock(libMutex);
         // Init lib, if nobody ever did
         if (counter.fetch_add(1) == 0) {
-            logCb->Log(LogLevel::INFO, "Initializing mosquitto lib");
+            logCb->Log<LogLevel::INFO>([] { return "Initializing mosquitto lib"; });
             rc = mosquitto_lib_init();
             if (MOSQ_ERR_SUCCESS != rc) {
                 throw runtime_error("Was not able to initialize mosquitto lib: " + string(mosquitto_strerror(rc)));
             }
-            int major{0};
-            int minor{0};
-            int patch{0};
-            int vers   = mosquitto_lib_version(&major, &minor, &patch);
-            libVersion = "libmosquitto " + to_string(major) + "." + to_string(minor) + "." + to_string(patch) + " (" +
-                         to_string(vers) + ")";
         }
     }  // unlock mutex, from here everything is instance specific
+    int major{0};
+    int minor{0};
+    int patch{0};
+    int vers   = mosquitto_lib_version(&major, &minor, &patch);
+    libVersion = "libmosquitto " + to_string(major) + "." + to_string(minor) + "." + to_string(patch) + " (" +
+                 to_string(vers) + ")";
 
     // Init instance
-    logCb->Log(LogLevel::INFO, "Initializing mosquitto instance");
-    logCb->Log(LogLevel::INFO, "Broker-Address: " + params.hostAddress + ":" + to_string(params.port));
+    logCb->Log<LogLevel::INFO>([] { return "Initializing mosquitto instance"; });
+    logCb->Log<LogLevel::INFO>([&] { return "Broker-Address: " + params.hostAddress + ":" + to_string(params.port); });
     pMosqClient = mosquitto_new(params.clientId.c_str(), params.cleanSession, this);
 
     if (params.reconnectDelayMinLower < 0 || params.reconnectDelayMinUpper < 0 ||
@@ -88,9 +93,11 @@ MosquittoClient::MosquittoClient(IMqttClient::InitializeParameters const& parame
     auto reconnMin{
         params.reconnectDelayMin +
         uniform_int_distribution<int>(params.reconnectDelayMinLower, params.reconnectDelayMinUpper)(rndGenerator)};
-    logCb->Log(LogLevel::DEBUG,
-               "Reconnect delay min: " + to_string(reconnMin) + "," + " max: " + to_string(params.reconnectDelayMax));
-    rc = mosquitto_reconnect_delay_set(pMosqClient, reconnMin, params.reconnectDelayMax, params.exponentialBackoff);
+    logCb->Log<LogLevel::DEBUG>([&] {
+        return "Reconnect delay min: " + to_string(reconnMin) + "," + " max: " + to_string(params.reconnectDelayMax);
+    });
+    rc = mosquitto_reconnect_delay_set(
+        pMosqClient, reconnMin, params.reconnectDelayMax, params.mosquitto.exponentialBackoff);
     if (MOSQ_ERR_SUCCESS != rc) {
         throw runtime_error("Was not able to set reconnect delay: " + string(mosquitto_strerror(rc)));
     }
@@ -134,29 +141,58 @@ MosquittoClient::MosquittoClient(IMqttClient::InitializeParameters const& parame
             static_cast<MosquittoClient*>(pThis)->onUnSubscribeCb(pClient, messageId, pProps);
         });
 #ifdef IMQTT_WITH_TLS
-    rc = mosquitto_tls_set(
-        pMosqClient,
-        params.caFilePath.empty() ? nullptr : params.caFilePath.c_str(),
-        params.caDirPath.empty() ? nullptr : params.caDirPath.c_str(),
-        params.clientCertFilePath.empty() ? nullptr : params.clientCertFilePath.c_str(),
-        params.privateKeyFilePath.empty() ? nullptr : params.privateKeyFilePath.c_str(),
-        [](char* buf, int size, int rwflag, void* pClient) -> int {
-            if (rwflag != 0) {
-                return static_cast<int>(
-                    static_cast<MosquittoClient*>(mosquitto_userdata(static_cast<struct mosquitto*>(pClient)))
-                        ->params.privateKeyPassword.copy(buf, size));
-            }
-            return 0;
-        });
-    if (MOSQ_ERR_SUCCESS != rc) {
-        throw runtime_error("Was not able to set TLS settings: " + string(mosquitto_strerror(rc)));
+    if (params.tlsContext) {
+        logCb->Log<LogLevel::INFO>([] { return "Using shared TLS context"; });
+        /*mosquitto takes its own reference of the context*/
+        rc = mosquitto_void_option(pMosqClient, MOSQ_OPT_SSL_CTX, params.tlsContext->NativeHandle());
+        if (MOSQ_ERR_SUCCESS != rc) {
+            throw runtime_error("Was not able to set TLS context: " + string(mosquitto_strerror(rc)));
+        }
+        /*the context is set up completely already, mosquitto must not apply its defaults*/
+        rc = mosquitto_int_option(pMosqClient, MOSQ_OPT_SSL_CTX_WITH_DEFAULTS, 0);
+        if (MOSQ_ERR_SUCCESS != rc) {
+            throw runtime_error("Was not able to set TLS context options: " + string(mosquitto_strerror(rc)));
+        }
     }
-    rc = mosquitto_tls_opts_set(pMosqClient, SSL_VERIFY_PEER, nullptr, nullptr);
-    if (MOSQ_ERR_SUCCESS != rc) {
-        throw runtime_error("Was not able to set TLS options: " + string(mosquitto_strerror(rc)));
+    else {
+        rc = mosquitto_tls_set(
+            pMosqClient,
+            params.caFilePath.empty() ? nullptr : params.caFilePath.c_str(),
+            params.caDirPath.empty() ? nullptr : params.caDirPath.c_str(),
+            params.clientCertFilePath.empty() ? nullptr : params.clientCertFilePath.c_str(),
+            params.privateKeyFilePath.empty() ? nullptr : params.privateKeyFilePath.c_str(),
+            [](char* buf, int size, int rwflag, void* pClient) -> int {
+                if (rwflag != 0) {
+                    return static_cast<int>(
+                        static_cast<MosquittoClient*>(mosquitto_userdata(static_cast<struct mosquitto*>(pClient)))
+                            ->params.privateKeyPassword.copy(buf, size));
+                }
+                return 0;
+            });
+        if (MOSQ_ERR_SUCCESS != rc) {
+            throw runtime_error("Was not able to set TLS settings: " + string(mosquitto_strerror(rc)));
+        }
+        rc = mosquitto_tls_opts_set(pMosqClient, SSL_VERIFY_PEER, nullptr, nullptr);
+        if (MOSQ_ERR_SUCCESS != rc) {
+            throw runtime_error("Was not able to set TLS options: " + string(mosquitto_strerror(rc)));
+        }
     }
 #endif
-    logCb->Log(LogLevel::INFO, "Starting mosquitto instance");
+    if (params.externalLoop) {
+        logCb->Log<LogLevel::INFO>([] { return "Mosquitto instance is driven by an external loop"; });
+        if (params.reconnectScheduler) {
+            logCb->Log<LogLevel::WARNING>([] {
+                return "Reconnects are scheduled by the external loop, ignoring reconnectScheduler";
+            });
+        }
+        /*packets are only queued by calls from outside of the loop, the loop writes them*/
+        rc = mosquitto_threaded_set(pMosqClient, true);
+        if (MOSQ_ERR_SUCCESS != rc) {
+            throw runtime_error("Was not able to set threaded mode: " + string(mosquitto_strerror(rc)));
+        }
+        return;
+    }
+    logCb->Log<LogLevel::INFO>([] { return "Starting mosquitto instance"; });
     rc = mosquitto_loop_start(pMosqClient);
     if (MOSQ_ERR_SUCCESS != rc) {
         throw runtime_error("Was not able to start mosquitto loop: " + string(mosquitto_strerror(rc)));
@@ -165,16 +201,22 @@ MosquittoClient::MosquittoClient(IMqttClient::InitializeParameters const& parame
 
 MosquittoClient::~MosquittoClient() noexcept
 {
-    logCb->Log(LogLevel::INFO, "Deinitializing mosquitto instance");
+    stopPublishing();
+    if (usesScheduler()) {
+        params.reconnectScheduler->Forget(this);
+    }
+    logCb->Log<LogLevel::INFO>([] { return "Deinitializing mosquitto instance"; });
     if (IsConnected()) {
         DisconnectAsync(Mqtt5ReasonCode::SUCCESS);
     }
-    mosquitto_loop_stop(pMosqClient, false);
+    if (!params.externalLoop) {
+        mosquitto_loop_stop(pMosqClient, false);
+    }
     mosquitto_destroy(pMosqClient);
     // If no users are left, clean the lib
     lock_guard<mutex> l(libMutex);
     if (counter.fetch_sub(1) == 1) {
-        logCb->Log(LogLevel::INFO, "Deinitializing mosquitto library");
+        logCb->Log<LogLevel::INFO>([] { return "Deinitializing mosquitto library"; });
         mosquitto_lib_cleanup();
     }
 }
@@ -183,16 +225,20 @@ void
 MosquittoClient::onConnectCb(struct mosquitto const* pClient, int mqttRc, int flags, mosquitto_property const* pProps)
 {
     (void)pClient;
-    (void)flags;
     (void)pProps;
     auto logLvl{LogLevel::WARNING};
     if (Mqtt5ReasonCode::SUCCESS == static_cast<Mqtt5ReasonCode>(mqttRc)) {
         connected = true;
         logLvl    = LogLevel::INFO;
+        if (usesScheduler()) {
+            params.reconnectScheduler->Connected(this);
+        }
+    }
+    if (logCb->IsLogged(logLvl)) {
+        logCb->Log(logLvl, "Mosquitto connected to broker, rc: " + Mqtt5ReasonCodeToStringRepr(mqttRc).first);
     }
-    logCb->Log(logLvl, "Mosquitto connected to broker, rc: " + Mqtt5ReasonCodeToStringRepr(mqttRc).first);
-    conCb->OnConnectionStatusChanged(IMqttConnectionCallbacks::ConnectionType::CONNECT,
-                                     static_cast<Mqtt5ReasonCode>(mqttRc));
+    /*bit 0 of the CONNACK flags is session present*/
+    notifyConnected(static_cast<Mqtt5ReasonCode>(mqttRc), (flags & 0x01) != 0);
 }
 
 void
@@ -201,10 +247,18 @@ MosquittoClient::onDisconnectCb(struct mosquitto const* pClient, int mqttRc, mos
     (void)pClient;
     (void)pProps;
     connected = false;
-    logCb->Log(LogLevel::WARNING,
-               "Mosquitto disconnected from broker, rc: " + Mqtt5ReasonCodeToStringRepr(mqttRc).first);
-    conCb->OnConnectionStatusChanged(IMqttConnectionCallbacks::ConnectionType::DISCONNECT,
-                                     static_cast<Mqtt5ReasonCode>(mqttRc));
+    logCb->Log<LogLevel::WARNING>([&] {
+        return "Mosquitto disconnected from broker, rc: " + Mqtt5ReasonCodeToStringRepr(mqttRc).first;
+    });
+    if (usesScheduler() && connectRequested) {
+        /*mosquitto waits the delay set at the time of the disconnect, in whole seconds*/
+        auto delay{params.reconnectScheduler->NextAttempt(this)};
+        auto delaySeconds{static_cast<unsigned>(max<milliseconds::rep>((delay.count() + 999) / 1000, 1))};
+        logCb->Log<LogLevel::DEBUG>([&] { return "Scheduled reconnect in " + to_string(delaySeconds) + " seconds"; });
+        (void)mosqRcToReasonCode(mosquitto_reconnect_delay_set(pMosqClient, delaySeconds, delaySeconds, false),
+                                 "mosquitto_reconnect_delay_set");
+    }
+    notifyDisconnected(static_cast<Mqtt5ReasonCode>(mqttRc));
 }
 
 void
@@ -215,21 +269,18 @@ MosquittoClient::onPublishCb(struct mosquitto const*   pClient,
 {
     (void)pClient;
     (void)pProps;
-    logCb->Log(LogLevel::DEBUG,
-               "Mosquitto publish completed for token: " + to_string(messageId) +
-                   ", rc: " + Mqtt5ReasonCodeToStringRepr(mqttRc).first);
-    cmdCb->OnPublish(messageId, static_cast<Mqtt5ReasonCode>(mqttRc));
+    logCb->Log<LogLevel::DEBUG>([&] {
+        return "Mosquitto publish completed for token: " + to_string(messageId) +
+               ", rc: " + Mqtt5ReasonCodeToStringRepr(mqttRc).first;
+    });
+    notifyPublish(messageId, static_cast<Mqtt5ReasonCode>(mqttRc));
 }
 
-void
-MosquittoClient::onMessageCb(struct mosquitto const*         pClient,
-                             struct mosquitto_message const* pMsg,
-                             mosquitto_property const*       pProps) const
+upMqttMessage_t
+MosquittoToMqttMessage(mosquitto_message const*  pMsg,
+                       mosquitto_property const* pProps,
+                       IMqttLogCallbacks const*  logCb)
 {
-    (void)pClient;
-
-    logCb->Log(LogLevel::DEBUG, "Mosquitto received message");
-
     auto mqttMessage{MqttMessageFactory::Create(
         pMsg->topic,
         IMqttMessage::payload_t(static_cast<IMqttMessage::payloadRaw_t*>(pMsg->payload),
@@ -250,7 +301,7 @@ MosquittoClient::onMessageCb(struct mosquitto const*         pClient,
             if (key) {
                 auto keyStr = string(key);
                 if (!mqttMessage->userProps.insert(make_pair(keyStr, val ? string(val) : string())).second) {
-                    logCb->Log(LogLevel::ERROR, "Was not able to add user props - ignoring");
+                    logCb->Log<LogLevel::ERROR>([] { return "Was not able to add user props - ignoring"; });
                 }
             }
         } while (pUserProps);
@@ -284,6 +335,21 @@ MosquittoClient::onMessageCb(struct mosquitto const*         pClient,
         }
     }
 
+    {
+        /*one identifier per matching subscription*/
+        const mosquitto_property* pSubscriptionIds{pProps};
+        bool                      skipFirst{false};
+        do {
+            uint32_t id{0U};
+            pSubscriptionIds = mosquitto_property_read_varint(
+                pSubscriptionIds, MQTT_PROP_SUBSCRIPTION_IDENTIFIER, &id, skipFirst);
+            skipFirst = true;
+            if (pSubscriptionIds) {
+                mqttMessage->subscriptionIds.push_back(id);
+            }
+        } while (pSubscriptionIds);
+    }
+
     {
         uint8_t formatIndicator{0U};
         (void)mosquitto_property_read_byte(pProps, MQTT_PROP_PAYLOAD_FORMAT_INDICATOR, &formatIndicator, false);
@@ -291,7 +357,18 @@ MosquittoClient::onMessageCb(struct mosquitto const*         pClient,
             formatIndicator == 1U ? IMqttMessage::FormatIndicator::UTF8 : IMqttMessage::FormatIndicator::UNSPECIFIED;
     }
 
-    msgCb->OnMqttMessage(move(mqttMessage));
+    return mqttMessage;
+}
+
+void
+MosquittoClient::onMessageCb(struct mosquitto const*         pClient,
+                             struct mosquitto_message const* pMsg,
+                             mosquitto_property const*       pProps) const
+{
+    (void)pClient;
+
+    logCb->Log<LogLevel::DEBUG>([] { return "Mosquitto received message"; });
+    notifyMessage(MosquittoToMqttMessage(pMsg, pProps, logCb));
 }
 
 void
@@ -304,10 +381,40 @@ MosquittoClient::onSubscribeCb(struct mosquitto const*   pClient,
     (void)pClient;
     (void)pProps;
     for (int i{0}; i < grantedQosCount; i++) {
-        logCb->Log(LogLevel::DEBUG, "Mosquitto Subscribe completed with QOS: " + to_string(*(pGrantedQos + i)));
+        logCb->Log<LogLevel::DEBUG>([&] {
+            return "Mosquitto Subscribe completed with QOS: " + to_string(*(pGrantedQos + i));
+        });
+    }
+    shared_ptr<SubscribeBatch> batch;
+    {
+        lock_guard<mutex> lock(batchMutex);
+        auto              packet{subscribeBatches.find(messageId)};
+        if (packet == subscribeBatches.end()) {
+            logCb->Log<LogLevel::WARNING>([&] {
+                return "Mosquitto Subscribe completed for unknown token: " + to_string(messageId);
+            });
+            return;
+        }
+        batch = packet->second.first;
+        auto const& indices = packet->second.second;
+        /*the granted QoS doubles as the reason code of the SUBACK*/
+        for (size_t i{0U}; i < indices.size() && i < static_cast<size_t>(grantedQosCount); i++) {
+            batch->results[indices[i]] = static_cast<Mqtt5ReasonCode>(pGrantedQos[i]);
+        }
+        subscribeBatches.erase(packet);
+        if (--batch->pending) {
+            return;
+        }
+    }
+    auto failed{all_of(batch->results.begin(), batch->results.end(), [](Mqtt5ReasonCode rc) {
+        return rc >= Mqtt5ReasonCode::UNSPECIFIED_ERROR;
+    })};
+    if (failed) {
+        notifySubscribeFailure(batch->token, batch->results);
+    }
+    else {
+        notifySubscribe(batch->token, batch->results);
     }
-    // TODO: How to get the Mqtt5ReasonCode in order to hand it over to the user
-    cmdCb->OnSubscribe(messageId);
 }
 
 void
@@ -315,9 +422,18 @@ MosquittoClient::onUnSubscribeCb(struct mosquitto const* pClient, int messageId,
 {
     (void)pClient;
     (void)pProps;
-    logCb->Log(LogLevel::DEBUG, "Mosquitto UnSubscribe completed");
-    // TODO: How to get the Mqtt5ReasonCode in order to hand it over to the user
-    cmdCb->OnUnSubscribe(messageId);
+    logCb->Log<LogLevel::DEBUG>([] { return "Mosquitto UnSubscribe completed"; });
+    size_t count{1U};
+    {
+        lock_guard<mutex> lock(batchMutex);
+        auto              unSubscribe{unSubscribeCounts.find(messageId)};
+        if (unSubscribe != unSubscribeCounts.end()) {
+            count = unSubscribe->second;
+            unSubscribeCounts.erase(unSubscribe);
+        }
+    }
+    /*mosquitto does not provide the reason codes of the UNSUBACK*/
+    notifyUnSubscribe(messageId, vector<Mqtt5ReasonCode>(count, Mqtt5ReasonCode::SUCCESS));
 }
 
 void
@@ -352,48 +468,128 @@ MosquittoClient::onLog(struct mosquitto const* pClient, int logLevel, char const
 ReasonCode
 MosquittoClient::ConnectAsync(void)
 {
-    logCb->Log(LogLevel::INFO, "Connecting to broker async: " + params.hostAddress + ":" + to_string(params.port));
-    return mosqRcToReasonCode(
+    logCb->Log<LogLevel::INFO>([&] {
+        return "Connecting to broker async: " + params.hostAddress + ":" + to_string(params.port);
+    });
+    connectRequested = true;
+    auto status{mosqRcToReasonCode(
         mosquitto_connect_async(pMosqClient, params.hostAddress.c_str(), params.port, params.keepAliveInterval),
-        "mosquitto_connect_async");
+        "mosquitto_connect_async")};
+    wakeUpLoop();
+    return status;
 }
 
 ReasonCode
 MosquittoClient::DisconnectAsync(Mqtt5ReasonCode rc)
 {
-    logCb->Log(LogLevel::INFO, "Disconnecting from broker");
-    return mosqRcToReasonCode(mosquitto_disconnect_v5(pMosqClient, static_cast<int>(rc), nullptr),
-                              "mosquitto_disconnect_v5");
+    logCb->Log<LogLevel::INFO>([] { return "Disconnecting from broker"; });
+    connectRequested = false;
+    if (usesScheduler()) {
+        params.reconnectScheduler->Forget(this);
+    }
+    auto status{mosqRcToReasonCode(mosquitto_disconnect_v5(pMosqClient, static_cast<int>(rc), nullptr),
+                                   "mosquitto_disconnect_v5")};
+    wakeUpLoop();
+    return status;
 }
 
 ReasonCode
-MosquittoClient::SubscribeAsync(string const& topic, IMqttMessage::QOS qos, int* token, bool getRetained)
+MosquittoClient::subscribe(vector<TopicSubscription> const& subscriptions, uint32_t subscriptionId, int* token)
 {
-    logCb->Log(LogLevel::DEBUG, "Subscribing to topic: \"" + topic + "\"");
-    int options{0};
-    if (!params.allowLocalTopics) {
-        options |= mqtt5_sub_options::MQTT_SUB_OPT_NO_LOCAL;
+    /*mosquitto supports only one QoS and one set of options per SUBSCRIBE packet, filters are grouped accordingly*/
+    map<pair<int, int>, vector<size_t>> packets;
+    for (size_t i{0U}; i < subscriptions.size(); i++) {
+        logCb->Log<LogLevel::DEBUG>([&] { return "Subscribing to topic: \"" + subscriptions[i].topic + "\""; });
+        int options{0};
+        if (!params.allowLocalTopics) {
+            options |= mqtt5_sub_options::MQTT_SUB_OPT_NO_LOCAL;
+        }
+        if (subscriptions[i].getRetained == false) {
+            options |= mqtt5_sub_options::MQTT_SUB_OPT_SEND_RETAIN_NEVER;
+        }
+        packets[make_pair(static_cast<int>(subscriptions[i].qos), options)].push_back(i);
     }
-    if (getRetained == false) {
-        options |= mqtt5_sub_options::MQTT_SUB_OPT_SEND_RETAIN_NEVER;
+
+    mosquitto_property* pProps{nullptr};
+    if (subscriptionId &&
+        MOSQ_ERR_SUCCESS != mosquitto_property_add_varint(&pProps, MQTT_PROP_SUBSCRIPTION_IDENTIFIER, subscriptionId)) {
+        logCb->Log<LogLevel::ERROR>([] { return "Was not able to add subscription identifier"; });
+        mosquitto_property_free_all(&pProps);
+        return ReasonCode::ERROR_GENERAL;
     }
-    return mosqRcToReasonCode(
-        mosquitto_subscribe_v5(pMosqClient, token, topic.c_str(), static_cast<int>(qos), options, nullptr),
-        "mosquitto_subscribe_v5");
+
+    auto batch{make_shared<SubscribeBatch>()};
+    batch->results.resize(subscriptions.size(), Mqtt5ReasonCode::UNSPECIFIED_ERROR);
+    batch->pending = packets.size();
+    vector<int> messageIds;
+    auto        status{ReasonCode::OKAY};
+    /*SUBACKs are not handled, before all packets of the batch are known*/
+    lock_guard<mutex> lock(batchMutex);
+    for (auto const& packet : packets) {
+        vector<char*> topics;
+        for (auto index : packet.second) {
+            topics.push_back(const_cast<char*>(subscriptions[index].topic.c_str()));
+        }
+        int messageId{0};
+        status = mosqRcToReasonCode(mosquitto_subscribe_multiple(pMosqClient,
+                                                                 &messageId,
+                                                                 static_cast<int>(topics.size()),
+                                                                 topics.data(),
+                                                                 packet.first.first,
+                                                                 packet.first.second,
+                                                                 pProps),
+                                    "mosquitto_subscribe_multiple");
+        if (ReasonCode::OKAY != status) {
+            break;
+        }
+        if (messageIds.empty()) {
+            batch->token = messageId;
+        }
+        messageIds.push_back(messageId);
+        subscribeBatches[messageId] = make_pair(batch, packet.second);
+    }
+    mosquitto_property_free_all(&pProps);
+    if (ReasonCode::OKAY != status) {
+        for (auto messageId : messageIds) {
+            subscribeBatches.erase(messageId);
+        }
+        return status;
+    }
+    if (token) {
+        *token = batch->token;
+    }
+    wakeUpLoop();
+    return status;
 }
 
 ReasonCode
-MosquittoClient::UnSubscribeAsync(string const& topic, int* token)
+MosquittoClient::unSubscribe(vector<string> const& topics, int* token)
 {
-    logCb->Log(LogLevel::DEBUG, "Unsubscribing from topic: \"" + topic + "\"");
-    return mosqRcToReasonCode(mosquitto_unsubscribe_v5(pMosqClient, token, topic.c_str(), nullptr),
-                              "mosquitto_unsubscribe_v5");
+    vector<char*> pTopics;
+    for (auto const& topic : topics) {
+        logCb->Log<LogLevel::DEBUG>([&] { return "Unsubscribing from topic: \"" + topic + "\""; });
+        pTopics.push_back(const_cast<char*>(topic.c_str()));
+    }
+    int               messageId{0};
+    lock_guard<mutex> lock(batchMutex);
+    auto              status{mosqRcToReasonCode(
+        mosquitto_unsubscribe_multiple(
+            pMosqClient, &messageId, static_cast<int>(pTopics.size()), pTopics.data(), nullptr),
+        "mosquitto_unsubscribe_multiple")};
+    if (ReasonCode::OKAY == status) {
+        unSubscribeCounts[messageId] = topics.size();
+        wakeUpLoop();
+    }
+    if (token) {
+        *token = messageId;
+    }
+    return status;
 }
 
 ReasonCode
-MosquittoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
+MosquittoClient::publish(upMqttMessage_t mqttMsg, int* token)
 {
-    logCb->Log(LogLevel::DEBUG, "Publishing to topic: \"" + mqttMsg->topic + "\"");
+    logCb->Log<LogLevel::DEBUG>([&] { return "Publishing to topic: \"" + mqttMsg->topic + "\""; });
 
     auto propertiesOkay{true};
 
@@ -401,7 +597,7 @@ MosquittoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
     for (auto const& prop : mqttMsg->userProps) {
         if (MOSQ_ERR_SUCCESS != mosquitto_property_add_string_pair(
                                     &pProps, MQTT_PROP_USER_PROPERTY, prop.first.c_str(), prop.second.c_str())) {
-            logCb->Log(LogLevel::ERROR, "Invalid MQTT user property - ignoring message");
+            logCb->Log<LogLevel::ERROR>([] { return "Invalid MQTT user property - ignoring message"; });
             propertiesOkay = false;
             break;
         }
@@ -412,19 +608,19 @@ MosquittoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
                                       MQTT_PROP_CORRELATION_DATA,
                                       mqttMsg->correlationDataProps.data(),
                                       static_cast<uint16_t>(mqttMsg->correlationDataProps.size()))) {
-        logCb->Log(LogLevel::ERROR, "Invalid MQTT correlation data property - ignoring message");
+        logCb->Log<LogLevel::ERROR>([] { return "Invalid MQTT correlation data property - ignoring message"; });
         propertiesOkay = false;
     }
 
     if (MOSQ_ERR_SUCCESS !=
         mosquitto_property_add_string(&pProps, MQTT_PROP_RESPONSE_TOPIC, mqttMsg->responseTopic.c_str())) {
-        logCb->Log(LogLevel::ERROR, "Invalid MQTT response topic - ignoring message");
+        logCb->Log<LogLevel::ERROR>([] { return "Invalid MQTT response topic - ignoring message"; });
         propertiesOkay = false;
     }
 
     if (MOSQ_ERR_SUCCESS !=
         mosquitto_property_add_string(&pProps, MQTT_PROP_CONTENT_TYPE, mqttMsg->payloadContentType.c_str())) {
-        logCb->Log(LogLevel::ERROR, "Invalid MQTT content type - ignoring message");
+        logCb->Log<LogLevel::ERROR>([] { return "Invalid MQTT content type - ignoring message"; });
         propertiesOkay = false;
     }
 
@@ -432,7 +628,7 @@ MosquittoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
         mosquitto_property_add_byte(&pProps,
                                     MQTT_PROP_PAYLOAD_FORMAT_INDICATOR,
                                     mqttMsg->payloadFormatIndicator == IMqttMessage::FormatIndicator::UTF8 ? 1 : 0)) {
-        logCb->Log(LogLevel::ERROR, "Invalid MQTT format indicator - ignoring message");
+        logCb->Log<LogLevel::ERROR>([] { return "Invalid MQTT format indicator - ignoring message"; });
         propertiesOkay = false;
     }
 
@@ -449,7 +645,10 @@ MosquittoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
                                     "mosquitto_publish_v5");
     }
     if (ReasonCode::OKAY != status) {
-        logCb->Log(LogLevel::ERROR, "PublishAsync failed - will not retry");
+        logCb->Log<LogLevel::ERROR>([] { return "PublishAsync failed - will not retry"; });
+    }
+    else {
+        wakeUpLoop();
     }
     mosquitto_property_free_all(&pProps);
     return status;
@@ -461,8 +660,97 @@ MosquittoClient::IsConnected(void) const noexcept
     return connected;
 }
 
+IMqttExternalLoop*
+MosquittoClient::GetExternalLoop(void) noexcept
+{
+    return params.externalLoop ? this : nullptr;
+}
+
+int
+MosquittoClient::Socket(void) const noexcept
+{
+    return mosquitto_socket(pMosqClient);
+}
+
+ReasonCode
+MosquittoClient::Read(void)
+{
+    /*the number of packets is ignored by mosquitto*/
+    return loopRcToReasonCode(mosquitto_loop_read(pMosqClient, 1), "mosquitto_loop_read");
+}
+
+ReasonCode
+MosquittoClient::Write(void)
+{
+    return loopRcToReasonCode(mosquitto_loop_write(pMosqClient, 1), "mosquitto_loop_write");
+}
+
+ReasonCode
+MosquittoClient::Misc(void)
+{
+    return loopRcToReasonCode(mosquitto_loop_misc(pMosqClient), "mosquitto_loop_misc");
+}
+
+bool
+MosquittoClient::WantWrite(void) const noexcept
+{
+    return mosquitto_want_write(pMosqClient);
+}
+
+bool
+MosquittoClient::WantReconnect(void) const noexcept
+{
+    return connectRequested && !connected && mosquitto_socket(pMosqClient) < 0;
+}
+
+ReasonCode
+MosquittoClient::Reconnect(void)
+{
+    logCb->Log<LogLevel::INFO>([&] {
+        return "Reconnecting to broker async: " + params.hostAddress + ":" + to_string(params.port);
+    });
+    auto status{mosqRcToReasonCode(mosquitto_reconnect_async(pMosqClient), "mosquitto_reconnect_async")};
+    wakeUpLoop();
+    return status;
+}
+
+void
+MosquittoClient::SetWakeUp(wakeUp_t func)
+{
+    lock_guard<mutex> lock(wakeUpMutex);
+    wakeUp = move(func);
+}
+
+void
+MosquittoClient::wakeUpLoop(void) const
+{
+    if (!params.externalLoop) {
+        return;
+    }
+    lock_guard<mutex> lock(wakeUpMutex);
+    if (wakeUp) {
+        wakeUp();
+    }
+}
+
+bool
+MosquittoClient::usesScheduler(void) const noexcept
+{
+    return params.reconnectScheduler && !params.externalLoop;
+}
+
 ReasonCode
-MosquittoClient::mosqRcToReasonCode(int rc, string const& details) const
+MosquittoClient::loopRcToReasonCode(int rc, char const* details) const
+{
+    /*invoked for every event of the external loop, so success is not logged*/
+    if (MOSQ_ERR_SUCCESS == rc) {
+        return ReasonCode::OKAY;
+    }
+    return mosqRcToReasonCode(rc, details);
+}
+
+ReasonCode
+MosquittoClient::mosqRcToReasonCode(int rc, char const* details) const
 {
     auto status{ReasonCode::ERROR_GENERAL};
     auto logLvl{LogLevel::ERROR};
@@ -490,19 +778,11 @@ MosquittoClient::mosqRcToReasonCode(int rc, string const& details) const
     default:
         break;
     }
-    logCb->Log(logLvl,
-               details + ": " + ReasonCodeToStringRepr(status).first + ", Mosq: " + string(mosquitto_strerror(rc)));
+    if (logCb->IsLogged(logLvl)) {
+        logCb->Log(logLvl,
+                   string(details) + ": " + ReasonCodeToStringRepr(status).first +
+                       ", Mosq: " + string(mosquitto_strerror(rc)));
+    }
     return status;
 }
-
-unique_ptr<IMqttClient>
-MqttClientFactory::Create(IMqttClient::InitializeParameters const& params,
-                          IMqttMessageCallbacks const*             msg,
-                          IMqttLogCallbacks const*                 log,
-                          IMqttCommandCallbacks const*             cmd,
-                          IMqttConnectionCallbacks const*          con)
-{
-    return unique_ptr<MosquittoClient>(new MosquittoClient(params, msg, log, cmd, con));
-}
-
 }  // namespace i_mqtt_client
\ No newline at end of file
@@ -21,20 +21,41 @@
 #include <mosquitto.h>
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <random>
+#include <unordered_map>
+#include <vector>
 
-#include "IMqttClient.h"
+#include "IMqttExternalLoop.h"
+#include "MqttClientBase.h"
 
 namespace i_mqtt_client {
-class MosquittoClient : public IMqttClient {
+class MosquittoClient
+  : public MqttClientBase
+  , private IMqttExternalLoop {
 private:
+    /*results of a SubscribeManyAsync, that may be split into multiple SUBSCRIBE packets*/
+    struct SubscribeBatch final {
+        int                          token{0};
+        std::vector<Mqtt5ReasonCode> results;
+        size_t                       pending{0U};
+    };
+    using subscribePacket_t = std::pair<std::shared_ptr<SubscribeBatch>, std::vector<size_t>>;
+
     static std::atomic_uint counter;
     static std::mutex       libMutex;
 
-    std::atomic_bool                  connected{false};
-    mosquitto*                        pMosqClient{nullptr};
-    IMqttClient::InitializeParameters params;
+    std::atomic_bool connected{false};
+    std::atomic_bool connectRequested{false};
+    mosquitto*       pMosqClient{nullptr};
+
+    mutable std::mutex                                 batchMutex;
+    mutable std::unordered_map<int, subscribePacket_t> subscribeBatches;
+    mutable std::unordered_map<int, size_t>            unSubscribeCounts;
+
+    mutable std::mutex wakeUpMutex;
+    wakeUp_t           wakeUp;
 
     void       onConnectCb(struct mosquitto const*, int, int, mosquitto_property const*);
     void       onDisconnectCb(struct mosquitto const*, int, mosquitto_property const*);
@@ -43,15 +64,28 @@ private:
     void       onSubscribeCb(struct mosquitto const*, int, int, int const*, mosquitto_property const*) const;
     void       onUnSubscribeCb(struct mosquitto const*, int, mosquitto_property const*) const;
     void       onLog(struct mosquitto const*, int, char const*) const;
-    ReasonCode mosqRcToReasonCode(int, std::string const&) const;
+    ReasonCode mosqRcToReasonCode(int, char const*) const;
+    ReasonCode loopRcToReasonCode(int, char const*) const;
+    void       wakeUpLoop(void) const;
+    bool       usesScheduler(void) const noexcept;
 
     ReasonCode ConnectAsync(void) override;
     ReasonCode DisconnectAsync(Mqtt5ReasonCode) override;
-    ReasonCode SubscribeAsync(std::string const&, IMqttMessage::QOS, int*, bool) override;
-    ReasonCode UnSubscribeAsync(std::string const&, int*) override;
-    ReasonCode PublishAsync(upMqttMessage_t, int*) override;
+    ReasonCode subscribe(std::vector<TopicSubscription> const&, std::uint32_t, int*) override;
+    ReasonCode unSubscribe(std::vector<std::string> const&, int*) override;
+    ReasonCode publish(upMqttMessage_t, int*) override;
     bool       IsConnected(void) const noexcept override;
 
+    IMqttExternalLoop* GetExternalLoop(void) noexcept override;
+    int                Socket(void) const noexcept override;
+    ReasonCode         Read(void) override;
+    ReasonCode         Write(void) override;
+    ReasonCode         Misc(void) override;
+    bool               WantWrite(void) const noexcept override;
+    bool               WantReconnect(void) const noexcept override;
+    ReasonCode         Reconnect(void) override;
+    void               SetWakeUp(wakeUp_t) override;
+
 public:
     MosquittoClient(IMqttClient::InitializeParameters const&,
                     IMqttMessageCallbacks const*,
@@ -61,4 +95,7 @@ public:
     virtual ~MosquittoClient() noexcept;
 };
 
+/*Converts a message received by Mosquitto, including its MQTT v5 properties, which stay owned by the caller*/
+upMqttMessage_t MosquittoToMqttMessage(mosquitto_message const*, mosquitto_property const*, IMqttLogCallbacks const*);
+
 }  // namespace i_mqtt_client
\ No newline at end of file
@@ -0,0 +1,482 @@
+/**
+ * @file MqttClientBase.cpp
+ * @author Timo Lange
+ * @brief Implementation of functionality shared by all IMqttClient implementations
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "MqttClientBase.h"
+
+#include "IMqttMetrics.h"
+#include "IMqttTracer.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+MqttClientBase::MqttClientBase(InitializeParameters const&     parameters,
+                               IMqttMessageCallbacks const*    msg,
+                               IMqttLogCallbacks const*        log,
+                               IMqttCommandCallbacks const*    cmd,
+                               IMqttConnectionCallbacks const* con)
+  : IMqttClient(log, cmd, msg, con)
+  , registry(parameters.restoreBatchSize,
+             [this](vector<TopicSubscription> const& subscriptions, uint32_t subscriptionId, int* token) {
+                 return subscribe(subscriptions, subscriptionId, token);
+             })
+  , params(parameters)
+{
+    if (PublishRateLimiter::IsConfigured(params.publishRateLimit)) {
+        logCb->Log<LogLevel::INFO>([] { return "Enabling publish rate limiter"; });
+        rateLimiter.reset(new PublishRateLimiter(params.publishRateLimit, [this](upMqttMessage_t msg, int* token) {
+            return submitPublish(move(msg), token);
+        }));
+    }
+    if (params.lastValueCacheSize) {
+        logCb->Log<LogLevel::INFO>([] { return "Enabling last value cache"; });
+        lastValues.reset(new LastValueCache(params.lastValueCacheSize));
+        replay.reset(new RetainedReplay([this](string const& filter, uint64_t id, messageHandler_t const& handler) {
+            replayRetained(filter, id, handler);
+        }));
+    }
+}
+
+ReasonCode
+MqttClientBase::submitPublish(upMqttMessage_t mqttMsg, int* token)
+{
+    auto qos{mqttMsg->qos};
+    auto bytes{mqttMsg->payload.size()};
+    auto status{ReasonCode::OKAY};
+    if (!PublishLatencyTracker::IsTracked(qos)) {
+        status = publish(move(mqttMsg), token);
+    }
+    else {
+        auto submitted{publishLatency.Begin()};
+        int  localToken{-1};
+        status = publish(move(mqttMsg), &localToken);
+        publishLatency.Submitted(submitted, localToken, qos, ReasonCode::OKAY == status);
+        if (token) {
+            *token = localToken;
+        }
+    }
+    if (params.metrics) {
+        if (ReasonCode::OKAY == status) {
+            params.metrics->MessageOut(qos, bytes);
+        }
+        else {
+            params.metrics->PublishFailed(status);
+        }
+    }
+    return status;
+}
+
+void
+MqttClientBase::stopPublishing(void) noexcept
+{
+    /*not reset, the MQTT library might still report connection changes to it*/
+    if (rateLimiter) {
+        rateLimiter->Stop();
+    }
+}
+
+ReasonCode
+MqttClientBase::SubscribeAsync(string const& topic, IMqttMessage::QOS qos, int* token, bool getRetained)
+{
+    TopicSubscription subscription;
+    subscription.topic       = topic;
+    subscription.qos         = qos;
+    subscription.getRetained = getRetained;
+    return SubscribeManyAsync(vector<TopicSubscription>{subscription}, token);
+}
+
+ReasonCode
+MqttClientBase::SubscribeAsync(string const&     topic,
+                               IMqttMessage::QOS qos,
+                               messageHandler_t  handler,
+                               int*              token,
+                               bool              getRetained,
+                               uint64_t*         handlerId)
+{
+    if (!handler) {
+        logCb->Log<LogLevel::ERROR>([] { return "SubscribeAsync called without handler"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    /*a shared subscription must not be removed at the broker in between*/
+    lock_guard<mutex> lock(handlerMutex);
+    /*install the handler first, retained messages may arrive before the subscription is reported complete*/
+    auto id{router.Add(topic, handler)};
+    if (!shareSubscription(topic, qos, token, getRetained, id, handler)) {
+        auto status{SubscribeAsync(topic, qos, token, getRetained)};
+        if (ReasonCode::OKAY != status) {
+            router.Remove(topic, id);
+            return status;
+        }
+    }
+    handlerIds[topic].insert(id);
+    if (handlerId) {
+        *handlerId = id;
+    }
+    return ReasonCode::OKAY;
+}
+
+bool
+MqttClientBase::shareSubscription(string const&           topic,
+                                  IMqttMessage::QOS       qos,
+                                  int*                    token,
+                                  bool                    getRetained,
+                                  uint64_t                id,
+                                  messageHandler_t const& handler)
+{
+    if (!lastValues || !lastValues->IsSubscribed(topic, qos)) {
+        return false;
+    }
+    logCb->Log<LogLevel::DEBUG>([&] { return "Sharing subscription of " + topic; });
+    subscriptionIds.SetHandlers(topic, router.Handlers(topic));
+    /*there is no SUBSCRIBE, so there is nothing to wait for*/
+    if (token) {
+        *token = -1;
+    }
+    if (getRetained) {
+        replay->Submit(topic, id, handler);
+    }
+    return true;
+}
+
+void
+MqttClientBase::replayRetained(string const& filter, uint64_t id, messageHandler_t const& handler) const
+{
+    {
+        /*the handler might be removed again already, not locked along with the delivery, as handlers may subscribe*/
+        lock_guard<mutex> lock(handlerMutex);
+        auto              ids{handlerIds.find(filter)};
+        if (ids == handlerIds.end() || !ids->second.count(id)) {
+            return;
+        }
+    }
+    /*the cache is read under the lock, so a handler never gets a cached message older than one it received already*/
+    lock_guard<mutex> lock(deliveryMutex);
+    /*not delivered via the router, the other handlers of the filter received the messages already*/
+    for (auto const& msg : lastValues->Match(filter)) {
+        handler(*msg);
+    }
+}
+
+ReasonCode
+MqttClientBase::SubscribeManyAsync(vector<TopicSubscription> const& subscriptions, int* token)
+{
+    if (subscriptions.empty()) {
+        logCb->Log<LogLevel::ERROR>([] { return "SubscribeManyAsync called without topics"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    auto id{assignSubscriptionId(subscriptions)};
+    int  localToken{-1};
+    if (params.restoreSubscriptions) {
+        registry.Subscribing();
+    }
+    auto status{subscribe(subscriptions, id, &localToken)};
+    if (token) {
+        *token = localToken;
+    }
+    if (params.restoreSubscriptions) {
+        registry.Add(subscriptions, id, localToken, ReasonCode::OKAY == status);
+    }
+    if (ReasonCode::OKAY == status && lastValues) {
+        lastValues->Subscribed(subscriptions);
+    }
+    if (ReasonCode::OKAY != status && id) {
+        for (auto const& subscription : subscriptions) {
+            subscriptionIds.Release(subscription.topic);
+        }
+    }
+    return status;
+}
+
+uint32_t
+MqttClientBase::assignSubscriptionId(vector<TopicSubscription> const& subscriptions)
+{
+    if (!params.subscriptionIdentifiers) {
+        return 0U;
+    }
+    vector<string> filters;
+    for (auto const& subscription : subscriptions) {
+        filters.push_back(subscription.topic);
+    }
+    /*one identifier per SUBSCRIBE, so handlers are only known without the router, if there is a single filter*/
+    auto handlers{router.Handlers(filters.front())};
+    auto useRouter{false};
+    for (size_t i{1U}; i < filters.size() && !useRouter; i++) {
+        useRouter = !handlers.empty() || !router.Handlers(filters[i]).empty();
+    }
+    if (useRouter) {
+        handlers.clear();
+    }
+    auto id{subscriptionIds.Assign(filters, useRouter, move(handlers))};
+    if (!id) {
+        logCb->Log<LogLevel::WARNING>([] { return "No subscription identifier left, subscribing without"; });
+    }
+    return id;
+}
+
+ReasonCode
+MqttClientBase::UnSubscribeAsync(string const& topic, int* token)
+{
+    return UnSubscribeManyAsync(vector<string>{topic}, token);
+}
+
+ReasonCode
+MqttClientBase::UnSubscribeAsync(string const& topic, uint64_t handlerId, int* token)
+{
+    lock_guard<mutex> lock(handlerMutex);
+    auto              ids{handlerIds.find(topic)};
+    if (ids == handlerIds.end() || !ids->second.erase(handlerId)) {
+        logCb->Log<LogLevel::ERROR>([&] { return "UnSubscribeAsync called with unknown handler of " + topic; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    if (ids->second.empty()) {
+        return unSubscribeAll(vector<string>{topic}, token);
+    }
+    /*other handlers still use the subscription at the broker*/
+    router.Remove(topic, handlerId);
+    subscriptionIds.SetHandlers(topic, router.Handlers(topic));
+    if (token) {
+        *token = -1;
+    }
+    return ReasonCode::OKAY;
+}
+
+ReasonCode
+MqttClientBase::UnSubscribeManyAsync(vector<string> const& topics, int* token)
+{
+    if (topics.empty()) {
+        logCb->Log<LogLevel::ERROR>([] { return "UnSubscribeManyAsync called without topics"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    lock_guard<mutex> lock(handlerMutex);
+    return unSubscribeAll(topics, token);
+}
+
+ReasonCode
+MqttClientBase::unSubscribeAll(vector<string> const& topics, int* token)
+{
+    for (auto const& topic : topics) {
+        handlerIds.erase(topic);
+        router.Remove(topic);
+        subscriptionIds.Release(topic);
+        registry.Remove(topic);
+        if (lastValues) {
+            lastValues->Unsubscribed(topic);
+        }
+    }
+    return unSubscribe(topics, token);
+}
+
+ReasonCode
+MqttClientBase::PublishAsync(upMqttMessage_t mqttMsg, int* token)
+{
+    if (!rateLimiter) {
+        return submitPublish(move(mqttMsg), token);
+    }
+    auto status{rateLimiter->Publish(move(mqttMsg), token)};
+    if (ReasonCode::ERROR_RATE_LIMITED == status) {
+        logCb->Log<LogLevel::WARNING>([] { return "PublishAsync rejected by rate limiter"; });
+        if (params.metrics) {
+            params.metrics->PublishFailed(status);
+        }
+    }
+    return status;
+}
+
+Mqtt5ReasonCode
+MqttClientBase::Publish(upMqttMessage_t mqttMsg, milliseconds timeout, ReasonCode* pRc)
+{
+    auto waitForAck{IMqttMessage::QOS::QOS_0 != mqttMsg->qos};
+    /*std::function requires a copyable lambda, the holder owns the message until it is moved into PublishAsync*/
+    auto msg{make_shared<upMqttMessage_t>(move(mqttMsg))};
+    return publishWaiters.Wait(
+        [this, msg](int* token) { return *msg ? PublishAsync(move(*msg), token) : ReasonCode::ERROR_GENERAL; },
+        waitForAck,
+        timeout,
+        pRc);
+}
+
+Mqtt5ReasonCode
+MqttClientBase::Subscribe(
+    string const& topic, IMqttMessage::QOS qos, milliseconds timeout, ReasonCode* pRc, bool getRetained)
+{
+    return subscribeWaiters.Wait(
+        [&](int* token) { return SubscribeAsync(topic, qos, token, getRetained); }, true, timeout, pRc);
+}
+
+void
+MqttClientBase::notifyConnected(Mqtt5ReasonCode rc, bool sessionPresent)
+{
+    if (Mqtt5ReasonCode::SUCCESS == rc) {
+        if (connectedBefore.exchange(true) && params.metrics) {
+            params.metrics->Reconnected();
+        }
+        if (rateLimiter) {
+            rateLimiter->SetConnected(true);
+        }
+        /*restore first, such that the application sees the subscriptions in flight already*/
+        auto restoring{registry.Connected(sessionPresent)};
+        if (restoring) {
+            logCb->Log<LogLevel::INFO>([&] { return "Restoring " + to_string(restoring) + " subscriptions"; });
+        }
+        else if (sessionPresent) {
+            logCb->Log<LogLevel::DEBUG>([] { return "Broker kept the session, not restoring subscriptions"; });
+        }
+        if (lastValues && !sessionPresent && !params.restoreSubscriptions) {
+            /*the subscriptions are gone, they can not be shared any more*/
+            lastValues->Unsubscribed();
+        }
+    }
+    conCb->OnConnectionStatusChanged(IMqttConnectionCallbacks::ConnectionType::CONNECT, rc);
+}
+
+void
+MqttClientBase::notifyDisconnected(Mqtt5ReasonCode rc) const
+{
+    if (rateLimiter) {
+        rateLimiter->SetConnected(false);
+    }
+    publishLatency.Reset();
+    registry.Disconnected();
+    conCb->OnConnectionStatusChanged(IMqttConnectionCallbacks::ConnectionType::DISCONNECT, rc);
+}
+
+void
+MqttClientBase::notifyMessage(upMqttMessage_t mqttMsg) const
+{
+    if (params.tracer) {
+        params.tracer->Sample(*mqttMsg);
+    }
+    registry.MessageReceived();
+    unique_lock<mutex> lock(deliveryMutex, defer_lock);
+    if (lastValues) {
+        lock.lock();
+        lastValues->Update(*mqttMsg);
+    }
+    if (!params.metrics && !mqttMsg->trace) {
+        deliver(move(mqttMsg));
+        return;
+    }
+    if (params.metrics) {
+        params.metrics->MessageIn(mqttMsg->qos, mqttMsg->payload.size());
+    }
+    auto trace{mqttMsg->trace};
+    auto start{steady_clock::now()};
+    deliver(move(mqttMsg));
+    auto end{steady_clock::now()};
+    if (params.metrics) {
+        params.metrics->CallbackDuration(IMqttMetrics::Callback::MESSAGE, duration_cast<microseconds>(end - start));
+    }
+    if (trace && IMqttMessage::Trace::clock_t::time_point() == trace->enqueued) {
+        /*handled without a dispatch queue, otherwise the queue completes the trace*/
+        trace->handlerStart = start;
+        trace->handlerEnd   = end;
+        params.tracer->Complete(*trace);
+    }
+}
+
+void
+MqttClientBase::deliver(upMqttMessage_t mqttMsg) const
+{
+    switch (subscriptionIds.Dispatch(*mqttMsg)) {
+    case SubscriptionIdTable::DispatchResult::HANDLED:
+        break;
+    case SubscriptionIdTable::DispatchResult::NO_HANDLER:
+        msgCb->OnMqttMessage(move(mqttMsg));
+        break;
+    case SubscriptionIdTable::DispatchResult::UNKNOWN:
+        /*fallthrough*/
+    default:
+        if (!router.Route(*mqttMsg)) {
+            msgCb->OnMqttMessage(move(mqttMsg));
+        }
+        break;
+    }
+}
+
+void
+MqttClientBase::notifyPublish(int token, Mqtt5ReasonCode rc) const
+{
+    if (rc >= Mqtt5ReasonCode::UNSPECIFIED_ERROR) {
+        publishLatency.Abandon(token);
+    }
+    else {
+        publishLatency.Completed(token);
+    }
+    publishWaiters.Complete(token, rc);
+    cmdCb->OnPublish(token, rc);
+}
+
+void
+MqttClientBase::notifySubscribe(int token, vector<Mqtt5ReasonCode> const& rcs) const
+{
+    registry.Completed(token, rcs);
+    subscribeWaiters.Complete(token, rcs.empty() ? Mqtt5ReasonCode::UNSPECIFIED_ERROR : rcs.front());
+    cmdCb->OnSubscribe(token);
+    cmdCb->OnSubscribeResults(token, rcs);
+}
+
+void
+MqttClientBase::notifySubscribeFailure(int token, vector<Mqtt5ReasonCode> const& rcs) const
+{
+    registry.Completed(token, rcs);
+    subscribeWaiters.Complete(token, rcs.empty() ? Mqtt5ReasonCode::UNSPECIFIED_ERROR : rcs.front());
+    cmdCb->OnSubscribeResults(token, rcs);
+}
+
+void
+MqttClientBase::notifyUnSubscribe(int token, vector<Mqtt5ReasonCode> const& rcs) const
+{
+    cmdCb->OnUnSubscribe(token);
+    cmdCb->OnUnSubscribeResults(token, rcs);
+}
+
+void
+MqttClientBase::notifyUnSubscribeFailure(int token, vector<Mqtt5ReasonCode> const& rcs) const
+{
+    cmdCb->OnUnSubscribeResults(token, rcs);
+}
+
+IMqttClient::PublishRateLimiterStatus
+MqttClientBase::GetPublishRateLimiterStatus(void) const
+{
+    if (!rateLimiter) {
+        return PublishRateLimiterStatus();
+    }
+    return rateLimiter->GetStatus();
+}
+
+IMqttClient::PublishLatencySnapshot
+MqttClientBase::GetPublishLatency(IMqttMessage::QOS qos) const
+{
+    return publishLatency.GetSnapshot(qos);
+}
+
+IMqttClient::SubscriptionRestoreStatus
+MqttClientBase::GetSubscriptionRestoreStatus(void) const
+{
+    return registry.GetStatus();
+}
+
+IMqttExternalLoop*
+MqttClientBase::GetExternalLoop(void) noexcept
+{
+    return nullptr;
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,126 @@
+/**
+ * @file MqttClientBase.h
+ * @author Timo Lange
+ * @brief Class definition for functionality shared by all IMqttClient implementations
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "IMqttClient.h"
+#include "LastValueCache.h"
+#include "PublishLatencyTracker.h"
+#include "PublishRateLimiter.h"
+#include "RetainedReplay.h"
+#include "SubscriptionIdTable.h"
+#include "SubscriptionRegistry.h"
+#include "TokenWaiters.h"
+#include "TopicRouter.h"
+
+namespace i_mqtt_client {
+/*Implements everything that does not depend on the underlying MQTT library. MQTT library wrappers derive from this
+ * class and implement the library specific parts.*/
+class MqttClientBase : public IMqttClient {
+private:
+    std::unique_ptr<PublishRateLimiter> rateLimiter;
+    TokenWaiters                        publishWaiters;
+    TokenWaiters                        subscribeWaiters;
+    mutable PublishLatencyTracker       publishLatency;
+    TopicRouter                         router;
+    SubscriptionIdTable                 subscriptionIds;
+    mutable SubscriptionRegistry        registry;
+    std::unique_ptr<LastValueCache>     lastValues;
+    std::atomic_bool                    connectedBefore{false};
+    /*handlers per topic filter, the filter is unsubscribed at the broker along with the last one*/
+    mutable std::mutex                                                 handlerMutex;
+    std::unordered_map<std::string, std::unordered_set<std::uint64_t>> handlerIds;
+    /*serializes replays from the cache with the delivery of received messages*/
+    mutable std::mutex              deliveryMutex;
+    std::unique_ptr<RetainedReplay> replay;
+
+    ReasonCode    submitPublish(upMqttMessage_t, int*);
+    std::uint32_t assignSubscriptionId(std::vector<TopicSubscription> const&);
+    bool shareSubscription(std::string const&, IMqttMessage::QOS, int*, bool, std::uint64_t, messageHandler_t const&);
+    ReasonCode    unSubscribeAll(std::vector<std::string> const&, int*);
+    void          replayRetained(std::string const&, std::uint64_t, messageHandler_t const&) const;
+    void          deliver(upMqttMessage_t) const;
+
+    ReasonCode                SubscribeAsync(std::string const&, IMqttMessage::QOS, int*, bool) override;
+    ReasonCode                SubscribeAsync(std::string const&,
+                                             IMqttMessage::QOS,
+                                             messageHandler_t,
+                                             int*,
+                                             bool,
+                                             std::uint64_t*) override;
+    ReasonCode                SubscribeManyAsync(std::vector<TopicSubscription> const&, int*) override;
+    ReasonCode                UnSubscribeAsync(std::string const&, int*) override;
+    ReasonCode                UnSubscribeAsync(std::string const&, std::uint64_t, int*) override;
+    ReasonCode                UnSubscribeManyAsync(std::vector<std::string> const&, int*) override;
+    ReasonCode                PublishAsync(upMqttMessage_t, int*) override;
+    Mqtt5ReasonCode           Publish(upMqttMessage_t, std::chrono::milliseconds, ReasonCode*) override;
+    Mqtt5ReasonCode           Subscribe(std::string const&,
+                                        IMqttMessage::QOS,
+                                        std::chrono::milliseconds,
+                                        ReasonCode*,
+                                        bool) override;
+    PublishRateLimiterStatus  GetPublishRateLimiterStatus(void) const override;
+    PublishLatencySnapshot    GetPublishLatency(IMqttMessage::QOS) const override;
+    SubscriptionRestoreStatus GetSubscriptionRestoreStatus(void) const override;
+
+protected:
+    InitializeParameters const params;
+
+    /*nullptr, unless the library specific client supports and enables an external event loop*/
+    IMqttExternalLoop* GetExternalLoop(void) noexcept override;
+
+    /*library specific publish, invoked once the message passed the rate limiter*/
+    virtual ReasonCode publish(upMqttMessage_t, int*) = 0;
+    /*library specific subscribe and unsubscribe of one or more topic filters, message handlers are managed by this
+     * class, a subscription identifier of 0 must not be sent*/
+    virtual ReasonCode subscribe(std::vector<TopicSubscription> const&, std::uint32_t subscriptionId, int*) = 0;
+    virtual ReasonCode unSubscribe(std::vector<std::string> const&, int*)                                   = 0;
+    /*has to be called first by the destructors of derived classes, to not publish on a destroyed object*/
+    void stopPublishing(void) noexcept;
+    /*to be called by derived classes instead of the connection callbacks, in order to restore subscriptions*/
+    void notifyConnected(Mqtt5ReasonCode, bool sessionPresent);
+    void notifyDisconnected(Mqtt5ReasonCode) const;
+    /*to be called by derived classes instead of the command callbacks, in order to also complete blocking calls*/
+    void notifyMessage(upMqttMessage_t) const;
+    void notifyPublish(int token, Mqtt5ReasonCode) const;
+    void notifySubscribe(int token, std::vector<Mqtt5ReasonCode> const&) const;
+    /*reports the failure of a subscription, without invoking IMqttCommandCallbacks::OnSubscribe*/
+    void notifySubscribeFailure(int token, std::vector<Mqtt5ReasonCode> const&) const;
+    void notifyUnSubscribe(int token, std::vector<Mqtt5ReasonCode> const&) const;
+    /*reports the failure of an unsubscription, without invoking IMqttCommandCallbacks::OnUnSubscribe*/
+    void notifyUnSubscribeFailure(int token, std::vector<Mqtt5ReasonCode> const&) const;
+
+    MqttClientBase(InitializeParameters const&,
+                   IMqttMessageCallbacks const*,
+                   IMqttLogCallbacks const*,
+                   IMqttCommandCallbacks const*,
+                   IMqttConnectionCallbacks const*);
+
+public:
+    virtual ~MqttClientBase() noexcept = default;
+};
+}  // namespace i_mqtt_client
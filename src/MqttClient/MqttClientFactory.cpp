@@ -0,0 +1,122 @@
+/**
+ * @file MqttClientFactory.cpp
+ * @author Timo Lange
+ * @brief Implementation of the factory choosing the backend of IMqttClient objects
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdexcept>
+
+#include "IMqttClient.h"
+#ifdef IMQTT_USE_MOSQ
+#include "Mosquitto/MosquittoClient.h"
+#endif
+#ifdef IMQTT_USE_PAHO
+#include "Paho/PahoClient.h"
+#endif
+#ifdef IMQTT_USE_NATIVE
+#include "Native/NativeClient.h"
+#endif
+#ifdef IMQTT_USE_LOOPBACK
+#include "Loopback/LoopbackClient.h"
+#endif
+
+using namespace std;
+
+namespace i_mqtt_client {
+static IMqttClient::Backend
+defaultBackend(void) noexcept
+{
+#if defined(IMQTT_USE_MOSQ)
+    return IMqttClient::Backend::MOSQUITTO;
+#elif defined(IMQTT_USE_PAHO)
+    return IMqttClient::Backend::PAHO;
+#elif defined(IMQTT_USE_NATIVE)
+    return IMqttClient::Backend::NATIVE;
+#elif defined(IMQTT_USE_LOOPBACK)
+    return IMqttClient::Backend::LOOPBACK;
+#else
+    return IMqttClient::Backend::DEFAULT;
+#endif
+}
+
+bool
+MqttClientFactory::IsAvailable(IMqttClient::Backend backend) noexcept
+{
+    switch (backend) {
+    case IMqttClient::Backend::DEFAULT:
+        return IMqttClient::Backend::DEFAULT != defaultBackend();
+#ifdef IMQTT_USE_MOSQ
+    case IMqttClient::Backend::MOSQUITTO:
+        return true;
+#endif
+#ifdef IMQTT_USE_PAHO
+    case IMqttClient::Backend::PAHO:
+        return true;
+#endif
+#ifdef IMQTT_USE_NATIVE
+    case IMqttClient::Backend::NATIVE:
+        return true;
+#endif
+#ifdef IMQTT_USE_LOOPBACK
+    case IMqttClient::Backend::LOOPBACK:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+unique_ptr<IMqttClient>
+MqttClientFactory::Create(IMqttClient::InitializeParameters const& params,
+                          IMqttMessageCallbacks const*             msg,
+                          IMqttLogCallbacks const*                 log,
+                          IMqttCommandCallbacks const*             cmd,
+                          IMqttConnectionCallbacks const*          con)
+{
+    return Create(params.backend, params, msg, log, cmd, con);
+}
+
+unique_ptr<IMqttClient>
+MqttClientFactory::Create(IMqttClient::Backend                     backend,
+                          IMqttClient::InitializeParameters const& params,
+                          IMqttMessageCallbacks const*             msg,
+                          IMqttLogCallbacks const*                 log,
+                          IMqttCommandCallbacks const*             cmd,
+                          IMqttConnectionCallbacks const*          con)
+{
+    switch (IMqttClient::Backend::DEFAULT == backend ? defaultBackend() : backend) {
+#ifdef IMQTT_USE_MOSQ
+    case IMqttClient::Backend::MOSQUITTO:
+        return unique_ptr<MosquittoClient>(new MosquittoClient(params, msg, log, cmd, con));
+#endif
+#ifdef IMQTT_USE_PAHO
+    case IMqttClient::Backend::PAHO:
+        return unique_ptr<PahoClient>(new PahoClient(params, msg, log, cmd, con));
+#endif
+#ifdef IMQTT_USE_NATIVE
+    case IMqttClient::Backend::NATIVE:
+        return unique_ptr<NativeClient>(new NativeClient(params, msg, log, cmd, con));
+#endif
+#ifdef IMQTT_USE_LOOPBACK
+    case IMqttClient::Backend::LOOPBACK:
+        return unique_ptr<LoopbackClient>(new LoopbackClient(params, msg, log, cmd, con));
+#endif
+    default:
+        throw runtime_error("MQTT backend not available, it has to be enabled via CMake");
+    }
+}
+}  // namespace i_mqtt_client
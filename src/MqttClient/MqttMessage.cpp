@@ -28,6 +28,11 @@ MqttMessage::MqttMessage(string const& topic, payload_t const& payload, QOS qos,
 {
 }
 
+MqttMessage::MqttMessage(string&& topic, vector<payloadRaw_t>&& payload, QOS qos, bool retain)
+  : IMqttMessage(move(topic), move(payload), qos, retain)
+{
+}
+
 string
 MqttMessage::ToString(void) const noexcept
 {
@@ -52,6 +57,9 @@ MqttMessage::ToString(void) const noexcept
     if (!payloadContentType.empty()) {
         str += "[contentType]:\t" + payloadContentType + "\n";
     }
+    for (auto id : subscriptionIds) {
+        str += "[subscrId]:\t" + to_string(id) + "\n";
+    }
     return str + "~~~";
 }
 
@@ -73,4 +81,13 @@ MqttMessageFactory::Create(string const& topic, IMqttMessage::payload_t&& payloa
 {
     return upMqttMessage_t(new MqttMessage(topic, payload, qos, retain));
 }
+
+upMqttMessage_t
+MqttMessageFactory::Create(string&&                             topic,
+                           vector<IMqttMessage::payloadRaw_t>&& payload,
+                           IMqttMessage::QOS                    qos,
+                           bool                                 retain)
+{
+    return upMqttMessage_t(new MqttMessage(move(topic), move(payload), qos, retain));
+}
 }  // namespace i_mqtt_client
@@ -33,5 +33,6 @@ public:
     virtual inline std::string ToString(void) const noexcept override;
 
     MqttMessage(std::string const&, payload_t const&, QOS, bool);
+    MqttMessage(std::string&&, std::vector<payloadRaw_t>&&, QOS, bool);
 };
 }  // namespace i_mqtt_client
\ No newline at end of file
@@ -0,0 +1,201 @@
+/**
+ * @file MqttMetrics.cpp
+ * @author Timo Lange
+ * @brief Implementation of the metrics registry
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "MqttMetrics.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+static void
+appendHeader(string& text, string const& name, char const* help, char const* type)
+{
+    text += "# HELP " + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+}
+
+static void
+appendPerQos(string& text, string const& name, char const* help, array<uint64_t, 3> const& values)
+{
+    appendHeader(text, name, help, "counter");
+    for (size_t qos{0U}; qos < values.size(); qos++) {
+        text += name + "{qos=\"" + to_string(qos) + "\"} " + to_string(values[qos]) + "\n";
+    }
+}
+
+static string
+seconds(microseconds duration)
+{
+    /*to_string prints 6 decimals, which is exactly microseconds*/
+    return to_string(static_cast<double>(duration.count()) / 1e6);
+}
+
+static void
+appendDurations(string&                                    text,
+                string const&                              name,
+                char const*                                label,
+                IMqttClient::PublishLatencySnapshot const& s,
+                microseconds                               sum)
+{
+    auto quantile = [&](char const* q, microseconds value) {
+        text += name + "{callback=\"" + label + "\",quantile=\"" + q + "\"} " + seconds(value) + "\n";
+    };
+    quantile("0.5", s.p50);
+    quantile("0.9", s.p90);
+    quantile("0.99", s.p99);
+    quantile("0.999", s.p999);
+    text += name + "_sum{callback=\"" + label + "\"} " + seconds(sum) + "\n";
+    text += name + "_count{callback=\"" + label + "\"} " + to_string(s.completed) + "\n";
+}
+
+MqttMetrics::Shard&
+MqttMetrics::shard(void) noexcept
+{
+    /*threads are mapped to the shards round robin, in the order they record first*/
+    static atomic_uint      threads{0U};
+    static thread_local auto index{threads.fetch_add(1U, memory_order_relaxed) % shardCount};
+    return shards[index];
+}
+
+void
+MqttMetrics::MessageIn(IMqttMessage::QOS qos, size_t bytes) noexcept
+{
+    auto& s{shard()};
+    auto  i{static_cast<size_t>(qos) % qosCount};
+    s.messagesIn[i].fetch_add(1U, memory_order_relaxed);
+    s.bytesIn[i].fetch_add(bytes, memory_order_relaxed);
+}
+
+void
+MqttMetrics::MessageOut(IMqttMessage::QOS qos, size_t bytes) noexcept
+{
+    auto& s{shard()};
+    auto  i{static_cast<size_t>(qos) % qosCount};
+    s.messagesOut[i].fetch_add(1U, memory_order_relaxed);
+    s.bytesOut[i].fetch_add(bytes, memory_order_relaxed);
+}
+
+void
+MqttMetrics::PublishFailed(ReasonCode rc) noexcept
+{
+    auto i{static_cast<size_t>(rc)};
+    if (i < reasonCodeCount) {
+        shard().publishFailures[i].fetch_add(1U, memory_order_relaxed);
+    }
+}
+
+void
+MqttMetrics::Reconnected(void) noexcept
+{
+    reconnects.fetch_add(1U, memory_order_relaxed);
+}
+
+void
+MqttMetrics::DispatchQueueChanged(int64_t delta) noexcept
+{
+    auto depth{queueDepth.fetch_add(delta, memory_order_relaxed) + delta};
+    auto current{queueHighWaterMark.load(memory_order_relaxed)};
+    while (depth > current && !queueHighWaterMark.compare_exchange_weak(current, depth, memory_order_relaxed)) {
+    }
+}
+
+void
+MqttMetrics::CallbackDuration(Callback callback, microseconds duration) noexcept
+{
+    (Callback::DISPATCH == callback ? dispatchCallback : messageCallback).Record(duration);
+}
+
+IMqttMetrics::Snapshot
+MqttMetrics::GetSnapshot(void) const
+{
+    Snapshot                         snapshot;
+    array<uint64_t, reasonCodeCount> failures{};
+    for (auto const& s : shards) {
+        for (unsigned i{0U}; i < qosCount; i++) {
+            snapshot.messagesIn[i] += s.messagesIn[i].load(memory_order_relaxed);
+            snapshot.bytesIn[i] += s.bytesIn[i].load(memory_order_relaxed);
+            snapshot.messagesOut[i] += s.messagesOut[i].load(memory_order_relaxed);
+            snapshot.bytesOut[i] += s.bytesOut[i].load(memory_order_relaxed);
+        }
+        for (unsigned i{0U}; i < reasonCodeCount; i++) {
+            failures[i] += s.publishFailures[i].load(memory_order_relaxed);
+        }
+    }
+    for (unsigned i{0U}; i < reasonCodeCount; i++) {
+        if (failures[i]) {
+            snapshot.publishFailures[static_cast<ReasonCode>(i)] = failures[i];
+        }
+    }
+    snapshot.reconnects                 = reconnects.load(memory_order_relaxed);
+    snapshot.dispatchQueueDepth         = queueDepth.load(memory_order_relaxed);
+    snapshot.dispatchQueueHighWaterMark = queueHighWaterMark.load(memory_order_relaxed);
+    messageCallback.Snapshot(snapshot.messageCallback);
+    dispatchCallback.Snapshot(snapshot.dispatchCallback);
+    snapshot.messageCallbackSum  = messageCallback.Sum();
+    snapshot.dispatchCallbackSum = dispatchCallback.Sum();
+    return snapshot;
+}
+
+string
+MqttMetrics::ToPrometheus(string const& prefix) const
+{
+    auto   snapshot{GetSnapshot()};
+    auto   name = [&prefix](char const* metric) { return prefix + "_" + metric; };
+    string text;
+    appendPerQos(text, name("messages_received_total"), "Messages received from the broker.", snapshot.messagesIn);
+    appendPerQos(text, name("received_bytes_total"), "Payload bytes received from the broker.", snapshot.bytesIn);
+    appendPerQos(
+        text, name("messages_published_total"), "Messages handed over to the MQTT library.", snapshot.messagesOut);
+    appendPerQos(
+        text, name("published_bytes_total"), "Payload bytes handed over to the MQTT library.", snapshot.bytesOut);
+
+    auto failures{name("publish_failures_total")};
+    appendHeader(text, failures, "Publishes rejected before reaching the MQTT library.", "counter");
+    for (unsigned i{1U}; i < reasonCodeCount; i++) {
+        auto rc{static_cast<ReasonCode>(i)};
+        auto it{snapshot.publishFailures.find(rc)};
+        text += failures + "{reason=\"" + IMqttClient::ReasonCodeToStringRepr(rc).first + "\"} " +
+                to_string(snapshot.publishFailures.end() == it ? 0U : it->second) + "\n";
+    }
+
+    auto reconnectsName{name("reconnects_total")};
+    appendHeader(text, reconnectsName, "Connections established again after a connection loss.", "counter");
+    text += reconnectsName + " " + to_string(snapshot.reconnects) + "\n";
+    auto depth{name("dispatch_queue_depth")};
+    appendHeader(text, depth, "Messages waiting in dispatch queues.", "gauge");
+    text += depth + " " + to_string(snapshot.dispatchQueueDepth) + "\n";
+    auto highWaterMark{name("dispatch_queue_high_water_mark")};
+    appendHeader(text, highWaterMark, "Maximum of messages waiting in dispatch queues.", "gauge");
+    text += highWaterMark + " " + to_string(snapshot.dispatchQueueHighWaterMark) + "\n";
+
+    auto durations{name("callback_duration_seconds")};
+    appendHeader(text, durations, "Time spent delivering received messages.", "summary");
+    appendDurations(text, durations, "message", snapshot.messageCallback, snapshot.messageCallbackSum);
+    appendDurations(text, durations, "dispatch", snapshot.dispatchCallback, snapshot.dispatchCallbackSum);
+    return text;
+}
+
+shared_ptr<IMqttMetrics>
+MqttMetricsFactory::Create(void)
+{
+    return make_shared<MqttMetrics>();
+}
+}  // namespace i_mqtt_client
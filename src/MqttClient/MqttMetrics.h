@@ -0,0 +1,70 @@
+/**
+ * @file MqttMetrics.h
+ * @author Timo Lange
+ * @brief Class definition for the metrics registry
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "IMqttMetrics.h"
+#include "LatencyHistogram.h"
+
+namespace i_mqtt_client {
+class MqttMetrics final : public IMqttMetrics {
+private:
+    static constexpr unsigned shardCount{16U};
+    static constexpr unsigned qosCount{3U};
+    static constexpr unsigned reasonCodeCount{static_cast<unsigned>(ReasonCode::ERROR_TIMEOUT) + 1U};
+    static constexpr unsigned cacheLine{64U};
+
+    /*counters of the threads mapped to one shard, padded to not share a cache line with the next shard*/
+    struct Shard final {
+        std::array<std::atomic<std::uint64_t>, qosCount>        messagesIn{};
+        std::array<std::atomic<std::uint64_t>, qosCount>        bytesIn{};
+        std::array<std::atomic<std::uint64_t>, qosCount>        messagesOut{};
+        std::array<std::atomic<std::uint64_t>, qosCount>        bytesOut{};
+        std::array<std::atomic<std::uint64_t>, reasonCodeCount> publishFailures{};
+        char                                                    padding[cacheLine];
+    };
+
+    std::array<Shard, shardCount> shards;
+    std::atomic<std::uint64_t>    reconnects{0U};
+    std::atomic<std::int64_t>     queueDepth{0};
+    std::atomic<std::int64_t>     queueHighWaterMark{0};
+    LatencyHistogram              messageCallback;
+    LatencyHistogram              dispatchCallback;
+
+    Shard& shard(void) noexcept;
+
+    void        MessageIn(IMqttMessage::QOS, size_t) noexcept override;
+    void        MessageOut(IMqttMessage::QOS, size_t) noexcept override;
+    void        PublishFailed(ReasonCode) noexcept override;
+    void        Reconnected(void) noexcept override;
+    void        DispatchQueueChanged(std::int64_t) noexcept override;
+    void        CallbackDuration(Callback, std::chrono::microseconds) noexcept override;
+    Snapshot    GetSnapshot(void) const override;
+    std::string ToPrometheus(std::string const&) const override;
+
+public:
+    MqttMetrics(void)               = default;
+    virtual ~MqttMetrics() noexcept = default;
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,148 @@
+/**
+ * @file MqttTracer.cpp
+ * @author Timo Lange
+ * @brief Implementation of tracing the lifecycle of received messages
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "MqttTracer.h"
+
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+using traceClock_t = IMqttMessage::Trace::clock_t;
+
+static string
+jsonEscape(string const& txt)
+{
+    string escaped;
+    escaped.reserve(txt.size());
+    for (auto c : txt) {
+        switch (c) {
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20U) {
+                char code[8];
+                snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+                escaped += code;
+            }
+            else {
+                escaped += c;
+            }
+            break;
+        }
+    }
+    return escaped;
+}
+
+static void
+appendEvent(string&                         events,
+            IMqttMessage::Trace const&      trace,
+            char const*                     stage,
+            traceClock_t::time_point const& begin,
+            traceClock_t::time_point const& end)
+{
+    if (traceClock_t::time_point() == begin || traceClock_t::time_point() == end) {
+        return;
+    }
+    events += "{\"name\":\"" + string(stage) + "\",\"cat\":\"imqtt\",\"ph\":\"X\",\"ts\":" +
+              to_string(duration_cast<microseconds>(begin.time_since_epoch()).count()) +
+              ",\"dur\":" + to_string(duration_cast<microseconds>(end - begin).count()) +
+              ",\"pid\":1,\"tid\":" + to_string(trace.id) + ",\"args\":{\"topic\":\"" + jsonEscape(trace.topic) +
+              "\"}},\n";
+}
+
+static string
+chromeTraceEvents(IMqttMessage::Trace const& trace)
+{
+    /*the library stage ends when the message is handed over to the queue, or to the handler without a queue*/
+    auto libraryEnd{traceClock_t::time_point() != trace.enqueued ? trace.enqueued : trace.handlerStart};
+    string events;
+    appendEvent(events, trace, "library", trace.received, libraryEnd);
+    appendEvent(events, trace, "queue", trace.enqueued, trace.dequeued);
+    appendEvent(events, trace, "handler", trace.handlerStart, trace.handlerEnd);
+    return events;
+}
+
+MqttTracer::MqttTracer(Parameters const& parameters)
+  : params(parameters)
+{
+    if (params.sampleRate < 0.0 || params.sampleRate > 1.0) {
+        throw runtime_error("Sample rate of tracer has to be between 0 and 1");
+    }
+    if (!params.emit) {
+        throw runtime_error("Tracer needs an emitter for completed traces");
+    }
+}
+
+void
+MqttTracer::Sample(IMqttMessage& msg)
+{
+    auto now{traceClock_t::now()};
+    auto n{static_cast<double>(received.fetch_add(1U, memory_order_relaxed))};
+    /*every n-th message, whenever the expected number of sampled messages reaches the next integer*/
+    if (static_cast<uint64_t>((n + 1.0) * params.sampleRate) == static_cast<uint64_t>(n * params.sampleRate)) {
+        return;
+    }
+    auto trace{make_shared<IMqttMessage::Trace>()};
+    trace->id       = sampled.fetch_add(1U, memory_order_relaxed);
+    trace->topic    = msg.topic;
+    trace->received = now;
+    trace->tracer   = shared_from_this();
+    msg.trace       = move(trace);
+}
+
+void
+MqttTracer::Complete(IMqttMessage::Trace const& trace) const
+{
+    params.emit(trace);
+}
+
+shared_ptr<IMqttTracer>
+MqttTracerFactory::Create(IMqttTracer::Parameters const& params)
+{
+    return make_shared<MqttTracer>(params);
+}
+
+IMqttTracer::emit_t
+MqttTracerFactory::ChromeTraceWriter(ostream& out)
+{
+    struct Writer final {
+        mutex writerMutex;
+        bool  started{false};
+    };
+    auto writer{make_shared<Writer>()};
+    return [&out, writer](IMqttMessage::Trace const& trace) {
+        auto              events{chromeTraceEvents(trace)};
+        lock_guard<mutex> lock(writer->writerMutex);
+        if (!writer->started) {
+            out << "[\n";
+            writer->started = true;
+        }
+        out << events;
+    };
+}
+}  // namespace i_mqtt_client
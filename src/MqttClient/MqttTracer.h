@@ -0,0 +1,43 @@
+/**
+ * @file MqttTracer.h
+ * @author Timo Lange
+ * @brief Class definition for tracing the lifecycle of received messages
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "IMqttTracer.h"
+
+namespace i_mqtt_client {
+class MqttTracer final : public IMqttTracer, public std::enable_shared_from_this<MqttTracer> {
+private:
+    Parameters const           params;
+    std::atomic<std::uint64_t> received{0U};
+    std::atomic<std::uint64_t> sampled{0U};
+
+    void Sample(IMqttMessage&) override;
+    void Complete(IMqttMessage::Trace const&) const override;
+
+public:
+    explicit MqttTracer(Parameters const&);
+    virtual ~MqttTracer() noexcept = default;
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,304 @@
+/**
+ * @file Mqtt5Codec.cpp
+ * @author Timo Lange
+ * @brief Implementation of the MQTTv5 packet encoding and decoding
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "Mqtt5Codec.h"
+
+#include <limits>
+
+using namespace std;
+
+namespace i_mqtt_client {
+/*largest value of a variable byte integer*/
+static constexpr uint32_t maxVarInt{268435455U};
+
+constexpr size_t Mqtt5Writer::maxFixedHeaderSize;
+
+Mqtt5Writer::Mqtt5Writer(void)
+  : buf(maxFixedHeaderSize)
+{
+}
+
+void
+Mqtt5Writer::Byte(uint8_t value)
+{
+    buf.push_back(value);
+}
+
+void
+Mqtt5Writer::TwoByte(uint16_t value)
+{
+    buf.push_back(static_cast<uint8_t>(value >> 8U));
+    buf.push_back(static_cast<uint8_t>(value));
+}
+
+void
+Mqtt5Writer::FourByte(uint32_t value)
+{
+    TwoByte(static_cast<uint16_t>(value >> 16U));
+    TwoByte(static_cast<uint16_t>(value));
+}
+
+void
+Mqtt5Writer::VarInt(uint32_t value)
+{
+    if (value > maxVarInt) {
+        valid = false;
+        return;
+    }
+    do {
+        auto digit{static_cast<uint8_t>(value & 0x7FU)};
+        value >>= 7U;
+        buf.push_back(value ? static_cast<uint8_t>(digit | 0x80U) : digit);
+    } while (value);
+}
+
+void
+Mqtt5Writer::String(string const& value)
+{
+    Binary(reinterpret_cast<uint8_t const*>(value.data()), value.size());
+}
+
+void
+Mqtt5Writer::Binary(uint8_t const* data, size_t len)
+{
+    if (len > numeric_limits<uint16_t>::max()) {
+        valid = false;
+        return;
+    }
+    TwoByte(static_cast<uint16_t>(len));
+    buf.insert(buf.end(), data, data + len);
+}
+
+void
+Mqtt5Writer::Properties(Mqtt5Writer const& props)
+{
+    valid = valid && props.valid;
+    VarInt(static_cast<uint32_t>(props.Size()));
+    buf.insert(buf.end(), props.buf.begin() + maxFixedHeaderSize, props.buf.end());
+}
+
+vector<uint8_t>
+Mqtt5Writer::Finish(uint8_t typeAndFlags, size_t payloadSize, size_t& offset)
+{
+    auto remaining{Size() + payloadSize};
+    if (remaining > maxVarInt) {
+        valid = false;
+        remaining = 0U;
+    }
+    /*the remaining length is encoded right before the variable header*/
+    uint8_t encoded[maxFixedHeaderSize - 1U];
+    size_t  digits{0U};
+    do {
+        encoded[digits] = static_cast<uint8_t>(remaining & 0x7FU);
+        remaining >>= 7U;
+        if (remaining) {
+            encoded[digits] |= 0x80U;
+        }
+        digits++;
+    } while (remaining);
+    offset      = maxFixedHeaderSize - 1U - digits;
+    buf[offset] = typeAndFlags;
+    for (size_t i{0U}; i < digits; i++) {
+        buf[offset + 1U + i] = encoded[i];
+    }
+    return move(buf);
+}
+
+Mqtt5Reader::FixedHeader
+Mqtt5Reader::ReadFixedHeader(RingBuffer const& ring,
+                             uint8_t&          typeAndFlags,
+                             size_t&           headerSize,
+                             size_t&           remainingLength) noexcept
+{
+    remainingLength = 0U;
+    for (size_t i{1U}; i < Mqtt5Writer::maxFixedHeaderSize; i++) {
+        if (ring.Size() <= i) {
+            return FixedHeader::INCOMPLETE;
+        }
+        auto digit{ring[i]};
+        remainingLength |= static_cast<size_t>(digit & 0x7FU) << (7U * (i - 1U));
+        if (0U == (digit & 0x80U)) {
+            typeAndFlags = ring[0U];
+            headerSize   = i + 1U;
+            return FixedHeader::COMPLETE;
+        }
+    }
+    return FixedHeader::MALFORMED;
+}
+
+Mqtt5Reader::Mqtt5Reader(RingBuffer const& ringBuffer, size_t begin, size_t endPos) noexcept
+  : ring(ringBuffer)
+  , pos(begin)
+  , end(endPos)
+{
+}
+
+bool
+Mqtt5Reader::take(size_t len) noexcept
+{
+    if (!valid || len > end - pos) {
+        valid = false;
+        return false;
+    }
+    return true;
+}
+
+void
+Mqtt5Reader::skipBinary(void) noexcept
+{
+    auto len{static_cast<size_t>(TwoByte())};
+    if (take(len)) {
+        pos += len;
+    }
+}
+
+uint8_t
+Mqtt5Reader::Byte(void) noexcept
+{
+    if (!take(1U)) {
+        return 0U;
+    }
+    return ring[pos++];
+}
+
+uint16_t
+Mqtt5Reader::TwoByte(void) noexcept
+{
+    if (!take(2U)) {
+        return 0U;
+    }
+    auto value{static_cast<uint16_t>((ring[pos] << 8U) | ring[pos + 1U])};
+    pos += 2U;
+    return value;
+}
+
+uint32_t
+Mqtt5Reader::FourByte(void) noexcept
+{
+    auto high{static_cast<uint32_t>(TwoByte())};
+    return (high << 16U) | TwoByte();
+}
+
+uint32_t
+Mqtt5Reader::VarInt(void) noexcept
+{
+    uint32_t value{0U};
+    for (unsigned shift{0U}; shift < 28U; shift += 7U) {
+        auto digit{Byte()};
+        value |= static_cast<uint32_t>(digit & 0x7FU) << shift;
+        if (0U == (digit & 0x80U)) {
+            return value;
+        }
+    }
+    valid = false;
+    return 0U;
+}
+
+string
+Mqtt5Reader::String(void)
+{
+    auto   len{static_cast<size_t>(TwoByte())};
+    string value;
+    if (len && take(len)) {
+        value.resize(len);
+        ring.CopyOut(pos, len, reinterpret_cast<uint8_t*>(&value[0]));
+        pos += len;
+    }
+    return value;
+}
+
+void
+Mqtt5Reader::Binary(vector<uint8_t>& value)
+{
+    auto len{static_cast<size_t>(TwoByte())};
+    if (take(len)) {
+        value.resize(len);
+        ring.CopyOut(pos, len, value.data());
+        pos += len;
+    }
+}
+
+void
+Mqtt5Reader::Rest(vector<uint8_t>& value)
+{
+    value.resize(Remaining());
+    ring.CopyOut(pos, value.size(), value.data());
+    pos = end;
+}
+
+size_t
+Mqtt5Reader::PropertiesEnd(void) noexcept
+{
+    auto len{static_cast<size_t>(VarInt())};
+    if (!take(len)) {
+        return pos;
+    }
+    return pos + len;
+}
+
+void
+Mqtt5Reader::SkipProperty(uint8_t id)
+{
+    switch (id) {
+    case 0x01: /*payload format indicator*/
+    case 0x17: /*request problem information*/
+    case 0x19: /*request response information*/
+    case 0x24: /*maximum QoS*/
+    case 0x25: /*retain available*/
+    case 0x28: /*wildcard subscription available*/
+    case 0x29: /*subscription identifier available*/
+    case 0x2A: /*shared subscription available*/
+        (void)Byte();
+        break;
+    case 0x13: /*server keep alive*/
+    case 0x21: /*receive maximum*/
+    case 0x22: /*topic alias maximum*/
+    case 0x23: /*topic alias*/
+        (void)TwoByte();
+        break;
+    case 0x02: /*message expiry interval*/
+    case 0x11: /*session expiry interval*/
+    case 0x18: /*will delay interval*/
+    case 0x27: /*maximum packet size*/
+        (void)FourByte();
+        break;
+    case 0x0B: /*subscription identifier*/
+        (void)VarInt();
+        break;
+    case 0x26: /*user property*/
+        skipBinary();
+        /*fallthrough*/
+    case 0x03: /*content type*/
+    case 0x08: /*response topic*/
+    case 0x09: /*correlation data*/
+    case 0x12: /*assigned client identifier*/
+    case 0x15: /*authentication method*/
+    case 0x16: /*authentication data*/
+    case 0x1A: /*response information*/
+    case 0x1C: /*server reference*/
+    case 0x1F: /*reason string*/
+        skipBinary();
+        break;
+    default:
+        valid = false;
+        break;
+    }
+}
+}  // namespace i_mqtt_client
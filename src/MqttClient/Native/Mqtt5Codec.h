@@ -0,0 +1,149 @@
+/**
+ * @file Mqtt5Codec.h
+ * @author Timo Lange
+ * @brief Class definitions for encoding and decoding MQTTv5 packets
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "RingBuffer.h"
+
+namespace i_mqtt_client {
+/*MQTTv5 control packet types, as in the upper nibble of the fixed header*/
+enum class Mqtt5PacketType : std::uint8_t {
+    CONNECT     = 1,
+    CONNACK     = 2,
+    PUBLISH     = 3,
+    PUBACK      = 4,
+    PUBREC      = 5,
+    PUBREL      = 6,
+    PUBCOMP     = 7,
+    SUBSCRIBE   = 8,
+    SUBACK      = 9,
+    UNSUBSCRIBE = 10,
+    UNSUBACK    = 11,
+    PINGREQ     = 12,
+    PINGRESP    = 13,
+    DISCONNECT  = 14,
+    AUTH        = 15,
+};
+
+/*MQTTv5 property identifiers used by the native client*/
+enum class Mqtt5Property : std::uint8_t {
+    PAYLOAD_FORMAT_INDICATOR = 0x01,
+    CONTENT_TYPE             = 0x03,
+    RESPONSE_TOPIC           = 0x08,
+    CORRELATION_DATA         = 0x09,
+    SUBSCRIPTION_IDENTIFIER  = 0x0B,
+    SERVER_KEEP_ALIVE        = 0x13,
+    RECEIVE_MAXIMUM          = 0x21,
+    MAXIMUM_QOS              = 0x24,
+    RETAIN_AVAILABLE         = 0x25,
+    USER_PROPERTY            = 0x26,
+    MAXIMUM_PACKET_SIZE      = 0x27,
+};
+
+/*Encodes a packet into a single buffer, leaving room for the fixed header in front, as its remaining length is only
+ * known at the end. Payloads are not copied into the buffer, but sent from where they are.*/
+class Mqtt5Writer final {
+public:
+    static constexpr size_t maxFixedHeaderSize{5U};
+
+private:
+    std::vector<std::uint8_t> buf;
+    bool                      valid{true};
+
+public:
+    Mqtt5Writer(void);
+
+    void Byte(std::uint8_t);
+    void TwoByte(std::uint16_t);
+    void FourByte(std::uint32_t);
+    void VarInt(std::uint32_t);
+    void String(std::string const&);
+    void Binary(std::uint8_t const*, size_t);
+    /*writes the properties collected in another writer, prefixed with their length*/
+    void Properties(Mqtt5Writer const&);
+
+    bool Valid(void) const noexcept
+    {
+        return valid;
+    }
+    /*size of everything written after the fixed header*/
+    size_t Size(void) const noexcept
+    {
+        return buf.size() - maxFixedHeaderSize;
+    }
+    /*prepends the fixed header, payloadSize bytes are sent after the returned buffer, the packet starts at offset*/
+    std::vector<std::uint8_t> Finish(std::uint8_t typeAndFlags, size_t payloadSize, size_t& offset);
+};
+
+/*Decodes the fields of a single packet directly from the receive buffer. Reading beyond the end of the packet
+ * invalidates the reader, instead of throwing, so a malformed packet is detected once after decoding it.*/
+class Mqtt5Reader final {
+public:
+    enum class FixedHeader { INCOMPLETE, COMPLETE, MALFORMED };
+
+private:
+    RingBuffer const& ring;
+    size_t            pos;
+    size_t            end;
+    bool              valid{true};
+
+    bool take(size_t) noexcept;
+    void skipBinary(void) noexcept;
+
+public:
+    /*reads the fixed header of the packet at the read position of the ring*/
+    static FixedHeader ReadFixedHeader(RingBuffer const&,
+                                       std::uint8_t& typeAndFlags,
+                                       size_t&       headerSize,
+                                       size_t&       remainingLength) noexcept;
+
+    Mqtt5Reader(RingBuffer const&, size_t begin, size_t end) noexcept;
+
+    std::uint8_t  Byte(void) noexcept;
+    std::uint16_t TwoByte(void) noexcept;
+    std::uint32_t FourByte(void) noexcept;
+    std::uint32_t VarInt(void) noexcept;
+    std::string   String(void);
+    void          Binary(std::vector<std::uint8_t>&);
+    /*reads the rest of the packet*/
+    void Rest(std::vector<std::uint8_t>&);
+    /*reads the length of a property block, returns the position it ends at*/
+    size_t PropertiesEnd(void) noexcept;
+    /*skips the value of a property not evaluated*/
+    void SkipProperty(std::uint8_t id);
+
+    size_t Position(void) const noexcept
+    {
+        return pos;
+    }
+    size_t Remaining(void) const noexcept
+    {
+        return end - pos;
+    }
+    bool Valid(void) const noexcept
+    {
+        return valid;
+    }
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,1357 @@
+/**
+ * @file NativeClient.cpp
+ * @author Timo Lange
+ * @brief Implementation of the MQTTv5 client without an underlying MQTT library
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "NativeClient.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#include "IReconnectScheduler.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+#ifdef MSG_NOSIGNAL
+static constexpr int sendFlags{MSG_NOSIGNAL};
+#else
+static constexpr int sendFlags{0};
+#endif
+/*upper bound of the iovecs written at once*/
+static constexpr int maxIoVecs{64};
+
+constexpr size_t   NativeClient::receiveBufferSize;
+constexpr unsigned NativeClient::maxReceivesPerRead;
+
+static bool
+setNonBlocking(int fd) noexcept
+{
+    auto flags{fcntl(fd, F_GETFL, 0)};
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0 && fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+static string
+errnoToString(void)
+{
+    return string(strerror(errno));
+}
+
+NativeClient::NativeClient(IMqttClient::InitializeParameters const& parameters,
+                           IMqttMessageCallbacks const*             msg,
+                           IMqttLogCallbacks const*                 log,
+                           IMqttCommandCallbacks const*             cmd,
+                           IMqttConnectionCallbacks const*          con)
+  : MqttClientBase(parameters, msg, log, cmd, con)
+  , keepAlive(params.keepAliveInterval)
+{
+    libVersion = "native MQTTv5 client";
+    logCb->Log<LogLevel::INFO>([] { return "Initializing native client"; });
+    logCb->Log<LogLevel::INFO>([&] { return "Broker-Address: " + params.hostAddress + ":" + to_string(params.port); });
+
+    if (params.reconnectDelayMinLower < 0 || params.reconnectDelayMinUpper < 0 ||
+        params.reconnectDelayMinLower > params.reconnectDelayMinUpper) {
+        throw runtime_error("reconnectDelay not properly set");
+    }
+    if (params.keepAliveInterval < 0 || params.keepAliveInterval > 0xFFFF) {
+        throw runtime_error("keepAliveInterval not properly set");
+    }
+    if (params.clientId.size() > 0xFFFFU || params.mqttUsername.size() > 0xFFFFU ||
+        params.mqttPassword.size() > 0xFFFFU) {
+        throw runtime_error("clientId or MQTT credentials too long");
+    }
+    if (!params.native.maxPacketSize) {
+        throw runtime_error("maxPacketSize not properly set");
+    }
+    reconnectDelayMin =
+        params.reconnectDelayMin +
+        uniform_int_distribution<int>(params.reconnectDelayMinLower, params.reconnectDelayMinUpper)(rndGenerator);
+    logCb->Log<LogLevel::DEBUG>([&] {
+        return "Reconnect delay min: " + to_string(reconnectDelayMin) + "," +
+               " max: " + to_string(params.reconnectDelayMax);
+    });
+
+    if (params.externalLoop) {
+        logCb->Log<LogLevel::INFO>([] { return "Native client is driven by an external loop"; });
+        if (params.reconnectScheduler) {
+            logCb->Log<LogLevel::WARNING>([] {
+                return "Reconnects are scheduled by the external loop, ignoring reconnectScheduler";
+            });
+        }
+        return;
+    }
+    if (pipe(wakeUpPipe) != 0 || !setNonBlocking(wakeUpPipe[0]) || !setNonBlocking(wakeUpPipe[1])) {
+        throw runtime_error("Was not able to create wake up pipe: " + errnoToString());
+    }
+    logCb->Log<LogLevel::INFO>([] { return "Starting native client loop"; });
+    loopThread = thread(&NativeClient::loop, this);
+}
+
+NativeClient::~NativeClient() noexcept
+{
+    stopPublishing();
+    if (usesScheduler()) {
+        params.reconnectScheduler->Forget(this);
+    }
+    logCb->Log<LogLevel::INFO>([] { return "Deinitializing native client"; });
+    if (IsConnected()) {
+        DisconnectAsync(Mqtt5ReasonCode::SUCCESS);
+    }
+    if (loopThread.joinable()) {
+        loopExit = true;
+        wakeUpLoop();
+        loopThread.join();
+    }
+    if (sock >= 0) {
+        close(sock);
+    }
+    for (auto fd : wakeUpPipe) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+NativeClient::spOutPacket_t
+NativeClient::finish(Mqtt5Writer& writer, uint8_t typeAndFlags)
+{
+    auto packet{make_shared<OutPacket>()};
+    packet->header = writer.Finish(typeAndFlags, 0U, packet->offset);
+    return packet;
+}
+
+void
+NativeClient::setPacketId(OutPacket& packet, size_t pos, uint16_t id)
+{
+    packet.header[pos]      = static_cast<uint8_t>(id >> 8U);
+    packet.header[pos + 1U] = static_cast<uint8_t>(id);
+}
+
+NativeClient::spOutPacket_t
+NativeClient::ackPacket(Mqtt5PacketType type, uint16_t id, Mqtt5ReasonCode rc)
+{
+    Mqtt5Writer writer;
+    writer.TwoByte(id);
+    /*reason code and properties may be omitted on success*/
+    if (Mqtt5ReasonCode::SUCCESS != rc) {
+        writer.Byte(static_cast<uint8_t>(rc));
+    }
+    /*the flags of PUBREL are fixed to 0b0010*/
+    auto flags{static_cast<uint8_t>(Mqtt5PacketType::PUBREL == type ? 0x02U : 0x00U)};
+    return finish(writer, static_cast<uint8_t>((static_cast<uint8_t>(type) << 4U) | flags));
+}
+
+size_t
+NativeClient::packetSize(OutPacket const& packet) noexcept
+{
+    return packet.header.size() - packet.offset + (packet.message ? packet.message->payload.size() : 0U);
+}
+
+NativeClient::spOutPacket_t
+NativeClient::connectPacket(void) const
+{
+    Mqtt5Writer writer;
+    writer.String("MQTT");
+    writer.Byte(5U);
+    uint8_t flags{0U};
+    if (params.cleanSession) {
+        flags |= 0x02U;
+    }
+    if (!params.mqttUsername.empty()) {
+        flags |= 0xC0U;
+    }
+    writer.Byte(flags);
+    writer.TwoByte(static_cast<uint16_t>(params.keepAliveInterval));
+    Mqtt5Writer props;
+    props.Byte(static_cast<uint8_t>(Mqtt5Property::MAXIMUM_PACKET_SIZE));
+    props.FourByte(params.native.maxPacketSize);
+    writer.Properties(props);
+    writer.String(params.clientId);
+    if (!params.mqttUsername.empty()) {
+        writer.String(params.mqttUsername);
+        writer.String(params.mqttPassword);
+    }
+    return finish(writer, static_cast<uint8_t>(Mqtt5PacketType::CONNECT) << 4U);
+}
+
+shared_ptr<addrinfo>
+NativeClient::resolve(void) const
+{
+    addrinfo hints{};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* pResult{nullptr};
+    auto      rc{getaddrinfo(params.hostAddress.c_str(), to_string(params.port).c_str(), &hints, &pResult)};
+    if (rc != 0) {
+        logCb->Log<LogLevel::ERROR>([&] {
+            return "Was not able to resolve broker address: " + string(gai_strerror(rc));
+        });
+        return nullptr;
+    }
+    return shared_ptr<addrinfo>(pResult, freeaddrinfo);
+}
+
+ReasonCode
+NativeClient::open(void)
+{
+    if (!brokerAddresses) {
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    for (auto pAddr{brokerAddresses.get()}; pAddr && sock < 0; pAddr = pAddr->ai_next) {
+        auto fd{socket(pAddr->ai_family, pAddr->ai_socktype, pAddr->ai_protocol)};
+        if (fd < 0) {
+            continue;
+        }
+        /*packets are batched already, they must not be delayed any further*/
+        int one{1};
+        (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+        (void)setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        if (setNonBlocking(fd) && (connect(fd, pAddr->ai_addr, pAddr->ai_addrlen) == 0 || EINPROGRESS == errno)) {
+            sock = fd;
+        }
+        else {
+            close(fd);
+        }
+    }
+    if (sock < 0) {
+        logCb->Log<LogLevel::ERROR>([&] { return "Was not able to connect to broker: " + errnoToString(); });
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    state          = State::CONNECTING;
+    connectStarted = clock_t::now();
+    return ReasonCode::OKAY;
+}
+
+bool
+NativeClient::finishConnect(void)
+{
+    int       error{0};
+    socklen_t len{sizeof(error)};
+    if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+        logCb->Log<LogLevel::ERROR>([&] {
+            return "Was not able to connect to broker: " + string(strerror(error ? error : errno));
+        });
+        return false;
+    }
+    state = State::AWAITING_CONNACK;
+    outQueue.push_front(connectPacket());
+    written = 0U;
+    return true;
+}
+
+bool
+NativeClient::flush(vector<int>& completed)
+{
+    while (!outQueue.empty()) {
+        iovec iov[maxIoVecs];
+        int   count{0};
+        auto  skip{written};
+        for (auto it{outQueue.begin()}; it != outQueue.end() && count < maxIoVecs - 1; ++it) {
+            auto& packet = **it;
+            iovec parts[2]{{packet.header.data() + packet.offset, packet.header.size() - packet.offset}, {nullptr, 0U}};
+            if (packet.message) {
+                parts[1].iov_base = const_cast<uint8_t*>(packet.message->payload.data());
+                parts[1].iov_len  = packet.message->payload.size();
+            }
+            for (auto& part : parts) {
+                if (skip >= part.iov_len) {
+                    skip -= part.iov_len;
+                    continue;
+                }
+                iov[count].iov_base = static_cast<uint8_t*>(part.iov_base) + skip;
+                iov[count].iov_len  = part.iov_len - skip;
+                skip                = 0U;
+                count++;
+            }
+        }
+        msghdr message{};
+        message.msg_iov    = iov;
+        message.msg_iovlen = static_cast<decltype(message.msg_iovlen)>(count);
+        auto sent{sendmsg(sock, &message, sendFlags)};
+        if (sent < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                return true;
+            }
+            logCb->Log<LogLevel::ERROR>([&] { return "Was not able to write to broker: " + errnoToString(); });
+            return false;
+        }
+        lastSent = clock_t::now();
+        written += static_cast<size_t>(sent);
+        while (!outQueue.empty() && written >= packetSize(*outQueue.front())) {
+            written -= packetSize(*outQueue.front());
+            if (outQueue.front()->token >= 0) {
+                completed.push_back(outQueue.front()->token);
+            }
+            outQueue.pop_front();
+        }
+    }
+    return true;
+}
+
+int
+NativeClient::nextQos0Token(void) noexcept
+{
+    /*QoS 0 publishes do not use a packet identifier, their tokens must not collide with the ones that do*/
+    lastQos0Token = INT_MAX == lastQos0Token ? 0x10000 : lastQos0Token + 1;
+    return lastQos0Token;
+}
+
+uint16_t
+NativeClient::nextPacketId(void) noexcept
+{
+    for (unsigned i{0U}; i < 0xFFFFU; i++) {
+        lastPacketId = 0xFFFFU == lastPacketId ? 1U : static_cast<uint16_t>(lastPacketId + 1U);
+        if (!inFlight.count(lastPacketId) && !pendingAcks.count(lastPacketId)) {
+            return lastPacketId;
+        }
+    }
+    return 0U;
+}
+
+void
+NativeClient::sendWithQuota(void)
+{
+    while (sendQuota && !quotaQueue.empty()) {
+        auto flight{inFlight.find(quotaQueue.front())};
+        quotaQueue.pop_front();
+        if (flight == inFlight.end()) {
+            continue;
+        }
+        sendQuota--;
+        if (flight->second.released) {
+            /*the broker has the message already, only the release is due*/
+            outQueue.push_back(ackPacket(Mqtt5PacketType::PUBREL, flight->first, Mqtt5ReasonCode::SUCCESS));
+            continue;
+        }
+        /*a publish sent before is retransmitted as duplicate*/
+        auto& fixedHeader = flight->second.packet->header[flight->second.packet->offset];
+        fixedHeader = static_cast<uint8_t>(flight->second.sent ? fixedHeader | 0x08U : fixedHeader & ~0x08U);
+        flight->second.sent = true;
+        outQueue.push_back(flight->second.packet);
+    }
+}
+
+milliseconds
+NativeClient::reconnectDelay(void)
+{
+    if (usesScheduler()) {
+        return params.reconnectScheduler->NextAttempt(this);
+    }
+    /*the delay doubles with every failed attempt, up to reconnectDelayMax*/
+    auto delay{seconds(reconnectDelayMin) * (1U << min(reconnectAttempts, 16U))};
+    reconnectAttempts++;
+    return duration_cast<milliseconds>(min(delay, seconds(max(reconnectDelayMin, params.reconnectDelayMax))));
+}
+
+milliseconds
+NativeClient::nextTimeout(void) const
+{
+    auto now{clock_t::now()};
+    auto due{now + seconds(1)};
+    switch (state) {
+    case State::DISCONNECTED:
+        if (connectRequested) {
+            due = min(due, reconnectAt);
+        }
+        break;
+    case State::CONNECTED:
+        if (keepAlive.count() > 0) {
+            due = min(due, (pingOutstanding ? pingSent : lastSent) + keepAlive);
+        }
+        break;
+    default:
+        break;
+    }
+    return max(duration_cast<milliseconds>(due - now), milliseconds(0));
+}
+
+void
+NativeClient::transmit(unique_lock<mutex>& lock)
+{
+    vector<int> completed;
+    auto        pending{false};
+    if (sock >= 0 && State::CONNECTING != state && !writeFailed) {
+        writeFailed = !flush(completed);
+        pending     = writeFailed || !outQueue.empty();
+    }
+    lock.unlock();
+    for (auto token : completed) {
+        notifyPublish(token, Mqtt5ReasonCode::SUCCESS);
+    }
+    /*the loop continues writing, or closes the failed connection*/
+    if (pending) {
+        wakeUpLoop();
+    }
+}
+
+void
+NativeClient::loop(void)
+{
+    while (!loopExit) {
+        pollfd fds[2]{{wakeUpPipe[0], POLLIN, 0}, {-1, POLLIN, 0}};
+        auto   timeout{milliseconds(0)};
+        auto   reconnect{false};
+        {
+            lock_guard<mutex> lock(ioMutex);
+            reconnect  = connectRequested && sock < 0 && clock_t::now() >= reconnectAt;
+            timeout    = nextTimeout();
+            fds[1].fd  = sock;
+        }
+        if (reconnect) {
+            (void)Reconnect();
+            continue;
+        }
+        if (WantWrite()) {
+            fds[1].events |= POLLOUT;
+        }
+        auto count{fds[1].fd >= 0 ? 2 : 1};
+        if (poll(fds, static_cast<nfds_t>(count), static_cast<int>(timeout.count())) < 0 && EINTR != errno) {
+            logCb->Log<LogLevel::ERROR>([&] { return "Native client loop failed to poll: " + errnoToString(); });
+        }
+        if (fds[0].revents & POLLIN) {
+            uint8_t buf[64];
+            while (read(wakeUpPipe[0], buf, sizeof(buf)) > 0) {
+            }
+        }
+        if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            (void)Read();
+        }
+        if (fds[1].revents & POLLOUT) {
+            (void)Write();
+        }
+        (void)Misc();
+    }
+}
+
+void
+NativeClient::closeConnection(Mqtt5ReasonCode rc)
+{
+    auto notify{false};
+    auto requested{false};
+    {
+        unordered_map<uint16_t, PendingAck> failed;
+        {
+            lock_guard<mutex> lock(ioMutex);
+            if (sock < 0) {
+                return;
+            }
+            notify    = connected;
+            requested = State::DISCONNECTING == state;
+            if (requested) {
+                rc = disconnectRc;
+            }
+            close(sock);
+            sock            = -1;
+            state           = State::DISCONNECTED;
+            connected       = false;
+            writeFailed     = false;
+            pingOutstanding = false;
+            written         = 0U;
+            outQueue.clear();
+            quotaQueue.clear();
+            failed.swap(pendingAcks);
+            if (connectRequested) {
+                recovering  = true;
+                reconnectAt = clock_t::now() + (params.externalLoop ? milliseconds(0) : reconnectDelay());
+            }
+        }
+        receiveBuffer.Clear();
+        /*acknowledgements of the connection closed will not arrive any more*/
+        for (auto const& ack : failed) {
+            vector<Mqtt5ReasonCode> rcs(ack.second.filters, Mqtt5ReasonCode::UNSPECIFIED_ERROR);
+            if (ack.second.subscribe) {
+                notifySubscribeFailure(ack.first, rcs);
+            }
+            else {
+                notifyUnSubscribeFailure(ack.first, rcs);
+            }
+        }
+    }
+    if (notify) {
+        auto logLvl{requested ? LogLevel::INFO : LogLevel::WARNING};
+        if (logCb->IsLogged(logLvl)) {
+            logCb->Log(logLvl, "Native client disconnected from broker, rc: " + Mqtt5ReasonCodeToStringRepr(rc).first);
+        }
+        notifyDisconnected(rc);
+    }
+}
+
+ReasonCode
+NativeClient::processPackets(void)
+{
+    for (;;) {
+        uint8_t typeAndFlags{0U};
+        size_t  headerSize{0U};
+        size_t  remaining{0U};
+        auto    header{Mqtt5Reader::ReadFixedHeader(receiveBuffer, typeAndFlags, headerSize, remaining)};
+        if (Mqtt5Reader::FixedHeader::INCOMPLETE == header) {
+            return ReasonCode::OKAY;
+        }
+        auto rc{Mqtt5ReasonCode::MALFORMED_PACKET};
+        if (Mqtt5Reader::FixedHeader::COMPLETE == header) {
+            if (headerSize + remaining > params.native.maxPacketSize) {
+                rc = Mqtt5ReasonCode::PACKET_TOO_LARGE;
+            }
+            else if (receiveBuffer.Size() < headerSize + remaining) {
+                /*the rest of the packet is received in place, it has to fit*/
+                receiveBuffer.Reserve(headerSize + remaining);
+                return ReasonCode::OKAY;
+            }
+            else {
+                Mqtt5Reader reader(receiveBuffer, headerSize, headerSize + remaining);
+                rc = handlePacket(typeAndFlags, reader);
+                receiveBuffer.Consume(headerSize + remaining);
+            }
+        }
+        if (Mqtt5ReasonCode::SUCCESS != rc) {
+            logCb->Log<LogLevel::ERROR>([&] {
+                return "Invalid packet from broker: " + Mqtt5ReasonCodeToStringRepr(rc).first;
+            });
+            {
+                unique_lock<mutex> lock(ioMutex);
+                if (sock >= 0 && State::CONNECTING != state) {
+                    Mqtt5Writer writer;
+                    writer.Byte(static_cast<uint8_t>(rc));
+                    outQueue.push_back(finish(writer, static_cast<uint8_t>(Mqtt5PacketType::DISCONNECT) << 4U));
+                    transmit(lock);
+                }
+            }
+            closeConnection(rc);
+            return ReasonCode::ERROR_GENERAL;
+        }
+        if (!IsConnected() && receiveBuffer.Size() == 0U) {
+            /*the connection may have been closed while handling the packet*/
+            return ReasonCode::OKAY;
+        }
+    }
+}
+
+Mqtt5ReasonCode
+NativeClient::handlePacket(uint8_t typeAndFlags, Mqtt5Reader& reader)
+{
+    auto type{static_cast<Mqtt5PacketType>(typeAndFlags >> 4U)};
+    switch (type) {
+    case Mqtt5PacketType::CONNACK:
+        return handleConnAck(reader);
+    case Mqtt5PacketType::PUBLISH:
+        return handlePublish(static_cast<uint8_t>(typeAndFlags & 0x0FU), reader);
+    case Mqtt5PacketType::PUBACK:
+        /*fallthrough*/
+    case Mqtt5PacketType::PUBREC:
+        /*fallthrough*/
+    case Mqtt5PacketType::PUBCOMP:
+        return handlePublishAck(type, reader);
+    case Mqtt5PacketType::PUBREL:
+        return handlePubRel(reader);
+    case Mqtt5PacketType::SUBACK:
+        /*fallthrough*/
+    case Mqtt5PacketType::UNSUBACK:
+        return handleSubscribeAck(type, reader);
+    case Mqtt5PacketType::PINGRESP: {
+        lock_guard<mutex> lock(ioMutex);
+        pingOutstanding = false;
+        return Mqtt5ReasonCode::SUCCESS;
+    }
+    case Mqtt5PacketType::DISCONNECT:
+        return handleDisconnect(reader);
+    default:
+        return Mqtt5ReasonCode::PROTOCOL_ERROR;
+    }
+}
+
+Mqtt5ReasonCode
+NativeClient::handleConnAck(Mqtt5Reader& reader)
+{
+    auto     sessionPresent{(reader.Byte() & 0x01U) != 0U};
+    auto     rc{static_cast<Mqtt5ReasonCode>(reader.Byte())};
+    uint16_t receiveMaximum{0xFFFFU};
+    uint32_t maximumPacketSize{0U};
+    uint8_t  maximumQos{2U};
+    uint8_t  retain{1U};
+    int      serverKeepAlive{-1};
+    auto     propertiesEnd{reader.PropertiesEnd()};
+    while (reader.Valid() && reader.Position() < propertiesEnd) {
+        auto id{reader.Byte()};
+        switch (static_cast<Mqtt5Property>(id)) {
+        case Mqtt5Property::RECEIVE_MAXIMUM:
+            receiveMaximum = reader.TwoByte();
+            break;
+        case Mqtt5Property::MAXIMUM_PACKET_SIZE:
+            maximumPacketSize = reader.FourByte();
+            break;
+        case Mqtt5Property::MAXIMUM_QOS:
+            /*only sent by brokers not supporting QoS 2*/
+            maximumQos = reader.Byte();
+            if (maximumQos > 1U) {
+                return Mqtt5ReasonCode::PROTOCOL_ERROR;
+            }
+            break;
+        case Mqtt5Property::RETAIN_AVAILABLE:
+            retain = reader.Byte();
+            if (retain > 1U) {
+                return Mqtt5ReasonCode::PROTOCOL_ERROR;
+            }
+            break;
+        case Mqtt5Property::SERVER_KEEP_ALIVE:
+            serverKeepAlive = reader.TwoByte();
+            break;
+        default:
+            reader.SkipProperty(id);
+            break;
+        }
+    }
+    /*a property running past the property length is malformed, not a property followed by garbage*/
+    if (!reader.Valid() || reader.Position() != propertiesEnd) {
+        return Mqtt5ReasonCode::MALFORMED_PACKET;
+    }
+    if (0U == receiveMaximum) {
+        return Mqtt5ReasonCode::PROTOCOL_ERROR;
+    }
+    if (Mqtt5ReasonCode::SUCCESS != rc) {
+        logCb->Log<LogLevel::WARNING>([&] {
+            return "Native client connected to broker, rc: " + Mqtt5ReasonCodeToStringRepr(rc).first;
+        });
+        notifyConnected(rc, false);
+        closeConnection(rc);
+        return Mqtt5ReasonCode::SUCCESS;
+    }
+    auto        wasRecovering{false};
+    vector<int> completed;
+    {
+        unique_lock<mutex> lock(ioMutex);
+        if (State::AWAITING_CONNACK != state) {
+            return Mqtt5ReasonCode::PROTOCOL_ERROR;
+        }
+        state             = State::CONNECTED;
+        connected         = true;
+        sendQuota         = receiveMaximum;
+        maxPacketSize     = maximumPacketSize;
+        maxQos            = maximumQos;
+        retainAvailable   = retain != 0U;
+        pingOutstanding   = false;
+        reconnectAttempts = 0U;
+        wasRecovering     = recovering;
+        recovering        = false;
+        if (serverKeepAlive >= 0) {
+            keepAlive = seconds(serverKeepAlive);
+        }
+        if (!sessionPresent) {
+            receivedQos2.clear();
+        }
+        /*publishes in flight are resent, as duplicates if the broker kept the session, else as new ones*/
+        for (auto it{inFlight.begin()}; it != inFlight.end();) {
+            auto& flight = it->second;
+            if (!sessionPresent && flight.released) {
+                /*the broker took over the message already*/
+                completed.push_back(it->first);
+                it = inFlight.erase(it);
+                continue;
+            }
+            if (!sessionPresent) {
+                flight.sent = false;
+            }
+            quotaQueue.push_back(it->first);
+            ++it;
+        }
+        sendWithQuota();
+        transmit(lock);
+    }
+    logCb->Log<LogLevel::INFO>([&] {
+        return "Native client connected to broker, rc: " + Mqtt5ReasonCodeToStringRepr(rc).first;
+    });
+    if (wasRecovering && usesScheduler()) {
+        params.reconnectScheduler->Connected(this);
+    }
+    for (auto token : completed) {
+        notifyPublish(token, Mqtt5ReasonCode::SUCCESS);
+    }
+    notifyConnected(rc, sessionPresent);
+    return Mqtt5ReasonCode::SUCCESS;
+}
+
+Mqtt5ReasonCode
+NativeClient::handlePublish(uint8_t flags, Mqtt5Reader& reader)
+{
+    auto qos{static_cast<uint8_t>((flags >> 1U) & 0x03U)};
+    if (qos > 2U) {
+        return Mqtt5ReasonCode::MALFORMED_PACKET;
+    }
+    auto     topic{reader.String()};
+    uint16_t id{0U};
+    if (qos) {
+        id = reader.TwoByte();
+    }
+
+    IMqttMessage::userProps_t            userProps;
+    IMqttMessage::correlationDataProps_t correlationData;
+    IMqttMessage::subscriptionIds_t      subscriptionIds;
+    string                               responseTopic;
+    string                               contentType;
+    auto                                 formatIndicator{IMqttMessage::FormatIndicator::UNSPECIFIED};
+    auto                                 propertiesEnd{reader.PropertiesEnd()};
+    while (reader.Valid() && reader.Position() < propertiesEnd) {
+        auto property{reader.Byte()};
+        switch (static_cast<Mqtt5Property>(property)) {
+        case Mqtt5Property::PAYLOAD_FORMAT_INDICATOR:
+            formatIndicator = reader.Byte() == 1U ? IMqttMessage::FormatIndicator::UTF8
+                                                  : IMqttMessage::FormatIndicator::UNSPECIFIED;
+            break;
+        case Mqtt5Property::CONTENT_TYPE:
+            contentType = reader.String();
+            break;
+        case Mqtt5Property::RESPONSE_TOPIC:
+            responseTopic = reader.String();
+            break;
+        case Mqtt5Property::CORRELATION_DATA:
+            reader.Binary(correlationData);
+            break;
+        case Mqtt5Property::SUBSCRIPTION_IDENTIFIER:
+            subscriptionIds.push_back(reader.VarInt());
+            break;
+        case Mqtt5Property::USER_PROPERTY: {
+            auto key{reader.String()};
+            auto value{reader.String()};
+            if (!userProps.insert(make_pair(move(key), move(value))).second) {
+                logCb->Log<LogLevel::ERROR>([] { return "Was not able to add user props - ignoring"; });
+            }
+            break;
+        }
+        default:
+            reader.SkipProperty(property);
+            break;
+        }
+    }
+    /*a property running past the property length would eat up the payload*/
+    if (!reader.Valid() || reader.Position() != propertiesEnd) {
+        return Mqtt5ReasonCode::MALFORMED_PACKET;
+    }
+    vector<IMqttMessage::payloadRaw_t> payload;
+    reader.Rest(payload);
+    if (!reader.Valid()) {
+        return Mqtt5ReasonCode::MALFORMED_PACKET;
+    }
+    /*no topic alias maximum is announced, so the broker must not use aliases*/
+    if (topic.empty() || (qos && !id)) {
+        return Mqtt5ReasonCode::PROTOCOL_ERROR;
+    }
+
+    logCb->Log<LogLevel::DEBUG>([] { return "Native client received message"; });
+    auto duplicate{false};
+    if (2U == qos) {
+        lock_guard<mutex> lock(ioMutex);
+        duplicate = !receivedQos2.insert(id).second;
+    }
+    if (!duplicate) {
+        auto mqttMessage{MqttMessageFactory::Create(
+            move(topic), move(payload), static_cast<IMqttMessage::QOS>(qos), (flags & 0x01U) != 0U)};
+        mqttMessage->messageId              = id;
+        mqttMessage->userProps              = move(userProps);
+        mqttMessage->correlationDataProps   = move(correlationData);
+        mqttMessage->responseTopic          = move(responseTopic);
+        mqttMessage->payloadContentType     = move(contentType);
+        mqttMessage->payloadFormatIndicator = formatIndicator;
+        mqttMessage->subscriptionIds        = move(subscriptionIds);
+        notifyMessage(move(mqttMessage));
+    }
+    if (qos) {
+        unique_lock<mutex> lock(ioMutex);
+        if (State::CONNECTED == state) {
+            outQueue.push_back(ackPacket(
+                1U == qos ? Mqtt5PacketType::PUBACK : Mqtt5PacketType::PUBREC, id, Mqtt5ReasonCode::SUCCESS));
+            transmit(lock);
+        }
+    }
+    return Mqtt5ReasonCode::SUCCESS;
+}
+
+Mqtt5ReasonCode
+NativeClient::handlePublishAck(Mqtt5PacketType type, Mqtt5Reader& reader)
+{
+    auto id{reader.TwoByte()};
+    auto rc{Mqtt5ReasonCode::SUCCESS};
+    if (reader.Remaining()) {
+        rc = static_cast<Mqtt5ReasonCode>(reader.Byte());
+    }
+    if (!reader.Valid()) {
+        return Mqtt5ReasonCode::MALFORMED_PACKET;
+    }
+    unique_lock<mutex> lock(ioMutex);
+    auto               flight{inFlight.find(id)};
+    if (flight == inFlight.end()) {
+        lock.unlock();
+        logCb->Log<LogLevel::WARNING>([&] {
+            return "Native client publish completed for unknown token: " + to_string(id);
+        });
+        if (Mqtt5PacketType::PUBREC == type) {
+            lock.lock();
+            outQueue.push_back(ackPacket(Mqtt5PacketType::PUBREL, id, Mqtt5ReasonCode::PACKET_IDENTIFIER_NOT_FOUND));
+            transmit(lock);
+        }
+        return Mqtt5ReasonCode::SUCCESS;
+    }
+    if (Mqtt5PacketType::PUBREC == type && rc < Mqtt5ReasonCode::UNSPECIFIED_ERROR) {
+        flight->second.released = true;
+        outQueue.push_back(ackPacket(Mqtt5PacketType::PUBREL, id, Mqtt5ReasonCode::SUCCESS));
+        transmit(lock);
+        return Mqtt5ReasonCode::SUCCESS;
+    }
+    inFlight.erase(flight);
+    sendQuota++;
+    sendWithQuota();
+    transmit(lock);
+    logCb->Log<LogLevel::DEBUG>([&] {
+        return "Native client publish completed for token: " + to_string(id) +
+               ", rc: " + Mqtt5ReasonCodeToStringRepr(rc).first;
+    });
+    notifyPublish(id, rc);
+    return Mqtt5ReasonCode::SUCCESS;
+}
+
+Mqtt5ReasonCode
+NativeClient::handlePubRel(Mqtt5Reader& reader)
+{
+    auto id{reader.TwoByte()};
+    if (!reader.Valid()) {
+        return Mqtt5ReasonCode::MALFORMED_PACKET;
+    }
+    unique_lock<mutex> lock(ioMutex);
+    auto rc{receivedQos2.erase(id) ? Mqtt5ReasonCode::SUCCESS : Mqtt5ReasonCode::PACKET_IDENTIFIER_NOT_FOUND};
+    outQueue.push_back(ackPacket(Mqtt5PacketType::PUBCOMP, id, rc));
+    transmit(lock);
+    return Mqtt5ReasonCode::SUCCESS;
+}
+
+Mqtt5ReasonCode
+NativeClient::handleSubscribeAck(Mqtt5PacketType type, Mqtt5Reader& reader)
+{
+    auto id{reader.TwoByte()};
+    auto propertiesEnd{reader.PropertiesEnd()};
+    while (reader.Valid() && reader.Position() < propertiesEnd) {
+        reader.SkipProperty(reader.Byte());
+    }
+    /*a property running past the property length would eat up the reason codes*/
+    if (!reader.Valid() || reader.Position() != propertiesEnd) {
+        return Mqtt5ReasonCode::MALFORMED_PACKET;
+    }
+    vector<Mqtt5ReasonCode> rcs;
+    while (reader.Valid() && reader.Remaining()) {
+        rcs.push_back(static_cast<Mqtt5ReasonCode>(reader.Byte()));
+    }
+    if (!reader.Valid()) {
+        return Mqtt5ReasonCode::MALFORMED_PACKET;
+    }
+    {
+        lock_guard<mutex> lock(ioMutex);
+        if (!pendingAcks.erase(id)) {
+            logCb->Log<LogLevel::WARNING>([&] {
+                return "Native client got acknowledgement for unknown token: " + to_string(id);
+            });
+            return Mqtt5ReasonCode::SUCCESS;
+        }
+    }
+    if (Mqtt5PacketType::UNSUBACK == type) {
+        logCb->Log<LogLevel::DEBUG>([] { return "Native client UnSubscribe completed"; });
+        notifyUnSubscribe(id, rcs);
+        return Mqtt5ReasonCode::SUCCESS;
+    }
+    for (auto rc : rcs) {
+        logCb->Log<LogLevel::DEBUG>([&] {
+            return "Native client Subscribe completed with: " + Mqtt5ReasonCodeToStringRepr(rc).first;
+        });
+    }
+    auto failed{all_of(rcs.begin(), rcs.end(), [](Mqtt5ReasonCode rc) {
+        return rc >= Mqtt5ReasonCode::UNSPECIFIED_ERROR;
+    })};
+    if (failed) {
+        notifySubscribeFailure(id, rcs);
+    }
+    else {
+        notifySubscribe(id, rcs);
+    }
+    return Mqtt5ReasonCode::SUCCESS;
+}
+
+Mqtt5ReasonCode
+NativeClient::handleDisconnect(Mqtt5Reader& reader)
+{
+    auto rc{Mqtt5ReasonCode::SUCCESS};
+    if (reader.Remaining()) {
+        rc = static_cast<Mqtt5ReasonCode>(reader.Byte());
+    }
+    logCb->Log<LogLevel::WARNING>([&] {
+        return "Broker closed the connection, rc: " + Mqtt5ReasonCodeToStringRepr(rc).first;
+    });
+    closeConnection(rc);
+    return Mqtt5ReasonCode::SUCCESS;
+}
+
+ReasonCode
+NativeClient::sendTracked(Mqtt5Writer& writer, size_t idPos, uint8_t typeAndFlags, PendingAck ack, int* token)
+{
+    auto packet{finish(writer, typeAndFlags)};
+    if (!writer.Valid()) {
+        logCb->Log<LogLevel::ERROR>([] { return "Invalid topic filter"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    unique_lock<mutex> lock(ioMutex);
+    if (State::CONNECTED != state) {
+        logCb->Log<LogLevel::WARNING>([] { return "Native client is not connected"; });
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    auto id{nextPacketId()};
+    if (!id) {
+        logCb->Log<LogLevel::ERROR>([] { return "No packet identifier available"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    setPacketId(*packet, idPos, id);
+    pendingAcks[id] = ack;
+    outQueue.push_back(move(packet));
+    if (token) {
+        *token = id;
+    }
+    transmit(lock);
+    return ReasonCode::OKAY;
+}
+
+void
+NativeClient::wakeUpLoop(void) const
+{
+    if (!params.externalLoop) {
+        uint8_t wake{0U};
+        auto    written{write(wakeUpPipe[1], &wake, sizeof(wake))};
+        (void)written;
+        return;
+    }
+    lock_guard<mutex> lock(wakeUpMutex);
+    if (wakeUp) {
+        wakeUp();
+    }
+}
+
+bool
+NativeClient::usesScheduler(void) const noexcept
+{
+    return params.reconnectScheduler && !params.externalLoop;
+}
+
+ReasonCode
+NativeClient::ConnectAsync(void)
+{
+    logCb->Log<LogLevel::INFO>([&] {
+        return "Connecting to broker async: " + params.hostAddress + ":" + to_string(params.port);
+    });
+    connectRequested = true;
+    /*resolved once, outside of the lock, reconnects use the same addresses*/
+    auto addresses{resolve()};
+    auto status{ReasonCode::OKAY};
+    {
+        lock_guard<mutex> lock(ioMutex);
+        reconnectAttempts = 0U;
+        if (addresses) {
+            brokerAddresses = move(addresses);
+        }
+        if (sock < 0) {
+            status = open();
+            if (ReasonCode::OKAY != status && !params.externalLoop) {
+                recovering  = true;
+                reconnectAt = clock_t::now() + reconnectDelay();
+            }
+        }
+    }
+    wakeUpLoop();
+    return status;
+}
+
+ReasonCode
+NativeClient::DisconnectAsync(Mqtt5ReasonCode rc)
+{
+    logCb->Log<LogLevel::INFO>([] { return "Disconnecting from broker"; });
+    connectRequested = false;
+    if (usesScheduler()) {
+        params.reconnectScheduler->Forget(this);
+    }
+    unique_lock<mutex> lock(ioMutex);
+    recovering = false;
+    if (sock < 0) {
+        logCb->Log<LogLevel::WARNING>([] { return "Native client is not connected"; });
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    disconnectRc = rc;
+    if (State::CONNECTED == state) {
+        Mqtt5Writer writer;
+        if (Mqtt5ReasonCode::SUCCESS != rc) {
+            writer.Byte(static_cast<uint8_t>(rc));
+        }
+        outQueue.push_back(finish(writer, static_cast<uint8_t>(Mqtt5PacketType::DISCONNECT) << 4U));
+    }
+    else {
+        outQueue.clear();
+    }
+    /*the loop closes the connection, once everything is written*/
+    state = State::DISCONNECTING;
+    transmit(lock);
+    wakeUpLoop();
+    return ReasonCode::OKAY;
+}
+
+ReasonCode
+NativeClient::subscribe(vector<TopicSubscription> const& subscriptions, uint32_t subscriptionId, int* token)
+{
+    Mqtt5Writer writer;
+    auto        idPos{Mqtt5Writer::maxFixedHeaderSize + writer.Size()};
+    writer.TwoByte(0U);
+    Mqtt5Writer props;
+    if (subscriptionId) {
+        props.Byte(static_cast<uint8_t>(Mqtt5Property::SUBSCRIPTION_IDENTIFIER));
+        props.VarInt(subscriptionId);
+    }
+    writer.Properties(props);
+    /*unlike the MQTT libraries, every topic filter has its own QoS and options within the same packet*/
+    for (auto const& subscription : subscriptions) {
+        logCb->Log<LogLevel::DEBUG>([&] { return "Subscribing to topic: \"" + subscription.topic + "\""; });
+        auto options{static_cast<uint8_t>(subscription.qos)};
+        if (!params.allowLocalTopics) {
+            options |= 0x04U; /*no local*/
+        }
+        if (!subscription.getRetained) {
+            options |= 0x20U; /*retain handling: do not send*/
+        }
+        writer.String(subscription.topic);
+        writer.Byte(options);
+    }
+    PendingAck ack;
+    ack.subscribe = true;
+    ack.filters   = subscriptions.size();
+    /*the flags of SUBSCRIBE are fixed to 0b0010*/
+    auto typeAndFlags{static_cast<uint8_t>((static_cast<uint8_t>(Mqtt5PacketType::SUBSCRIBE) << 4U) | 0x02U)};
+    return sendTracked(writer, idPos, typeAndFlags, ack, token);
+}
+
+ReasonCode
+NativeClient::unSubscribe(vector<string> const& topics, int* token)
+{
+    Mqtt5Writer writer;
+    auto        idPos{Mqtt5Writer::maxFixedHeaderSize + writer.Size()};
+    writer.TwoByte(0U);
+    writer.Properties(Mqtt5Writer());
+    for (auto const& topic : topics) {
+        logCb->Log<LogLevel::DEBUG>([&] { return "Unsubscribing from topic: \"" + topic + "\""; });
+        writer.String(topic);
+    }
+    PendingAck ack;
+    ack.subscribe = false;
+    ack.filters   = topics.size();
+    /*the flags of UNSUBSCRIBE are fixed to 0b0010*/
+    auto typeAndFlags{static_cast<uint8_t>((static_cast<uint8_t>(Mqtt5PacketType::UNSUBSCRIBE) << 4U) | 0x02U)};
+    return sendTracked(writer, idPos, typeAndFlags, ack, token);
+}
+
+ReasonCode
+NativeClient::publish(upMqttMessage_t mqttMsg, int* token)
+{
+    logCb->Log<LogLevel::DEBUG>([&] { return "Publishing to topic: \"" + mqttMsg->topic + "\""; });
+
+    /*properties are only sent, if set*/
+    Mqtt5Writer props;
+    if (IMqttMessage::FormatIndicator::UTF8 == mqttMsg->payloadFormatIndicator) {
+        props.Byte(static_cast<uint8_t>(Mqtt5Property::PAYLOAD_FORMAT_INDICATOR));
+        props.Byte(1U);
+    }
+    if (!mqttMsg->payloadContentType.empty()) {
+        props.Byte(static_cast<uint8_t>(Mqtt5Property::CONTENT_TYPE));
+        props.String(mqttMsg->payloadContentType);
+    }
+    if (!mqttMsg->responseTopic.empty()) {
+        props.Byte(static_cast<uint8_t>(Mqtt5Property::RESPONSE_TOPIC));
+        props.String(mqttMsg->responseTopic);
+    }
+    if (!mqttMsg->correlationDataProps.empty()) {
+        props.Byte(static_cast<uint8_t>(Mqtt5Property::CORRELATION_DATA));
+        props.Binary(mqttMsg->correlationDataProps.data(), mqttMsg->correlationDataProps.size());
+    }
+    for (auto const& prop : mqttMsg->userProps) {
+        props.Byte(static_cast<uint8_t>(Mqtt5Property::USER_PROPERTY));
+        props.String(prop.first);
+        props.String(prop.second);
+    }
+
+    auto        qos{static_cast<uint8_t>(mqttMsg->qos)};
+    Mqtt5Writer writer;
+    writer.String(mqttMsg->topic);
+    auto idPos{Mqtt5Writer::maxFixedHeaderSize + writer.Size()};
+    if (qos) {
+        writer.TwoByte(0U);
+    }
+    writer.Properties(props);
+    auto packet{make_shared<OutPacket>()};
+    packet->header = writer.Finish(
+        static_cast<uint8_t>((static_cast<uint8_t>(Mqtt5PacketType::PUBLISH) << 4U) | (qos << 1U) |
+                             (mqttMsg->retain ? 0x01U : 0x00U)),
+        mqttMsg->payload.size(),
+        packet->offset);
+    packet->message = move(mqttMsg);
+    if (!writer.Valid() || packet->message->topic.empty() || qos > 2U) {
+        logCb->Log<LogLevel::ERROR>([] { return "Invalid MQTT message - ignoring message"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+
+    unique_lock<mutex> lock(ioMutex);
+    if (maxPacketSize && packetSize(*packet) > maxPacketSize) {
+        logCb->Log<LogLevel::ERROR>([] {
+            return "MQTT message exceeds the maximum packet size of the broker - ignoring message";
+        });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    /*the broker disconnects, if it gets a QoS or a retained message it refused in the CONNACK*/
+    if (qos > maxQos || (packet->message->retain && !retainAvailable)) {
+        logCb->Log<LogLevel::ERROR>([] {
+            return "MQTT message uses a QoS or retain not available at the broker - ignoring message";
+        });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    /*QoS 0 is only sent while connected, other messages are kept until the connection is up*/
+    if (State::CONNECTED != state && (!qos || !connectRequested)) {
+        logCb->Log<LogLevel::WARNING>([] { return "Native client is not connected"; });
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    auto id{qos ? static_cast<int>(nextPacketId()) : nextQos0Token()};
+    if (!id) {
+        logCb->Log<LogLevel::ERROR>([] { return "No packet identifier available"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    if (!qos) {
+        packet->token = id;
+        outQueue.push_back(move(packet));
+    }
+    else {
+        setPacketId(*packet, idPos, static_cast<uint16_t>(id));
+        auto& flight  = inFlight[static_cast<uint16_t>(id)];
+        flight.packet = move(packet);
+        if (State::CONNECTED == state) {
+            quotaQueue.push_back(static_cast<uint16_t>(id));
+            sendWithQuota();
+        }
+    }
+    if (token) {
+        *token = id;
+    }
+    transmit(lock);
+    return ReasonCode::OKAY;
+}
+
+bool
+NativeClient::IsConnected(void) const noexcept
+{
+    return connected;
+}
+
+IMqttExternalLoop*
+NativeClient::GetExternalLoop(void) noexcept
+{
+    return params.externalLoop ? this : nullptr;
+}
+
+int
+NativeClient::Socket(void) const noexcept
+{
+    lock_guard<mutex> lock(ioMutex);
+    return sock;
+}
+
+ReasonCode
+NativeClient::Read(void)
+{
+    int fd{-1};
+    {
+        unique_lock<mutex> lock(ioMutex);
+        if (sock < 0) {
+            return ReasonCode::ERROR_NO_CONNECTION;
+        }
+        if (State::CONNECTING == state) {
+            /*a failed connect is reported as readable*/
+            if (finishConnect()) {
+                transmit(lock);
+                return ReasonCode::OKAY;
+            }
+            lock.unlock();
+            closeConnection(Mqtt5ReasonCode::UNSPECIFIED_ERROR);
+            return ReasonCode::ERROR_NO_CONNECTION;
+        }
+        fd = sock;
+    }
+    for (unsigned i{0U}; i < maxReceivesPerRead; i++) {
+        auto received{receiveBuffer.Receive(fd)};
+        if (received < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                return ReasonCode::OKAY;
+            }
+            logCb->Log<LogLevel::ERROR>([&] { return "Was not able to read from broker: " + errnoToString(); });
+            closeConnection(Mqtt5ReasonCode::UNSPECIFIED_ERROR);
+            return ReasonCode::ERROR_NO_CONNECTION;
+        }
+        if (0 == received) {
+            closeConnection(Mqtt5ReasonCode::UNSPECIFIED_ERROR);
+            return ReasonCode::ERROR_NO_CONNECTION;
+        }
+        auto status{processPackets()};
+        if (ReasonCode::OKAY != status) {
+            return status;
+        }
+        if (0 > Socket()) {
+            return ReasonCode::ERROR_NO_CONNECTION;
+        }
+    }
+    return ReasonCode::OKAY;
+}
+
+ReasonCode
+NativeClient::Write(void)
+{
+    unique_lock<mutex> lock(ioMutex);
+    if (sock < 0) {
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    if (State::CONNECTING == state && !finishConnect()) {
+        lock.unlock();
+        closeConnection(Mqtt5ReasonCode::UNSPECIFIED_ERROR);
+        return ReasonCode::ERROR_NO_CONNECTION;
+    }
+    transmit(lock);
+    /*a failed write and the end of a disconnect are handled by Misc*/
+    return Misc();
+}
+
+ReasonCode
+NativeClient::Misc(void)
+{
+    unique_lock<mutex> lock(ioMutex);
+    auto               now{clock_t::now()};
+    auto               closeRc{Mqtt5ReasonCode::UNSPECIFIED_ERROR};
+    if (sock < 0) {
+        return ReasonCode::OKAY;
+    }
+    else if (writeFailed) {
+        logCb->Log<LogLevel::ERROR>([] { return "Native client failed to write to broker"; });
+    }
+    else if (State::DISCONNECTING == state) {
+        /*the connection is closed, once the DISCONNECT packet is written*/
+        if (!outQueue.empty()) {
+            return ReasonCode::OKAY;
+        }
+        closeRc = disconnectRc;
+    }
+    else if (State::CONNECTED != state) {
+        if (now - connectStarted < max(keepAlive, seconds(10))) {
+            return ReasonCode::OKAY;
+        }
+        logCb->Log<LogLevel::ERROR>([] { return "Broker did not accept the connection in time"; });
+    }
+    else if (keepAlive.count() == 0 || now - (pingOutstanding ? pingSent : lastSent) < keepAlive) {
+        return ReasonCode::OKAY;
+    }
+    else if (!pingOutstanding) {
+        pingOutstanding = true;
+        pingSent        = now;
+        Mqtt5Writer writer;
+        outQueue.push_back(finish(writer, static_cast<uint8_t>(Mqtt5PacketType::PINGREQ) << 4U));
+        transmit(lock);
+        return ReasonCode::OKAY;
+    }
+    else {
+        logCb->Log<LogLevel::ERROR>([] { return "Broker did not answer ping in time"; });
+        closeRc = Mqtt5ReasonCode::KEEP_ALIVE_TIMEOUT;
+    }
+    lock.unlock();
+    closeConnection(closeRc);
+    return ReasonCode::OKAY;
+}
+
+bool
+NativeClient::WantWrite(void) const noexcept
+{
+    lock_guard<mutex> lock(ioMutex);
+    return sock >= 0 && (State::CONNECTING == state || writeFailed || !outQueue.empty());
+}
+
+bool
+NativeClient::WantReconnect(void) const noexcept
+{
+    lock_guard<mutex> lock(ioMutex);
+    return connectRequested && sock < 0;
+}
+
+ReasonCode
+NativeClient::Reconnect(void)
+{
+    logCb->Log<LogLevel::INFO>([&] {
+        return "Reconnecting to broker async: " + params.hostAddress + ":" + to_string(params.port);
+    });
+    shared_ptr<addrinfo> addresses;
+    {
+        lock_guard<mutex> lock(ioMutex);
+        addresses = brokerAddresses;
+    }
+    if (!addresses) {
+        /*not resolved by ConnectAsync, tried again outside of the lock*/
+        addresses = resolve();
+    }
+    auto status{ReasonCode::OKAY};
+    {
+        lock_guard<mutex> lock(ioMutex);
+        if (!brokerAddresses) {
+            brokerAddresses = move(addresses);
+        }
+        if (sock < 0) {
+            status = open();
+            if (ReasonCode::OKAY != status && !params.externalLoop) {
+                reconnectAt = clock_t::now() + reconnectDelay();
+            }
+        }
+    }
+    wakeUpLoop();
+    return status;
+}
+
+void
+NativeClient::SetWakeUp(wakeUp_t func)
+{
+    lock_guard<mutex> lock(wakeUpMutex);
+    wakeUp = move(func);
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,180 @@
+/**
+ * @file NativeClient.h
+ * @author Timo Lange
+ * @brief Class definition for the MQTTv5 client without an underlying MQTT library
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "IMqttExternalLoop.h"
+#include "Mqtt5Codec.h"
+#include "MqttClientBase.h"
+#include "RingBuffer.h"
+
+struct addrinfo;
+
+namespace i_mqtt_client {
+/*Implements MQTTv5 directly on a non-blocking socket. Each packet is encoded into a single buffer, the payload of
+ * publishes is written from the message itself via vectored I/O, and received packets are decoded where they were
+ * received in a ring buffer. The socket is either driven by a network thread of the client, or by an external loop.*/
+class NativeClient
+  : public MqttClientBase
+  , private IMqttExternalLoop {
+private:
+    using clock_t = std::chrono::steady_clock;
+
+    enum class State { DISCONNECTED, CONNECTING, AWAITING_CONNACK, CONNECTED, DISCONNECTING };
+
+    /*an encoded packet waiting to be written, it starts at offset of header*/
+    struct OutPacket final {
+        std::vector<std::uint8_t>           header;
+        size_t                              offset{0U};
+        std::shared_ptr<IMqttMessage const> message{nullptr}; /*only publishes, the payload is written from here*/
+        int                                 token{-1};        /*only QoS 0 publishes, completed once written*/
+    };
+    using spOutPacket_t = std::shared_ptr<OutPacket>;
+
+    /*publish with QoS 1 or 2, kept until the broker completed it*/
+    struct InFlight final {
+        spOutPacket_t packet{nullptr};
+        bool          sent{false};     /*has to be resent as duplicate after a reconnect*/
+        bool          released{false}; /*PUBREC received, PUBREL is due*/
+    };
+
+    /*SUBSCRIBE or UNSUBSCRIBE waiting for its acknowledgement*/
+    struct PendingAck final {
+        bool   subscribe{true};
+        size_t filters{0U};
+    };
+
+    static constexpr size_t   receiveBufferSize{64U * 1024U};
+    static constexpr unsigned maxReceivesPerRead{16U};
+
+    std::atomic_bool connected{false};
+    std::atomic_bool connectRequested{false};
+    std::atomic_bool loopExit{false};
+    int              reconnectDelayMin; /*seconds, including the random part*/
+
+    /*protects everything below, except the receive buffer, which is only used by the loop*/
+    mutable std::mutex                             ioMutex;
+    State                                          state{State::DISCONNECTED};
+    int                                            sock{-1};
+    bool                                           writeFailed{false};
+    std::deque<spOutPacket_t>                      outQueue;
+    size_t                                         written{0U}; /*bytes of the front packet written already*/
+    std::map<std::uint16_t, InFlight>              inFlight;
+    std::deque<std::uint16_t>                      quotaQueue; /*in flight publishes waiting for sendQuota*/
+    std::unordered_map<std::uint16_t, PendingAck>  pendingAcks;
+    std::unordered_set<std::uint16_t>              receivedQos2;
+    std::uint16_t                                  lastPacketId{0U};
+    int                                            lastQos0Token{0xFFFF}; /*above the packet identifiers*/
+    std::shared_ptr<addrinfo>                      brokerAddresses; /*resolved by ConnectAsync, reused to reconnect*/
+    unsigned                                       sendQuota{0U};    /*receive maximum of the broker*/
+    std::uint32_t                                  maxPacketSize{0U}; /*of the broker, 0 means no limit*/
+    std::uint8_t                                   maxQos{2U};        /*of the broker*/
+    bool                                           retainAvailable{true};
+    std::chrono::seconds                           keepAlive;
+    bool                                           pingOutstanding{false};
+    bool                                           recovering{false};
+    unsigned                                       reconnectAttempts{0U};
+    Mqtt5ReasonCode                                disconnectRc{Mqtt5ReasonCode::SUCCESS};
+    clock_t::time_point                            lastSent;
+    clock_t::time_point                            pingSent;
+    clock_t::time_point                            connectStarted;
+    clock_t::time_point                            reconnectAt;
+
+    RingBuffer receiveBuffer{receiveBufferSize};
+
+    mutable std::mutex wakeUpMutex;
+    wakeUp_t           wakeUp;
+    int                wakeUpPipe[2]{-1, -1};
+    std::thread        loopThread;
+
+    static spOutPacket_t finish(Mqtt5Writer&, std::uint8_t typeAndFlags);
+    static void          setPacketId(OutPacket&, size_t pos, std::uint16_t);
+    static spOutPacket_t ackPacket(Mqtt5PacketType, std::uint16_t, Mqtt5ReasonCode);
+    static size_t        packetSize(OutPacket const&) noexcept;
+    spOutPacket_t        connectPacket(void) const;
+    /*blocks, so it is never called with ioMutex locked*/
+    std::shared_ptr<addrinfo> resolve(void) const;
+
+    /*the methods below expect ioMutex to be locked*/
+    ReasonCode                open(void);
+    bool                      finishConnect(void);
+    bool                      flush(std::vector<int>& completed);
+    std::uint16_t             nextPacketId(void) noexcept;
+    int                       nextQos0Token(void) noexcept;
+    void                      sendWithQuota(void);
+    std::chrono::milliseconds reconnectDelay(void);
+    std::chrono::milliseconds nextTimeout(void) const;
+    /*writes what is queued, unlocks ioMutex and reports written QoS 0 publishes*/
+    void transmit(std::unique_lock<std::mutex>&);
+
+    /*the methods below are only used by the loop driving the client*/
+    void            loop(void);
+    void            closeConnection(Mqtt5ReasonCode);
+    ReasonCode      processPackets(void);
+    Mqtt5ReasonCode handlePacket(std::uint8_t, Mqtt5Reader&);
+    Mqtt5ReasonCode handleConnAck(Mqtt5Reader&);
+    Mqtt5ReasonCode handlePublish(std::uint8_t, Mqtt5Reader&);
+    Mqtt5ReasonCode handlePublishAck(Mqtt5PacketType, Mqtt5Reader&);
+    Mqtt5ReasonCode handlePubRel(Mqtt5Reader&);
+    Mqtt5ReasonCode handleSubscribeAck(Mqtt5PacketType, Mqtt5Reader&);
+    Mqtt5ReasonCode handleDisconnect(Mqtt5Reader&);
+
+    ReasonCode sendTracked(Mqtt5Writer&, size_t idPos, std::uint8_t typeAndFlags, PendingAck, int*);
+    void       wakeUpLoop(void) const;
+    bool       usesScheduler(void) const noexcept;
+
+    ReasonCode ConnectAsync(void) override;
+    ReasonCode DisconnectAsync(Mqtt5ReasonCode) override;
+    ReasonCode subscribe(std::vector<TopicSubscription> const&, std::uint32_t, int*) override;
+    ReasonCode unSubscribe(std::vector<std::string> const&, int*) override;
+    ReasonCode publish(upMqttMessage_t, int*) override;
+    bool       IsConnected(void) const noexcept override;
+
+    IMqttExternalLoop* GetExternalLoop(void) noexcept override;
+    int                Socket(void) const noexcept override;
+    ReasonCode         Read(void) override;
+    ReasonCode         Write(void) override;
+    ReasonCode         Misc(void) override;
+    bool               WantWrite(void) const noexcept override;
+    bool               WantReconnect(void) const noexcept override;
+    ReasonCode         Reconnect(void) override;
+    void               SetWakeUp(wakeUp_t) override;
+
+public:
+    NativeClient(IMqttClient::InitializeParameters const&,
+                 IMqttMessageCallbacks const*,
+                 IMqttLogCallbacks const*,
+                 IMqttCommandCallbacks const*,
+                 IMqttConnectionCallbacks const*);
+    virtual ~NativeClient() noexcept;
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,99 @@
+/**
+ * @file RingBuffer.cpp
+ * @author Timo Lange
+ * @brief Implementation of the receive buffer of the native client
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "RingBuffer.h"
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace i_mqtt_client {
+static size_t
+roundUpToPowerOfTwo(size_t value) noexcept
+{
+    size_t result{1U};
+    while (result < value) {
+        result <<= 1U;
+    }
+    return result;
+}
+
+RingBuffer::RingBuffer(size_t capacity)
+  : buf(roundUpToPowerOfTwo(capacity))
+  , mask(buf.size() - 1U)
+{
+}
+
+void
+RingBuffer::CopyOut(size_t offset, size_t len, uint8_t* dst) const noexcept
+{
+    auto start{(head + offset) & mask};
+    auto first{min(len, buf.size() - start)};
+    memcpy(dst, buf.data() + start, first);
+    memcpy(dst + first, buf.data(), len - first);
+}
+
+void
+RingBuffer::Consume(size_t len) noexcept
+{
+    head += min(len, Size());
+}
+
+void
+RingBuffer::Clear(void) noexcept
+{
+    head = tail = 0U;
+}
+
+void
+RingBuffer::Reserve(size_t len)
+{
+    if (len <= buf.size()) {
+        return;
+    }
+    vector<uint8_t> grown(roundUpToPowerOfTwo(len));
+    auto            size{Size()};
+    CopyOut(0U, size, grown.data());
+    buf.swap(grown);
+    mask = buf.size() - 1U;
+    head = 0U;
+    tail = size;
+}
+
+ssize_t
+RingBuffer::Receive(int fd) noexcept
+{
+    auto free{buf.size() - Size()};
+    if (0U == free) {
+        return 0;
+    }
+    auto  start{tail & mask};
+    auto  first{min(free, buf.size() - start)};
+    iovec segments[2]{{buf.data() + start, first}, {buf.data(), free - first}};
+    auto  received{readv(fd, segments, free > first ? 2 : 1)};
+    if (received > 0) {
+        tail += static_cast<size_t>(received);
+    }
+    return received;
+}
+}  // namespace i_mqtt_client
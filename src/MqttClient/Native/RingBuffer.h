@@ -0,0 +1,64 @@
+/**
+ * @file RingBuffer.h
+ * @author Timo Lange
+ * @brief Class definition for the receive buffer of the native client
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace i_mqtt_client {
+/*Receive buffer of a connection. Bytes are received directly into the free space, with up to two segments per readv,
+ * and packets are parsed where they were received, also across the wrap around. The capacity is a power of two, read
+ * and write positions only increase and are masked on access.*/
+class RingBuffer final {
+private:
+    std::vector<std::uint8_t> buf;
+    size_t                    mask;
+    size_t                    head{0U};
+    size_t                    tail{0U};
+
+public:
+    explicit RingBuffer(size_t capacity);
+
+    size_t Size(void) const noexcept
+    {
+        return tail - head;
+    }
+    size_t Capacity(void) const noexcept
+    {
+        return buf.size();
+    }
+    std::uint8_t operator[](size_t offset) const noexcept
+    {
+        return buf[(head + offset) & mask];
+    }
+
+    /*copies bytes starting at offset from the read position*/
+    void CopyOut(size_t offset, size_t len, std::uint8_t* dst) const noexcept;
+    void Consume(size_t len) noexcept;
+    void Clear(void) noexcept;
+    /*grows the buffer, such that at least len bytes fit, keeping its content*/
+    void Reserve(size_t len);
+    /*receives as many bytes as fit from a non-blocking socket, returns the result of readv*/
+    ssize_t Receive(int fd) noexcept;
+};
+}  // namespace i_mqtt_client
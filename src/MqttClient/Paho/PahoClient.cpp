@@ -20,7 +20,7 @@
 
 #include "PahoClient.h"
 
-#include <future>
+#include "IReconnectScheduler.h"
 
 using namespace std;
 
@@ -32,12 +32,11 @@ PahoClient::PahoClient(InitializeParameters const&     parameters,
                        IMqttLogCallbacks const*        log,
                        IMqttCommandCallbacks const*    cmd,
                        IMqttConnectionCallbacks const* con)
-  : IMqttClient(log, cmd, msg, con)
-  , params(parameters)
+  : MqttClientBase(parameters, msg, log, cmd, con)
 {
     // Init lib, if nobody ever did
     call_once(initFlag, [this] {
-        logCb->Log(LogLevel::INFO, "Initializing paho lib");
+        logCb->Log<LogLevel::INFO>([] { return "Initializing paho lib"; });
         MQTTAsync_init_options initOptions MQTTAsync_init_options_initializer;
         /*For now let paho init openssl*/
         initOptions.do_openssl_init = 1;
@@ -95,12 +94,12 @@ PahoClient::PahoClient(InitializeParameters const&     parameters,
                 break;
             }
         }
-        IMqttClient::libVersion = "libpaho " + string(MQTTAsync_getVersionInfo()[1].value);
     });
+    libVersion = "libpaho " + string(MQTTAsync_getVersionInfo()[1].value);
 
-    logCb->Log(LogLevel::INFO, "Initializing paho instance");
+    logCb->Log<LogLevel::INFO>([] { return "Initializing paho instance"; });
     auto brokerAddress{params.hostAddress + ":" + to_string(params.port)};
-    logCb->Log(LogLevel::INFO, "Broker-Address: " + brokerAddress);
+    logCb->Log<LogLevel::INFO>([&] { return "Broker-Address: " + brokerAddress; });
 
     if (params.reconnectDelayMinLower < 0 || params.reconnectDelayMinUpper < 0 ||
         params.reconnectDelayMinLower > params.reconnectDelayMinUpper) {
@@ -119,9 +118,12 @@ PahoClient::PahoClient(InitializeParameters const&     parameters,
         pClient,
         this,
         [](void* pThis, char*) {
-            static_cast<PahoClient*>(pThis)->logCb->Log(LogLevel::WARNING, "Paho disconnected from broker");
-            static_cast<PahoClient*>(pThis)->conCb->OnConnectionStatusChanged(ConnectionType::DISCONNECT,
-                                                                              Mqtt5ReasonCode::SUCCESS);
+            auto pClient{static_cast<PahoClient*>(pThis)};
+            pClient->logCb->Log<LogLevel::WARNING>([] { return "Paho disconnected from broker"; });
+            pClient->notifyDisconnected(Mqtt5ReasonCode::SUCCESS);
+            if (pClient->params.reconnectScheduler && pClient->params.paho.autoReconnect) {
+                pClient->scheduleReconnect();
+            }
         },
         [](void* pThis, char* topicName, int topicLen, MQTTAsync_message* message) {
             return static_cast<PahoClient*>(pThis)->onMessageCb(topicName, topicLen, message);
@@ -131,27 +133,45 @@ PahoClient::PahoClient(InitializeParameters const&     parameters,
         throw runtime_error("Was not able to set paho callbacks: " + string(MQTTAsync_strerror(rc)));
     }
     rc = MQTTAsync_setDisconnected(pClient, this, [](void* pThis, MQTTProperties*, MQTTReasonCodes reason) {
-        static_cast<PahoClient*>(pThis)->logCb->Log(
-            LogLevel::WARNING, "Paho disconnected from broker, rc: " + Mqtt5ReasonCodeToStringRepr(reason).first);
-        static_cast<PahoClient*>(pThis)->conCb->OnConnectionStatusChanged(ConnectionType::DISCONNECT,
-                                                                          static_cast<Mqtt5ReasonCode>(reason));
+        static_cast<PahoClient*>(pThis)->logCb->Log<LogLevel::WARNING>([&] {
+            return "Paho disconnected from broker, rc: " + Mqtt5ReasonCodeToStringRepr(reason).first;
+        });
+        static_cast<PahoClient*>(pThis)->notifyDisconnected(static_cast<Mqtt5ReasonCode>(reason));
     });
     if (MQTTASYNC_SUCCESS != rc) {
         throw runtime_error("Was not able to set paho disconnected callback: " + string(MQTTAsync_strerror(rc)));
     }
     rc = MQTTAsync_setConnected(pClient, this, [](void* pThis, char*) {
-        static_cast<PahoClient*>(pThis)->logCb->Log(LogLevel::INFO, "Paho connected to broker");
-        static_cast<PahoClient*>(pThis)->conCb->OnConnectionStatusChanged(ConnectionType::CONNECT,
-                                                                          Mqtt5ReasonCode::SUCCESS);
+        auto pClient{static_cast<PahoClient*>(pThis)};
+        pClient->logCb->Log<LogLevel::INFO>([] { return "Paho connected to broker"; });
+        if (pClient->recovering.exchange(false)) {
+            pClient->params.reconnectScheduler->Connected(pClient);
+        }
+        pClient->notifyConnected(Mqtt5ReasonCode::SUCCESS, pClient->sessionPresent);
     });
     if (MQTTASYNC_SUCCESS != rc) {
         throw runtime_error("Was not able to set paho connected callback: " + string(MQTTAsync_strerror(rc)));
     }
+#ifdef IMQTT_WITH_TLS
+    if (params.tlsContext) {
+        logCb->Log<LogLevel::WARNING>([] {
+            return "Paho does not support a shared TLS context, using the TLS file paths";
+        });
+    }
+#endif
 }
 
 PahoClient::~PahoClient() noexcept
 {
-    logCb->Log(LogLevel::INFO, "Deinitializing paho instance");
+    stopPublishing();
+    if (params.reconnectScheduler) {
+        {
+            lock_guard<mutex> lock(reconnectMutex);
+            stopping = true;
+        }
+        params.reconnectScheduler->Forget(this);
+    }
+    logCb->Log<LogLevel::INFO>([] { return "Deinitializing paho instance"; });
     if (IsConnected()) {
         DisconnectAsync(Mqtt5ReasonCode::SUCCESS);
     }
@@ -159,34 +179,33 @@ PahoClient::~PahoClient() noexcept
 }
 
 void
-PahoClient::printDetailsOnSuccess(string const& details, MQTTAsync_successData5 const* data) const
+PahoClient::printDetailsOnSuccess(char const* details, MQTTAsync_successData5 const* data) const
 {
-    logCb->Log(LogLevel::DEBUG,
-               details + ": okay for token: " + to_string(data->token) +
-                   ", MQTT5 rc: " + string(MQTTReasonCode_toString(data->reasonCode)));
+    logCb->Log<LogLevel::DEBUG>([&] {
+        return string(details) + ": okay for token: " + to_string(data->token) +
+               ", MQTT5 rc: " + string(MQTTReasonCode_toString(data->reasonCode));
+    });
 }
 
 void
-PahoClient::printDetailsOnFailure(string const& details, MQTTAsync_failureData5 const* data) const
+PahoClient::printDetailsOnFailure(char const* details, MQTTAsync_failureData5 const* data) const
 {
-    logCb->Log(LogLevel::ERROR,
-               details + ": failed for token: " + to_string(data->token) +
-                   ", MQTT5 rc: " + string(MQTTReasonCode_toString(data->reasonCode)) +
-                   ", Paho rc: " + string(MQTTAsync_strerror(data->code)));
+    logCb->Log<LogLevel::ERROR>([&] {
+        return string(details) + ": failed for token: " + to_string(data->token) + ", MQTT5 rc: " +
+               string(MQTTReasonCode_toString(data->reasonCode)) + ", Paho rc: " +
+               string(MQTTAsync_strerror(data->code));
+    });
     if (data->message) {
-        logCb->Log(
-            LogLevel::ERROR,
-            details + ": failed for token: " + to_string(data->token) + ", Paho description: " + string(data->message));
+        logCb->Log<LogLevel::ERROR>([&] {
+            return string(details) + ": failed for token: " + to_string(data->token) + ", Paho description: " +
+                   string(data->message);
+        });
     }
 }
 
-int
-PahoClient::onMessageCb(char* pTopic, int topicLen, MQTTAsync_message* msg) const
+upMqttMessage_t
+PahoToMqttMessage(char const* pTopic, int topicLen, MQTTAsync_message const* msg, IMqttLogCallbacks const* logCb)
 {
-    logCb->Log(LogLevel::TRACE, "Paho received message");
-
-    bool acceptMsg{true};
-
     auto internalMessage{MqttMessageFactory::Create(
         string(pTopic, topicLen),
         IMqttMessage::payload_t(static_cast<IMqttMessage::payloadRaw_t*>(msg->payload),
@@ -203,7 +222,7 @@ PahoClient::onMessageCb(char* pTopic, int topicLen, MQTTAsync_message* msg) cons
             auto value{
                 string(msg->properties.array[prop].value.value.data, msg->properties.array[prop].value.value.len)};
             if (!internalMessage->userProps.insert(make_pair(key, value)).second) {
-                logCb->Log(LogLevel::ERROR, "Received invalid user properties - ignoring");
+                logCb->Log<LogLevel::ERROR>([] { return "Received invalid user properties - ignoring"; });
             }
         } break;
         case MQTTPROPERTY_CODE_CORRELATION_DATA: {
@@ -219,6 +238,9 @@ PahoClient::onMessageCb(char* pTopic, int topicLen, MQTTAsync_message* msg) cons
             if (msg->properties.array[prop].value.byte == 1)
                 internalMessage->payloadFormatIndicator = IMqttMessage::FormatIndicator::UTF8;
         } break;
+        case MQTTPROPERTY_CODE_SUBSCRIPTION_IDENTIFIER: {
+            internalMessage->subscriptionIds.push_back(msg->properties.array[prop].value.integer4);
+        } break;
         case MQTTPROPERTY_CODE_CONTENT_TYPE: {
             internalMessage->payloadContentType =
                 string(msg->properties.array[prop].value.data.data, msg->properties.array[prop].value.data.len);
@@ -228,7 +250,17 @@ PahoClient::onMessageCb(char* pTopic, int topicLen, MQTTAsync_message* msg) cons
         }
     }
 
-    msgCb->OnMqttMessage(move(internalMessage));
+    return internalMessage;
+}
+
+int
+PahoClient::onMessageCb(char* pTopic, int topicLen, MQTTAsync_message* msg) const
+{
+    logCb->Log<LogLevel::TRACE>([] { return "Paho received message"; });
+
+    bool acceptMsg{true};
+
+    notifyMessage(PahoToMqttMessage(pTopic, topicLen, msg, logCb));
 
     if (acceptMsg) {
         MQTTAsync_freeMessage(&msg);
@@ -241,51 +273,50 @@ PahoClient::onMessageCb(char* pTopic, int topicLen, MQTTAsync_message* msg) cons
 ReasonCode
 PahoClient::ConnectAsync(void)
 {
-    logCb->Log(LogLevel::INFO, "Start connecting to broker");
+    logCb->Log<LogLevel::INFO>([] { return "Start connecting to broker"; });
     MQTTAsync_connectOptions connectOptions MQTTAsync_connectOptions_initializer5;
     connectOptions.keepAliveInterval  = params.keepAliveInterval;
-    connectOptions.automaticReconnect = params.autoReconnect ? 1 : 0;
+    /*with a reconnect scheduler, paho is told to reconnect by the scheduler*/
+    connectOptions.automaticReconnect = params.paho.autoReconnect && !params.reconnectScheduler ? 1 : 0;
     connectOptions.cleanstart         = params.cleanSession ? 1 : 0;
     connectOptions.maxRetryInterval   = params.reconnectDelayMax;
     connectOptions.minRetryInterval =
         params.reconnectDelayMin +
         uniform_int_distribution<int>(params.reconnectDelayMinLower, params.reconnectDelayMinUpper)(rndGenerator);
-    logCb->Log(LogLevel::DEBUG,
-               "Reconnect delay min: " + to_string(connectOptions.minRetryInterval) + "," +
-                   " max: " + to_string(connectOptions.maxRetryInterval));
-
-    static auto ctx{Context(this, nullptr)};
-    auto        rcPromise{promise<int>()};
-    ctx.pContext              = &rcPromise;
-    connectOptions.context    = &ctx;
-    connectOptions.onSuccess5 = [](void* pCtx, MQTTAsync_successData5* data) {
-        static_cast<Context*>(pCtx)->pThis->printDetailsOnSuccess("MQTTAsync_connect", data);
-        try {
-            static_cast<promise<int>*>(static_cast<Context*>(pCtx)->pContext)->set_value(MQTTASYNC_SUCCESS);
-        }
-        catch (future_error const&) {
-            /*Nothing to be done here*/
-        }
+    logCb->Log<LogLevel::DEBUG>([&] {
+        return "Reconnect delay min: " + to_string(connectOptions.minRetryInterval) + "," +
+               " max: " + to_string(connectOptions.maxRetryInterval);
+    });
+
+    /*the result is reported via notifyConnected, paho calls the connected callback on success*/
+    connectOptions.context    = this;
+    connectOptions.onSuccess5 = [](void* pThis, MQTTAsync_successData5* data) {
+        auto pClient{static_cast<PahoClient*>(pThis)};
+        pClient->printDetailsOnSuccess("MQTTAsync_connect", data);
+        /*paho calls this before the connected callback, also on automatic reconnects*/
+        pClient->sessionPresent = data->alt.connect.sessionPresent != 0;
     };
-    connectOptions.onFailure5 = [](void* pCtx, MQTTAsync_failureData5* data) {
-        /*This callback sometimes (e.g. with invalid broker url) is called multiple times, so we have to catch here*/
-        static_cast<Context*>(pCtx)->pThis->printDetailsOnFailure("MQTTAsync_connect", data);
-        try {
-            static_cast<promise<int>*>(static_cast<Context*>(pCtx)->pContext)->set_value(data->code);
-        }
-        catch (future_error const&) {
-            /*Nothing to be done here*/
+    connectOptions.onFailure5 = [](void* pThis, MQTTAsync_failureData5* data) {
+        /*This callback sometimes (e.g. with invalid broker url) is called multiple times*/
+        auto pClient{static_cast<PahoClient*>(pThis)};
+        pClient->printDetailsOnFailure("MQTTAsync_connect", data);
+        pClient->notifyConnected(
+            data->reasonCode ? static_cast<Mqtt5ReasonCode>(data->reasonCode) : Mqtt5ReasonCode::UNSPECIFIED_ERROR,
+            false);
+        /*only retried, if the connection got lost before, the initial connect is up to the user*/
+        if (pClient->recovering) {
+            pClient->scheduleReconnect();
         }
     };
     if (!params.mqttUsername.empty()) {
         connectOptions.username = params.mqttUsername.c_str();
         connectOptions.password = params.mqttPassword.c_str();
     }
-    if (!params.httpProxy.empty()) {
-        connectOptions.httpProxy = params.httpProxy.c_str();
+    if (!params.paho.httpProxy.empty()) {
+        connectOptions.httpProxy = params.paho.httpProxy.c_str();
     }
-    if (!params.httpsProxy.empty()) {
-        connectOptions.httpsProxy = params.httpsProxy.c_str();
+    if (!params.paho.httpsProxy.empty()) {
+        connectOptions.httpsProxy = params.paho.httpsProxy.c_str();
     }
 #ifdef IMQTT_WITH_TLS
     MQTTAsync_SSLOptions sslOptions MQTTAsync_SSLOptions_initializer;
@@ -294,7 +325,7 @@ PahoClient::ConnectAsync(void)
     connectOptions.ssl->CApath     = params.caDirPath.empty() ? nullptr : params.caDirPath.c_str();
     connectOptions.ssl->keyStore   = params.clientCertFilePath.empty() ? nullptr : params.clientCertFilePath.c_str();
     connectOptions.ssl->privateKey = params.privateKeyFilePath.empty() ? nullptr : params.privateKeyFilePath.c_str();
-    connectOptions.ssl->disableDefaultTrustStore = params.disableDefaultCaStore ? 1 : 0;
+    connectOptions.ssl->disableDefaultTrustStore = params.paho.disableDefaultCaStore ? 1 : 0;
 #ifdef IMQTT_EXPERIMENTAL
     connectOptions.ssl->clientCertString = params.clientCert.empty() ? nullptr : params.clientCert.c_str();
     connectOptions.ssl->privateKeyString = params.privateKey.empty() ? nullptr : params.privateKey.c_str();
@@ -305,24 +336,22 @@ PahoClient::ConnectAsync(void)
     connectOptions.ssl->enableServerCertAuth = 1;
     connectOptions.ssl->ssl_error_context    = this;
     connectOptions.ssl->ssl_error_cb         = [](const char* str, size_t len, void* pThis) -> int {
-        static_cast<PahoClient*>(pThis)->logCb->Log(LogLevel::ERROR, string(str, len));
+        static_cast<PahoClient*>(pThis)->logCb->Log<LogLevel::ERROR>([&] { return string(str, len); });
         return 0;
     };
 #endif
-    auto reason{MqttReasonCode::ACCEPTED};
-    if ((reason = static_cast<MqttReasonCode>(MQTTAsync_connect(pClient, &connectOptions))) >
-        MqttReasonCode::ACCEPTED) {
-        logCb->Log(LogLevel::ERROR,
-                   "MQTTAsync_connect returned MQTT error: " + MqttReasonCodeToStringRepr(reason).first);
-    }
-    /*use rc from the callbacks, wait forever because it is assumed one of the callbacks is always called*/
-    return pahoRcToReasonCode(rcPromise.get_future().get(), "MQTTAsync_connect");
+    /*paho copies the options, so they do not have to outlive this call*/
+    return pahoRcToReasonCode(MQTTAsync_connect(pClient, &connectOptions), "MQTTAsync_connect");
 }
 
 ReasonCode
 PahoClient::DisconnectAsync(Mqtt5ReasonCode rc)
 {
-    logCb->Log(LogLevel::INFO, "Disconnecting from broker");
+    logCb->Log<LogLevel::INFO>([] { return "Disconnecting from broker"; });
+    if (params.reconnectScheduler) {
+        recovering = false;
+        params.reconnectScheduler->Forget(this);
+    }
     MQTTAsync_disconnectOptions disconnectOptions MQTTAsync_disconnectOptions_initializer5;
     disconnectOptions.timeout    = 10 /*ms*/;
     disconnectOptions.reasonCode = static_cast<MQTTReasonCodes>(rc);
@@ -335,30 +364,106 @@ PahoClient::DisconnectAsync(Mqtt5ReasonCode rc)
         static_cast<PahoClient*>(pThis)->printDetailsOnFailure("MQTTAsync_disconnect", data);
     };
     /* TODO: Currently there is a race-condition between the call to DisconnectAsync and IsConnected in the Destructor
-     * maybe wait for callbacks to happen, same as in Connect */
+     * maybe wait for callbacks to happen */
     return pahoRcToReasonCode(MQTTAsync_disconnect(pClient, &disconnectOptions), "MQTTAsync_disconnect");
 }
 
+void
+PahoClient::scheduleReconnect(void)
+{
+    lock_guard<mutex> lock(reconnectMutex);
+    /*an attempt scheduled after the destructor forgot the client would outlive it*/
+    if (stopping) {
+        return;
+    }
+    recovering = true;
+    params.reconnectScheduler->ScheduleAttempt(
+        this, [this] { (void)pahoRcToReasonCode(MQTTAsync_reconnect(pClient), "MQTTAsync_reconnect"); });
+}
+
+vector<Mqtt5ReasonCode>
+PahoClient::takeFilterResults(int token, int rcCount, MQTTReasonCodes const* pRcs, MQTTReasonCodes rc) const
+{
+    size_t filters{1U};
+    {
+        lock_guard<mutex> lock(filterMutex);
+        auto              filterCount{filterCounts.find(token)};
+        if (filterCount != filterCounts.end()) {
+            filters = filterCount->second;
+            filterCounts.erase(filterCount);
+        }
+    }
+    /*Paho provides a list of reason codes only for more than one filter*/
+    if (rcCount > 0 && pRcs) {
+        vector<Mqtt5ReasonCode> rcs;
+        for (int i{0}; i < rcCount; i++) {
+            rcs.push_back(static_cast<Mqtt5ReasonCode>(pRcs[i]));
+        }
+        return rcs;
+    }
+    return vector<Mqtt5ReasonCode>(filters, static_cast<Mqtt5ReasonCode>(rc));
+}
+
 ReasonCode
-PahoClient::SubscribeAsync(string const& topic, IMqttMessage::QOS qos, int* token, bool getRetained)
+PahoClient::subscribe(vector<TopicSubscription> const& subscriptions, uint32_t subscriptionId, int* token)
 {
-    logCb->Log(LogLevel::TRACE, "Subscribing to topic: \"" + topic + "\"");
+    vector<char*>                 topics;
+    vector<int>                   qos;
+    vector<MQTTSubscribe_options> options;
+    for (auto const& subscription : subscriptions) {
+        logCb->Log<LogLevel::TRACE>([&] { return "Subscribing to topic: \"" + subscription.topic + "\""; });
+        topics.push_back(const_cast<char*>(subscription.topic.c_str()));
+        qos.push_back(static_cast<int>(subscription.qos));
+        MQTTSubscribe_options subscribeOptions MQTTSubscribe_options_initializer;
+        subscribeOptions.noLocal        = params.allowLocalTopics ? 0 : 1;
+        subscribeOptions.retainHandling = subscription.getRetained ? 0 : 2;
+        options.push_back(subscribeOptions);
+    }
+
     MQTTAsync_callOptions callOptions MQTTAsync_callOptions_initializer;
     callOptions.context    = this;
     callOptions.onSuccess5 = [](void* pThis, MQTTAsync_successData5* data) {
-        static_cast<PahoClient*>(pThis)->printDetailsOnSuccess("MQTTAsync_subscribe", data);
-        static_cast<PahoClient*>(pThis)->cmdCb->OnSubscribe(data->token);
+        auto pClient{static_cast<PahoClient*>(pThis)};
+        pClient->printDetailsOnSuccess("MQTTAsync_subscribeMany", data);
+        pClient->notifySubscribe(data->token,
+                                 pClient->takeFilterResults(data->token,
+                                                            data->alt.sub.reasonCodeCount,
+                                                            data->alt.sub.reasonCodes,
+                                                            data->reasonCode));
     };
     callOptions.onFailure5 = [](void* pThis, MQTTAsync_failureData5* data) {
-        static_cast<PahoClient*>(pThis)->printDetailsOnFailure("MQTTAsync_subscribe", data);
-        // TODO: call the user callback with Mqtt5ReasonCode
+        auto pClient{static_cast<PahoClient*>(pThis)};
+        pClient->printDetailsOnFailure("MQTTAsync_subscribeMany", data);
+        pClient->notifySubscribeFailure(
+            data->token,
+            pClient->takeFilterResults(
+                data->token, 0, nullptr, data->reasonCode ? data->reasonCode : MQTTREASONCODE_UNSPECIFIED_ERROR));
     };
-    callOptions.subscribeOptions                   = MQTTSubscribe_options_initializer;
-    callOptions.subscribeOptions.noLocal           = params.allowLocalTopics ? 0 : 1;
-    callOptions.subscribeOptions.retainAsPublished = getRetained ? 0 : 2;
-
-    auto status{pahoRcToReasonCode(MQTTAsync_subscribe(pClient, topic.c_str(), static_cast<int>(qos), &callOptions),
-                                   "MQTTAsync_subscribe")};
+    if (subscriptionId) {
+        MQTTProperty prop;
+        prop.identifier     = MQTTPROPERTY_CODE_SUBSCRIPTION_IDENTIFIER;
+        prop.value.integer4 = subscriptionId;
+        if (MQTTASYNC_SUCCESS != MQTTProperties_add(&callOptions.properties, &prop)) {
+            logCb->Log<LogLevel::ERROR>([] { return "Was not able to add subscription identifier"; });
+            MQTTProperties_free(&callOptions.properties);
+            return ReasonCode::ERROR_GENERAL;
+        }
+    }
+    /*Paho uses subscribeOptions for a single filter and subscribeOptionsList for more*/
+    callOptions.subscribeOptions      = options.front();
+    callOptions.subscribeOptionsCount = static_cast<int>(options.size());
+    callOptions.subscribeOptionsList  = options.data();
+
+    /*the completion is not handled, before the number of filters of the token is known*/
+    lock_guard<mutex> lock(filterMutex);
+    auto              status{pahoRcToReasonCode(
+        MQTTAsync_subscribeMany(
+            pClient, static_cast<int>(topics.size()), topics.data(), qos.data(), &callOptions),
+        "MQTTAsync_subscribeMany")};
+    MQTTProperties_free(&callOptions.properties);
+    if (ReasonCode::OKAY == status) {
+        filterCounts[callOptions.token] = subscriptions.size();
+    }
     if (token) {
         *token = callOptions.token;
     }
@@ -366,22 +471,41 @@ PahoClient::SubscribeAsync(string const& topic, IMqttMessage::QOS qos, int* toke
 }
 
 ReasonCode
-PahoClient::UnSubscribeAsync(string const& topic, int* token)
+PahoClient::unSubscribe(vector<string> const& topics, int* token)
 {
-    logCb->Log(LogLevel::TRACE, "Unsubscribing from topic: \"" + topic + "\"");
+    vector<char*> pTopics;
+    for (auto const& topic : topics) {
+        logCb->Log<LogLevel::TRACE>([&] { return "Unsubscribing from topic: \"" + topic + "\""; });
+        pTopics.push_back(const_cast<char*>(topic.c_str()));
+    }
+
     MQTTAsync_callOptions callOptions MQTTAsync_callOptions_initializer;
     callOptions.context    = this;
     callOptions.onSuccess5 = [](void* pThis, MQTTAsync_successData5* data) {
-        static_cast<PahoClient*>(pThis)->printDetailsOnSuccess("MQTTAsync_unsubscribe", data);
-        static_cast<PahoClient*>(pThis)->cmdCb->OnUnSubscribe(data->token);
+        auto pClient{static_cast<PahoClient*>(pThis)};
+        pClient->printDetailsOnSuccess("MQTTAsync_unsubscribeMany", data);
+        pClient->notifyUnSubscribe(data->token,
+                                   pClient->takeFilterResults(data->token,
+                                                              data->alt.unsub.reasonCodeCount,
+                                                              data->alt.unsub.reasonCodes,
+                                                              data->reasonCode));
     };
     callOptions.onFailure5 = [](void* pThis, MQTTAsync_failureData5* data) {
-        static_cast<PahoClient*>(pThis)->printDetailsOnFailure("MQTTAsync_unsubscribe", data);
-        // TODO: call the user callback with Mqtt5ReasonCode
+        auto pClient{static_cast<PahoClient*>(pThis)};
+        pClient->printDetailsOnFailure("MQTTAsync_unsubscribeMany", data);
+        pClient->notifyUnSubscribeFailure(
+            data->token,
+            pClient->takeFilterResults(
+                data->token, 0, nullptr, data->reasonCode ? data->reasonCode : MQTTREASONCODE_UNSPECIFIED_ERROR));
     };
 
-    auto status{
-        pahoRcToReasonCode(MQTTAsync_unsubscribe(pClient, topic.c_str(), &callOptions), "MQTTAsync_unsubscribe")};
+    lock_guard<mutex> lock(filterMutex);
+    auto              status{pahoRcToReasonCode(
+        MQTTAsync_unsubscribeMany(pClient, static_cast<int>(pTopics.size()), pTopics.data(), &callOptions),
+        "MQTTAsync_unsubscribeMany")};
+    if (ReasonCode::OKAY == status) {
+        filterCounts[callOptions.token] = topics.size();
+    }
     if (token) {
         *token = callOptions.token;
     }
@@ -389,20 +513,21 @@ PahoClient::UnSubscribeAsync(string const& topic, int* token)
 }
 
 ReasonCode
-PahoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
+PahoClient::publish(upMqttMessage_t mqttMsg, int* token)
 {
-    logCb->Log(LogLevel::DEBUG, "Publishing to topic: \"" + mqttMsg->topic + "\"");
+    logCb->Log<LogLevel::DEBUG>([&] { return "Publishing to topic: \"" + mqttMsg->topic + "\""; });
     MQTTAsync_callOptions callOptions MQTTAsync_callOptions_initializer;
     callOptions.context    = this;
     callOptions.onFailure5 = [](void* pThis, MQTTAsync_failureData5* data) {
         static_cast<PahoClient*>(pThis)->printDetailsOnFailure("MQTTAsync_sendMessage", data);
-        static_cast<PahoClient*>(pThis)->cmdCb->OnPublish(data->token, static_cast<Mqtt5ReasonCode>(data->reasonCode));
+        static_cast<PahoClient*>(pThis)->notifyPublish(data->token, static_cast<Mqtt5ReasonCode>(data->reasonCode));
     };
     callOptions.onSuccess5 = [](void* pThis, MQTTAsync_successData5* data) {
         static_cast<PahoClient*>(pThis)->printDetailsOnSuccess("MQTTAsync_sendMessage", data);
-        static_cast<PahoClient*>(pThis)->logCb->Log(LogLevel::DEBUG,
-                                                    "Paho Publish finished for token: " + to_string(data->token));
-        static_cast<PahoClient*>(pThis)->cmdCb->OnPublish(data->token, static_cast<Mqtt5ReasonCode>(data->reasonCode));
+        static_cast<PahoClient*>(pThis)->logCb->Log<LogLevel::DEBUG>([&] {
+            return "Paho Publish finished for token: " + to_string(data->token);
+        });
+        static_cast<PahoClient*>(pThis)->notifyPublish(data->token, static_cast<Mqtt5ReasonCode>(data->reasonCode));
     };
 
     MQTTAsync_message msg MQTTAsync_message_initializer;
@@ -422,7 +547,7 @@ PahoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
         prop.value.value.len  = static_cast<int>(userProp.second.size());
 
         if (MQTTASYNC_SUCCESS != MQTTProperties_add(&msg.properties, &prop)) {
-            logCb->Log(LogLevel::ERROR, "Was not able to add user property, ignoring message");
+            logCb->Log<LogLevel::ERROR>([] { return "Was not able to add user property, ignoring message"; });
             propertiesOkay = false;
         }
     }
@@ -432,7 +557,7 @@ PahoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
         prop.value.data.data = const_cast<char*>(mqttMsg->responseTopic.c_str());
         prop.value.data.len  = static_cast<int>(mqttMsg->responseTopic.size());
         if (MQTTASYNC_SUCCESS != MQTTProperties_add(&msg.properties, &prop)) {
-            logCb->Log(LogLevel::ERROR, "Was not able to add reponse topic, ignoring message");
+            logCb->Log<LogLevel::ERROR>([] { return "Was not able to add reponse topic, ignoring message"; });
             propertiesOkay = false;
         }
     }
@@ -442,7 +567,7 @@ PahoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
         prop.value.data.data = reinterpret_cast<char*>(mqttMsg->correlationDataProps.data());
         prop.value.data.len  = static_cast<int>(mqttMsg->correlationDataProps.size());
         if (MQTTASYNC_SUCCESS != MQTTProperties_add(&msg.properties, &prop)) {
-            logCb->Log(LogLevel::ERROR, "Was not able to add correlation data, ignoring message");
+            logCb->Log<LogLevel::ERROR>([] { return "Was not able to add correlation data, ignoring message"; });
             propertiesOkay = false;
         }
     }
@@ -451,7 +576,7 @@ PahoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
         prop.identifier = MQTTPROPERTY_CODE_PAYLOAD_FORMAT_INDICATOR;
         prop.value.byte = mqttMsg->payloadFormatIndicator == IMqttMessage::FormatIndicator::UTF8 ? 1U : 0U;
         if (MQTTASYNC_SUCCESS != MQTTProperties_add(&msg.properties, &prop)) {
-            logCb->Log(LogLevel::ERROR, "Was not able to add format indicator, ignoring message");
+            logCb->Log<LogLevel::ERROR>([] { return "Was not able to add format indicator, ignoring message"; });
             propertiesOkay = false;
         }
     }
@@ -461,7 +586,7 @@ PahoClient::PublishAsync(upMqttMessage_t mqttMsg, int* token)
         prop.value.data.data = const_cast<char*>(mqttMsg->payloadContentType.c_str());
         prop.value.data.len  = static_cast<int>(mqttMsg->payloadContentType.size());
         if (MQTTASYNC_SUCCESS != MQTTProperties_add(&msg.properties, &prop)) {
-            logCb->Log(LogLevel::ERROR, "Was not able to add content type, ignoring message");
+            logCb->Log<LogLevel::ERROR>([] { return "Was not able to add content type, ignoring message"; });
             propertiesOkay = false;
         }
     }
@@ -485,7 +610,7 @@ PahoClient::IsConnected(void) const noexcept
 }
 
 ReasonCode
-PahoClient::pahoRcToReasonCode(int rc, string const& details) const
+PahoClient::pahoRcToReasonCode(int rc, char const* details) const
 {
     auto status{ReasonCode::ERROR_GENERAL};
     auto logLvl{LogLevel::ERROR};
@@ -501,18 +626,11 @@ PahoClient::pahoRcToReasonCode(int rc, string const& details) const
     default:
         break;
     }
-    logCb->Log(logLvl,
-               details + ": " + ReasonCodeToStringRepr(status).first + ", Paho: " + string(MQTTAsync_strerror(rc)));
+    if (logCb->IsLogged(logLvl)) {
+        logCb->Log(logLvl,
+                   string(details) + ": " + ReasonCodeToStringRepr(status).first +
+                       ", Paho: " + string(MQTTAsync_strerror(rc)));
+    }
     return status;
 }
-
-unique_ptr<IMqttClient>
-MqttClientFactory::Create(IMqttClient::InitializeParameters const& params,
-                          IMqttMessageCallbacks const*             msg,
-                          IMqttLogCallbacks const*                 log,
-                          IMqttCommandCallbacks const*             cmd,
-                          IMqttConnectionCallbacks const*          con)
-{
-    return unique_ptr<PahoClient>(new PahoClient(params, msg, log, cmd, con));
-}
 }  // namespace i_mqtt_client
@@ -24,36 +24,42 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
-#include "IMqttClient.h"
 #include "MQTTAsync.h"
+#include "MqttClientBase.h"
 
 namespace i_mqtt_client {
-class PahoClient : public IMqttClient {
+class PahoClient : public MqttClientBase {
 private:
-    struct Context final {
-        PahoClient* pThis;
-        void*       pContext;
-        Context(PahoClient* pClient, void* pContext)
-          : pThis(pClient)
-          , pContext(pContext){};
-    };
     static std::once_flag initFlag;
 
-    InitializeParameters params;
-    MQTTAsync            pClient{nullptr};
+    MQTTAsync pClient{nullptr};
+    /*session present flag of the last CONNACK, the connected callback does not provide it*/
+    std::atomic_bool sessionPresent{false};
+    /*set from a lost connection until connected again, while reconnects are scheduled by the reconnect scheduler*/
+    std::atomic_bool recovering{false};
+    std::mutex       reconnectMutex;
+    bool             stopping{false};
+
+    /*number of topic filters per (un)subscribe token*/
+    mutable std::mutex                      filterMutex;
+    mutable std::unordered_map<int, size_t> filterCounts;
 
     virtual ReasonCode ConnectAsync(void) override;
     virtual ReasonCode DisconnectAsync(Mqtt5ReasonCode) override;
-    virtual ReasonCode SubscribeAsync(std::string const&, IMqttMessage::QOS, int*, bool) override;
-    virtual ReasonCode UnSubscribeAsync(std::string const&, int*) override;
-    virtual ReasonCode PublishAsync(upMqttMessage_t, int*) override;
+    virtual ReasonCode subscribe(std::vector<TopicSubscription> const&, std::uint32_t, int*) override;
+    virtual ReasonCode unSubscribe(std::vector<std::string> const&, int*) override;
+    virtual ReasonCode publish(upMqttMessage_t, int*) override;
     virtual bool       IsConnected(void) const noexcept override;
 
-    void       printDetailsOnSuccess(std::string const&, MQTTAsync_successData5 const*) const;
-    void       printDetailsOnFailure(std::string const&, MQTTAsync_failureData5 const*) const;
-    ReasonCode pahoRcToReasonCode(int, std::string const&) const;
-    int        onMessageCb(char*, int, MQTTAsync_message*) const;
+    void                         printDetailsOnSuccess(char const*, MQTTAsync_successData5 const*) const;
+    void                         printDetailsOnFailure(char const*, MQTTAsync_failureData5 const*) const;
+    ReasonCode                   pahoRcToReasonCode(int, char const*) const;
+    void                         scheduleReconnect(void);
+    int                          onMessageCb(char*, int, MQTTAsync_message*) const;
+    std::vector<Mqtt5ReasonCode> takeFilterResults(int, int, MQTTReasonCodes const*, MQTTReasonCodes) const;
 
 public:
     PahoClient(IMqttClient::InitializeParameters const&,
@@ -63,4 +69,7 @@ public:
                IMqttConnectionCallbacks const*);
     virtual ~PahoClient() noexcept;
 };
+
+/*Converts a message received by Paho, topic and message stay owned by the caller*/
+upMqttMessage_t PahoToMqttMessage(char const* pTopic, int topicLen, MQTTAsync_message const*, IMqttLogCallbacks const*);
 }  // namespace i_mqtt_client
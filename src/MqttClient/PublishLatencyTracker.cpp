@@ -0,0 +1,147 @@
+/**
+ * @file PublishLatencyTracker.cpp
+ * @author Timo Lange
+ * @brief Implementation for tracking the round-trip latency of publishes
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "PublishLatencyTracker.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+PublishLatencyTracker::PublishLatencyTracker(void) noexcept
+{
+    for (auto& count : inFlight) {
+        count.store(0U, memory_order_relaxed);
+    }
+}
+
+bool
+PublishLatencyTracker::IsTracked(IMqttMessage::QOS qos) noexcept
+{
+    return IMqttMessage::QOS::QOS_0 != qos;
+}
+
+void
+PublishLatencyTracker::record(Pending const& publish, clock_t::time_point completed) noexcept
+{
+    auto index{static_cast<size_t>(publish.qos)};
+    histograms[index].Record(duration_cast<microseconds>(completed - publish.submitted));
+    inFlight[index].fetch_sub(1U, memory_order_relaxed);
+}
+
+PublishLatencyTracker::clock_t::time_point
+PublishLatencyTracker::Begin(void)
+{
+    lock_guard<mutex> lock(trackerMutex);
+    submitting++;
+    return clock_t::now();
+}
+
+void
+PublishLatencyTracker::Submitted(clock_t::time_point submitted, int token, IMqttMessage::QOS qos, bool success)
+{
+    lock_guard<mutex> lock(trackerMutex);
+    submitting--;
+    auto early{earlyCompletions.find(token)};
+    if (success) {
+        Pending publish{submitted, qos};
+        inFlight[static_cast<size_t>(qos)].fetch_add(1U, memory_order_relaxed);
+        /*the completion may have overtaken us, while the token was not known yet*/
+        if (early != earlyCompletions.end()) {
+            if (clock_t::time_point() != early->second) {
+                record(publish, early->second);
+            }
+            else {
+                inFlight[static_cast<size_t>(qos)].fetch_sub(1U, memory_order_relaxed);
+            }
+        }
+        else {
+            auto previous{pending.find(token)};
+            if (previous != pending.end()) {
+                /*the token was reused by the MQTT library, the previous publish is not going to complete any more*/
+                inFlight[static_cast<size_t>(previous->second.qos)].fetch_sub(1U, memory_order_relaxed);
+                previous->second = publish;
+            }
+            else {
+                pending.emplace(token, publish);
+            }
+        }
+    }
+    if (early != earlyCompletions.end()) {
+        earlyCompletions.erase(early);
+    }
+    if (!submitting) {
+        earlyCompletions.clear();
+    }
+}
+
+void
+PublishLatencyTracker::finish(int token, clock_t::time_point completed)
+{
+    lock_guard<mutex> lock(trackerMutex);
+    auto              publish{pending.find(token)};
+    if (publish != pending.end()) {
+        if (clock_t::time_point() != completed) {
+            record(publish->second, completed);
+        }
+        else {
+            inFlight[static_cast<size_t>(publish->second.qos)].fetch_sub(1U, memory_order_relaxed);
+        }
+        pending.erase(publish);
+    }
+    else if (submitting) {
+        earlyCompletions[token] = completed;
+    }
+}
+
+void
+PublishLatencyTracker::Completed(int token)
+{
+    finish(token, clock_t::now());
+}
+
+void
+PublishLatencyTracker::Abandon(int token)
+{
+    finish(token, clock_t::time_point());
+}
+
+void
+PublishLatencyTracker::Reset(void)
+{
+    lock_guard<mutex> lock(trackerMutex);
+    pending.clear();
+    for (auto& count : inFlight) {
+        count.store(0U, memory_order_relaxed);
+    }
+}
+
+IMqttClient::PublishLatencySnapshot
+PublishLatencyTracker::GetSnapshot(IMqttMessage::QOS qos) const noexcept
+{
+    IMqttClient::PublishLatencySnapshot snapshot;
+    if (!IsTracked(qos)) {
+        return snapshot;
+    }
+    auto index{static_cast<size_t>(qos)};
+    histograms[index].Snapshot(snapshot);
+    snapshot.inFlight = inFlight[index].load(memory_order_relaxed);
+    return snapshot;
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,74 @@
+/**
+ * @file PublishLatencyTracker.h
+ * @author Timo Lange
+ * @brief Class definition for tracking the round-trip latency of publishes
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "IMqttClient.h"
+#include "LatencyHistogram.h"
+
+namespace i_mqtt_client {
+/*Timestamps publish tokens when handed over to the MQTT library and when completed. Only QOS1 and QOS2 publishes are
+ * tracked, as QOS0 publishes are not acknowledged.*/
+class PublishLatencyTracker final {
+public:
+    using clock_t = std::chrono::steady_clock;
+
+private:
+    struct Pending final {
+        clock_t::time_point submitted;
+        IMqttMessage::QOS   qos;
+    };
+
+    std::mutex                                   trackerMutex;
+    std::unordered_map<int, Pending>             pending;
+    /*a default constructed time point marks a publish that was abandoned before its token was known*/
+    std::unordered_map<int, clock_t::time_point> earlyCompletions;
+    unsigned                                     submitting{0U};
+    std::array<LatencyHistogram, 3>              histograms;
+    std::array<std::atomic<std::uint64_t>, 3>    inFlight;
+
+    void record(Pending const&, clock_t::time_point) noexcept;
+    void finish(int token, clock_t::time_point);
+
+public:
+    PublishLatencyTracker(void) noexcept;
+
+    static bool IsTracked(IMqttMessage::QOS) noexcept;
+
+    /*to be called right before handing a message over to the MQTT library*/
+    clock_t::time_point Begin(void);
+    /*to be called once the MQTT library returned, also if it failed*/
+    void Submitted(clock_t::time_point, int token, IMqttMessage::QOS, bool success);
+    void Completed(int token);
+    /*to be called for failed publishes, they are not recorded*/
+    void Abandon(int token);
+    /*to be called on a disconnect, publishes in flight are not recorded any more*/
+    void Reset(void);
+
+    IMqttClient::PublishLatencySnapshot GetSnapshot(IMqttMessage::QOS) const noexcept;
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,221 @@
+/**
+ * @file PublishRateLimiter.cpp
+ * @author Timo Lange
+ * @brief Implementation of a token bucket based rate limiter for publishes
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "PublishRateLimiter.h"
+
+#include "TopicFilter.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+/*bounds the memory for publishers generating topics, e.g. with ids in them*/
+static constexpr size_t maxTopicMatches{4096U};
+
+PublishRateLimiter::PublishRateLimiter(IMqttClient::PublishRateLimitParameters const& params, publishFunc_t func)
+  : mode(params.mode)
+  , maxQueued(params.maxQueued)
+  , publishFunc(move(func))
+  , globalBucket(params.global.rate, params.global.burst)
+{
+    for (auto const& topic : params.topics) {
+        if (topic.topicFilter.empty()) {
+            throw runtime_error("topic rate limit without topic filter");
+        }
+        topicBuckets.push_back({topic.topicFilter, TokenBucket(topic.bucket.rate, topic.bucket.burst)});
+    }
+    if (IMqttClient::RateLimitMode::QUEUE == mode) {
+        queueThread = thread(&PublishRateLimiter::queueWorker, this);
+    }
+}
+
+PublishRateLimiter::~PublishRateLimiter() noexcept
+{
+    Stop();
+}
+
+void
+PublishRateLimiter::Stop(void) noexcept
+{
+    {
+        unique_lock<mutex> lock(limiterMutex);
+        limiterExit = true;
+        limiterAwaiter.notify_all();
+        limiterAwaiter.wait(lock, [this] { return !delaying; });
+    }
+    if (queueThread.joinable()) {
+        queueThread.join();
+    }
+}
+
+bool
+PublishRateLimiter::IsConfigured(IMqttClient::PublishRateLimitParameters const& params) noexcept
+{
+    return params.global.rate > 0.0 || !params.topics.empty();
+}
+
+vector<size_t> const&
+PublishRateLimiter::matchingBuckets(string const& topic)
+{
+    auto match{topicMatches.find(topic)};
+    if (match != topicMatches.end()) {
+        return match->second;
+    }
+    if (topicMatches.size() >= maxTopicMatches) {
+        topicMatches.clear();
+    }
+    auto& indexes = topicMatches[topic];
+    for (size_t i{0U}; i < topicBuckets.size(); i++) {
+        if (TopicMatchesFilter(topicBuckets[i].filter, topic)) {
+            indexes.push_back(i);
+        }
+    }
+    return indexes;
+}
+
+bool
+PublishRateLimiter::tryAcquire(vector<size_t> const& buckets, TokenBucket::clock_t::time_point now, microseconds& wait)
+{
+    /*a token has to be available in all relevant buckets, before taking any*/
+    wait = globalBucket.TimeUntilToken(now);
+    for (auto i : buckets) {
+        wait = max(wait, topicBuckets[i].bucket.TimeUntilToken(now));
+    }
+    if (wait.count() > 0) {
+        return false;
+    }
+    globalBucket.Take();
+    for (auto i : buckets) {
+        topicBuckets[i].bucket.Take();
+    }
+    return true;
+}
+
+ReasonCode
+PublishRateLimiter::Publish(upMqttMessage_t msg, int* token)
+{
+    unique_lock<mutex> lock(limiterMutex);
+    auto               wait{microseconds(0)};
+    if (limiterExit) {
+        return ReasonCode::ERROR_GENERAL;
+    }
+    auto const& buckets = matchingBuckets(msg->topic);
+    /*already queued messages go first, in order to keep the order of publishes*/
+    if ((IMqttClient::RateLimitMode::QUEUE != mode || queue.empty()) &&
+        tryAcquire(buckets, TokenBucket::clock_t::now(), wait)) {
+        passed++;
+        lock.unlock();
+        return publishFunc(move(msg), token);
+    }
+    switch (mode) {
+    case IMqttClient::RateLimitMode::QUEUE:
+        if (queue.size() >= maxQueued) {
+            rejected++;
+            return ReasonCode::ERROR_RATE_LIMITED;
+        }
+        delayed++;
+        queue.push_back(move(msg));
+        if (token) {
+            *token = -1;
+        }
+        lock.unlock();
+        limiterAwaiter.notify_all();
+        return ReasonCode::OKAY;
+    case IMqttClient::RateLimitMode::DELAY: {
+        delayed++;
+        delaying++;
+        /*copied, other publishers may drop the matches while this one waits*/
+        auto delayedBuckets(buckets);
+        while (!limiterExit && !tryAcquire(delayedBuckets, TokenBucket::clock_t::now(), wait)) {
+            limiterAwaiter.wait_for(lock, wait);
+        }
+        auto status{ReasonCode::ERROR_GENERAL};
+        if (!limiterExit) {
+            lock.unlock();
+            status = publishFunc(move(msg), token);
+            lock.lock();
+        }
+        /*the destructor might be waiting for this caller*/
+        if (!--delaying && limiterExit) {
+            limiterAwaiter.notify_all();
+        }
+        return status;
+    }
+    case IMqttClient::RateLimitMode::REJECT:
+        /*fallthrough*/
+    default:
+        rejected++;
+        return ReasonCode::ERROR_RATE_LIMITED;
+    }
+}
+
+void
+PublishRateLimiter::SetConnected(bool isConnected)
+{
+    {
+        lock_guard<mutex> lock(limiterMutex);
+        connected = isConnected;
+    }
+    limiterAwaiter.notify_all();
+}
+
+void
+PublishRateLimiter::queueWorker(void)
+{
+    unique_lock<mutex> lock(limiterMutex);
+    while (!limiterExit) {
+        auto wait{microseconds(0)};
+        if (queue.empty() || !connected) {
+            /*messages stay queued while disconnected, instead of being rejected by the MQTT library*/
+            limiterAwaiter.wait(lock, [this] { return limiterExit || (!queue.empty() && connected); });
+        }
+        else if (!tryAcquire(matchingBuckets(queue.front()->topic), TokenBucket::clock_t::now(), wait)) {
+            limiterAwaiter.wait_for(lock, wait);
+        }
+        else {
+            auto msg{move(queue.front())};
+            queue.pop_front();
+            lock.unlock();
+            /*errors are logged by the client, there is nobody to hand them over to, the token is reported via
+             * IMqttCommandCallbacks::OnPublish only*/
+            (void)publishFunc(move(msg), nullptr);
+            lock.lock();
+        }
+    }
+}
+
+IMqttClient::PublishRateLimiterStatus
+PublishRateLimiter::GetStatus(void) const
+{
+    IMqttClient::PublishRateLimiterStatus status;
+    auto                                  now{TokenBucket::clock_t::now()};
+    lock_guard<mutex>                     lock(limiterMutex);
+    status.enabled      = true;
+    status.globalTokens = globalBucket.Tokens(now);
+    status.queued       = queue.size();
+    status.passed       = passed;
+    status.delayed      = delayed;
+    status.rejected     = rejected;
+    for (auto& topicBucket : topicBuckets) {
+        status.topicTokens.push_back(make_pair(topicBucket.filter, topicBucket.bucket.Tokens(now)));
+    }
+    return status;
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,81 @@
+/**
+ * @file PublishRateLimiter.h
+ * @author Timo Lange
+ * @brief Class definition for the publish rate limiter
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "IMqttClient.h"
+#include "TokenBucket.h"
+
+namespace i_mqtt_client {
+class PublishRateLimiter final {
+public:
+    using publishFunc_t = std::function<ReasonCode(upMqttMessage_t, int*)>;
+
+private:
+    struct TopicBucket final {
+        std::string filter;
+        TokenBucket bucket;
+    };
+
+    IMqttClient::RateLimitMode const mode;
+    size_t const                     maxQueued;
+    publishFunc_t const              publishFunc;
+
+    mutable std::mutex               limiterMutex;
+    std::condition_variable          limiterAwaiter;
+    mutable TokenBucket              globalBucket;
+    mutable std::vector<TopicBucket> topicBuckets;
+    /*indexes of the topic buckets matching a topic, so a topic is matched against all filters only once*/
+    std::unordered_map<std::string, std::vector<size_t>> topicMatches;
+    std::deque<upMqttMessage_t>      queue;
+    std::thread                      queueThread;
+    bool                             limiterExit{false};
+    bool                             connected{false};
+    /*callers blocked or publishing in RateLimitMode::DELAY, the destructor waits for them to leave*/
+    unsigned                         delaying{0U};
+    std::uint64_t                    passed{0U};
+    std::uint64_t                    delayed{0U};
+    std::uint64_t                    rejected{0U};
+
+    std::vector<size_t> const& matchingBuckets(std::string const&);
+    bool tryAcquire(std::vector<size_t> const&, TokenBucket::clock_t::time_point, std::chrono::microseconds&);
+    void queueWorker(void);
+
+public:
+    PublishRateLimiter(IMqttClient::PublishRateLimitParameters const&, publishFunc_t);
+    ~PublishRateLimiter() noexcept;
+
+    static bool IsConfigured(IMqttClient::PublishRateLimitParameters const&) noexcept;
+
+    ReasonCode                            Publish(upMqttMessage_t, int*);
+    void                                  SetConnected(bool);
+    /*stops publishing, waits for delayed callers to leave, can be called multiple times*/
+    void                                  Stop(void) noexcept;
+    IMqttClient::PublishRateLimiterStatus GetStatus(void) const;
+};
+}  // namespace i_mqtt_client
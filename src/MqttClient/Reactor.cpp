@@ -0,0 +1,452 @@
+/**
+ * @file Reactor.cpp
+ * @author Timo Lange
+ * @brief Implementation of event loops driving the network traffic of many clients
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "Reactor.h"
+
+#include "IReconnectScheduler.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+Reactor::Client::Client(IMqttClient& mqttClient, IMqttExternalLoop& loopHooks)
+  : client(mqttClient)
+  , hooks(loopHooks)
+{
+}
+
+Reactor::Loop::Loop(Reactor const& parent, size_t loopIndex)
+  : reactor(parent)
+  , index(loopIndex)
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw runtime_error("Was not able to create epoll instance: " + string(strerror(errno)));
+    }
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    epoll_event event{};
+    event.events   = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (wakeFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) < 0) {
+        auto error{string(strerror(errno))};
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+        close(epollFd);
+        throw runtime_error("Was not able to create wake up event: " + error);
+    }
+    loopThread = thread(&Loop::run, this);
+}
+
+Reactor::Loop::~Loop() noexcept
+{
+    {
+        lock_guard<mutex> lock(loopMutex);
+        loopExit = true;
+    }
+    signal();
+    if (loopThread.joinable()) {
+        loopThread.join();
+    }
+    close(wakeFd);
+    close(epollFd);
+}
+
+bool
+Reactor::Loop::IsLoopThread(void) const noexcept
+{
+    return this_thread::get_id() == loopThread.get_id();
+}
+
+void
+Reactor::Loop::signal(void) const noexcept
+{
+    (void)eventfd_write(wakeFd, 1U);
+}
+
+void
+Reactor::Loop::Add(unique_ptr<Client> client)
+{
+    {
+        lock_guard<mutex> lock(loopMutex);
+        joining.push_back(move(client));
+    }
+    count++;
+    signal();
+}
+
+void
+Reactor::Loop::Remove(Client* client)
+{
+    unique_lock<mutex> lock(loopMutex);
+    leaving.push_back(client);
+    signal();
+    loopAwaiter.wait(lock, [this, client] {
+        return loopExit || find(leaving.begin(), leaving.end(), client) == leaving.end();
+    });
+    count--;
+}
+
+void
+Reactor::Loop::WakeUp(Client* client)
+{
+    /*a client is queued once, until the loop handled it*/
+    if (client->woken.exchange(true)) {
+        return;
+    }
+    wakeUpCount.fetch_add(1U, memory_order_relaxed);
+    bool pending{false};
+    {
+        lock_guard<mutex> lock(loopMutex);
+        pending = !woken.empty();
+        woken.push_back(client);
+    }
+    /*the loop is signalled already, if there were clients queued*/
+    if (!pending) {
+        signal();
+    }
+}
+
+void
+Reactor::Loop::run(void)
+{
+    if (reactor.params.pinLoops) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % max(thread::hardware_concurrency(), 1U), &cpus);
+        auto rc{pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)};
+        if (rc) {
+            reactor.log<LogLevel::WARNING>([&] {
+                return "Was not able to pin loop " + to_string(index) + ": " + strerror(rc);
+            });
+        }
+    }
+    vector<epoll_event> events(256U);
+    auto                nextTick{clock_t::now() + reactor.params.tickInterval};
+    while (true) {
+        auto wait{duration_cast<milliseconds>(min(nextTick, nextReconnect) - clock_t::now())};
+        /*round up, in order to not wake up right before the deadline*/
+        auto timeout{static_cast<int>(max<milliseconds::rep>(wait.count() + 1, 0))};
+        auto ready{epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeout)};
+        if (ready < 0 && EINTR != errno) {
+            reactor.log<LogLevel::ERROR>([&] {
+                return "epoll_wait failed, stopping loop: " + string(strerror(errno));
+            });
+            {
+                lock_guard<mutex> lock(loopMutex);
+                loopExit = true;
+            }
+            loopAwaiter.notify_all();
+            return;
+        }
+        auto signalled{false};
+        for (int i{0}; i < ready; i++) {
+            if (events[i].data.ptr) {
+                handleEvents(*static_cast<Client*>(events[i].data.ptr), events[i].events);
+            }
+            else {
+                signalled = true;
+            }
+        }
+        /*commands are handled last, as they may remove clients with events pending in this round*/
+        if (signalled && !handleCommands()) {
+            return;
+        }
+        auto now{clock_t::now()};
+        if (now >= nextReconnect) {
+            reconnect(now);
+        }
+        if (now >= nextTick) {
+            tick();
+            nextTick = now + reactor.params.tickInterval;
+        }
+    }
+}
+
+bool
+Reactor::Loop::handleCommands(void)
+{
+    eventfd_t value{0U};
+    (void)eventfd_read(wakeFd, &value);
+    vector<unique_ptr<Client>> joined;
+    vector<Client*>            wakeUps;
+    vector<Client*>            left;
+    {
+        lock_guard<mutex> lock(loopMutex);
+        if (loopExit) {
+            return false;
+        }
+        joined.swap(joining);
+        wakeUps.swap(woken);
+        left = leaving;
+    }
+    for (auto& client : joined) {
+        auto pClient{client.get()};
+        clients[pClient] = move(client);
+        sync(*pClient, true);
+    }
+    for (auto client : wakeUps) {
+        /*wake ups may race with the removal of the client*/
+        if (clients.count(client)) {
+            client->woken = false;
+            sync(*client, true);
+        }
+    }
+    if (left.empty()) {
+        return true;
+    }
+    for (auto client : left) {
+        auto it{clients.find(client)};
+        if (clients.end() == it) {
+            continue;
+        }
+        /*the socket stays with the client, so it has to be unwatched explicitly*/
+        if (client->fd >= 0 && client->hooks.Socket() == client->fd) {
+            (void)epoll_ctl(epollFd, EPOLL_CTL_DEL, client->fd, nullptr);
+        }
+        clients.erase(it);
+    }
+    {
+        lock_guard<mutex> lock(loopMutex);
+        for (auto client : left) {
+            leaving.erase(remove(leaving.begin(), leaving.end(), client), leaving.end());
+        }
+    }
+    loopAwaiter.notify_all();
+    return true;
+}
+
+void
+Reactor::Loop::handleEvents(Client& client, uint32_t flags)
+{
+    eventCount.fetch_add(1U, memory_order_relaxed);
+    /*errors are logged by the client, reading reports them and closes the socket*/
+    if (flags & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        (void)client.hooks.Read();
+    }
+    if ((flags & EPOLLOUT) && client.hooks.Socket() >= 0) {
+        (void)client.hooks.Write();
+    }
+    sync(client, false);
+}
+
+void
+Reactor::Loop::sync(Client& client, bool force)
+{
+    if (client.client.IsConnected()) {
+        client.attempts = 0U;
+        if (client.recovering && reactor.params.reconnectScheduler) {
+            reactor.params.reconnectScheduler->Connected(&client.client);
+        }
+        client.recovering = false;
+    }
+    auto fd{client.hooks.Socket()};
+    /*closed sockets are removed from epoll by the kernel, so a changed socket is only registered*/
+    if (fd != client.fd) {
+        client.fd     = fd;
+        client.events = 0U;
+    }
+    if (fd < 0) {
+        if (clock_t::time_point::max() == client.reconnectAt && client.hooks.WantReconnect()) {
+            client.reconnectAt = clock_t::now() + reactor.reconnectDelay(client.client, client.attempts);
+            client.recovering  = true;
+            nextReconnect      = min(nextReconnect, client.reconnectAt);
+        }
+        return;
+    }
+    epoll_event event{};
+    event.events   = EPOLLIN | (client.hooks.WantWrite() ? EPOLLOUT : 0U);
+    event.data.ptr = &client;
+    if (client.events && !force && event.events == client.events) {
+        return;
+    }
+    auto rc{epoll_ctl(epollFd, client.events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event)};
+    if (rc < 0 && (ENOENT == errno || EEXIST == errno)) {
+        /*the socket got replaced by one with the same number, or is still registered*/
+        rc = epoll_ctl(epollFd, ENOENT == errno ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &event);
+    }
+    if (rc < 0) {
+        reactor.log<LogLevel::ERROR>([&] { return "Was not able to watch socket: " + string(strerror(errno)); });
+        client.events = 0U;
+        return;
+    }
+    client.events = event.events;
+}
+
+void
+Reactor::Loop::tick(void)
+{
+    for (auto& entry : clients) {
+        auto& client = *entry.second;
+        if (client.fd >= 0) {
+            /*sends keep alives and detects timed out connections*/
+            (void)client.hooks.Misc();
+        }
+        sync(client, false);
+    }
+}
+
+void
+Reactor::Loop::reconnect(clock_t::time_point now)
+{
+    nextReconnect = clock_t::time_point::max();
+    for (auto& entry : clients) {
+        auto& client = *entry.second;
+        if (client.reconnectAt <= now) {
+            client.reconnectAt = clock_t::time_point::max();
+            if (client.hooks.WantReconnect()) {
+                client.attempts++;
+                reconnectCount.fetch_add(1U, memory_order_relaxed);
+                (void)client.hooks.Reconnect();
+            }
+            sync(client, true);
+        }
+        nextReconnect = min(nextReconnect, client.reconnectAt);
+    }
+}
+
+Reactor::Reactor(Parameters const& parameters, IMqttLogCallbacks const* log)
+  : params(parameters)
+  , logCb(log)
+{
+    if (params.tickInterval.count() <= 0) {
+        throw runtime_error("reactor tick interval has to be positive");
+    }
+    if (params.reconnectDelayMin.count() <= 0 || params.reconnectDelayMin > params.reconnectDelayMax) {
+        throw runtime_error("reconnectDelay not properly set");
+    }
+    auto count{params.loops ? params.loops : max(thread::hardware_concurrency(), 1U)};
+    this->log<LogLevel::INFO>([&] { return "Starting reactor with " + to_string(count) + " loops"; });
+    for (size_t i{0U}; i < count; i++) {
+        loops.emplace_back(new Loop(*this, i));
+    }
+}
+
+Reactor::~Reactor() noexcept
+{
+    lock_guard<mutex> lock(reactorMutex);
+    /*the clients may outlive the reactor, they must not wake up a destroyed loop*/
+    for (auto const& assignment : assignments) {
+        assignment.second.second->hooks.SetWakeUp(nullptr);
+    }
+    assignments.clear();
+    loops.clear();
+}
+
+Reactor::clock_t::duration
+Reactor::reconnectDelay(IMqttClient const& client, unsigned attempts) const
+{
+    if (params.reconnectScheduler) {
+        return params.reconnectScheduler->NextAttempt(&client);
+    }
+    auto delay{params.reconnectDelayMin};
+    for (unsigned i{0U}; i < attempts && delay < params.reconnectDelayMax; i++) {
+        delay *= 2;
+    }
+    return min(delay, params.reconnectDelayMax);
+}
+
+ReasonCode
+Reactor::Add(IMqttClient& client)
+{
+    auto hooks{client.GetExternalLoop()};
+    if (!hooks) {
+        log<LogLevel::ERROR>([] {
+            return "Client does not support an external loop, check InitializeParameters::externalLoop";
+        });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    lock_guard<mutex> lock(reactorMutex);
+    if (assignments.count(&client)) {
+        log<LogLevel::ERROR>([] { return "Client was added to the reactor already"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    auto loop{min_element(loops.begin(),
+                          loops.end(),
+                          [](unique_ptr<Loop> const& a, unique_ptr<Loop> const& b) { return a->count < b->count; })
+                  ->get()};
+    unique_ptr<Client> state(new Client(client, *hooks));
+    auto               pState{state.get()};
+    assignments[&client] = make_pair(loop, pState);
+    /*the loop has to know the client, before it can be woken up by it*/
+    loop->Add(move(state));
+    hooks->SetWakeUp([loop, pState] { loop->WakeUp(pState); });
+    return ReasonCode::OKAY;
+}
+
+ReasonCode
+Reactor::Remove(IMqttClient& client)
+{
+    unique_lock<mutex> lock(reactorMutex);
+    for (auto const& loop : loops) {
+        if (loop->IsLoopThread()) {
+            log<LogLevel::ERROR>([] { return "Clients must not be removed from within a loop of the reactor"; });
+            return ReasonCode::ERROR_GENERAL;
+        }
+    }
+    auto it{assignments.find(&client)};
+    if (assignments.end() == it) {
+        log<LogLevel::ERROR>([] { return "Client was not added to the reactor"; });
+        return ReasonCode::ERROR_GENERAL;
+    }
+    auto assignment{it->second};
+    assignments.erase(it);
+    lock.unlock();
+    assignment.second->hooks.SetWakeUp(nullptr);
+    assignment.first->Remove(assignment.second);
+    if (params.reconnectScheduler) {
+        params.reconnectScheduler->Forget(&client);
+    }
+    return ReasonCode::OKAY;
+}
+
+vector<IMqttReactor::LoopStatus>
+Reactor::GetStatus(void) const
+{
+    vector<LoopStatus> status;
+    lock_guard<mutex>  lock(reactorMutex);
+    for (auto const& loop : loops) {
+        LoopStatus loopStatus;
+        loopStatus.clients    = loop->count;
+        loopStatus.events     = loop->eventCount.load(memory_order_relaxed);
+        loopStatus.wakeUps    = loop->wakeUpCount.load(memory_order_relaxed);
+        loopStatus.reconnects = loop->reconnectCount.load(memory_order_relaxed);
+        status.push_back(loopStatus);
+    }
+    return status;
+}
+
+unique_ptr<IMqttReactor>
+MqttReactorFactory::Create(IMqttReactor::Parameters const& params, IMqttLogCallbacks const* log)
+{
+    return unique_ptr<IMqttReactor>(new Reactor(params, log));
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,123 @@
+/**
+ * @file Reactor.h
+ * @author Timo Lange
+ * @brief Class definition for event loops driving the network traffic of many clients
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "IMqttExternalLoop.h"
+#include "IMqttReactor.h"
+
+namespace i_mqtt_client {
+class Reactor final : public IMqttReactor {
+private:
+    using clock_t = std::chrono::steady_clock;
+
+    /*state of a client within its loop, everything but woken is only accessed by the loop thread*/
+    struct Client final {
+        IMqttClient&        client;
+        IMqttExternalLoop&  hooks;
+        std::atomic_bool    woken{false};
+        int                 fd{-1};
+        std::uint32_t       events{0U};
+        unsigned            attempts{0U};
+        bool                recovering{false};
+        clock_t::time_point reconnectAt{clock_t::time_point::max()};
+
+        Client(IMqttClient&, IMqttExternalLoop&);
+    };
+
+    class Loop final {
+    private:
+        Reactor const& reactor;
+        size_t const   index;
+        int            epollFd{-1};
+        int            wakeFd{-1};
+
+        mutable std::mutex                   loopMutex;
+        std::condition_variable              loopAwaiter;
+        std::vector<std::unique_ptr<Client>> joining;
+        std::vector<Client*>                 leaving;
+        std::vector<Client*>                 woken;
+        bool                                 loopExit{false};
+        /*only accessed by the loop thread*/
+        std::unordered_map<Client*, std::unique_ptr<Client>> clients;
+        clock_t::time_point                                  nextReconnect{clock_t::time_point::max()};
+        std::thread                                          loopThread;
+
+        void run(void);
+        void signal(void) const noexcept;
+        bool handleCommands(void);
+        void handleEvents(Client&, std::uint32_t);
+        void sync(Client&, bool force);
+        void tick(void);
+        void reconnect(clock_t::time_point);
+
+    public:
+        std::atomic<size_t>        count{0U};
+        std::atomic<std::uint64_t> eventCount{0U};
+        std::atomic<std::uint64_t> wakeUpCount{0U};
+        std::atomic<std::uint64_t> reconnectCount{0U};
+
+        Loop(Reactor const&, size_t);
+        ~Loop() noexcept;
+
+        bool IsLoopThread(void) const noexcept;
+        void Add(std::unique_ptr<Client>);
+        void Remove(Client*);
+        void WakeUp(Client*);
+    };
+
+    Parameters const                   params;
+    IMqttLogCallbacks const*           logCb;
+    mutable std::mutex                 reactorMutex;
+    std::vector<std::unique_ptr<Loop>> loops;
+    /*the loop and the state of each client added, the state is owned by the loop*/
+    std::unordered_map<IMqttClient const*, std::pair<Loop*, Client*>> assignments;
+
+    template <LogLevel lvl, class Formatter>
+    void
+    log(Formatter const& formatter) const
+    {
+        if (logCb) {
+            logCb->Log<lvl>(formatter);
+        }
+    }
+
+    clock_t::duration reconnectDelay(IMqttClient const&, unsigned attempts) const;
+
+    ReasonCode              Add(IMqttClient&) override;
+    ReasonCode              Remove(IMqttClient&) override;
+    std::vector<LoopStatus> GetStatus(void) const override;
+
+public:
+    Reactor(Parameters const&, IMqttLogCallbacks const*);
+    virtual ~Reactor() noexcept;
+};
+}  // namespace i_mqtt_client
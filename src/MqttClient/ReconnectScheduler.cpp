@@ -0,0 +1,221 @@
+/**
+ * @file ReconnectScheduler.cpp
+ * @author Timo Lange
+ * @brief Implementation of the reconnect scheduler shared by many clients
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "ReconnectScheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+ReconnectScheduler::ReconnectScheduler(Parameters const& parameters)
+  : params(parameters)
+{
+    if (params.backoffBase.count() <= 0 || params.backoffBase > params.backoffCap) {
+        throw runtime_error("reconnect backoff not properly set");
+    }
+    if (params.connectRate.rate < 0.0 || (params.connectRate.rate > 0.0 && !params.connectRate.burst)) {
+        throw runtime_error("reconnect rate not properly set");
+    }
+    timerThread = thread(&ReconnectScheduler::timerWorker, this);
+}
+
+ReconnectScheduler::~ReconnectScheduler() noexcept
+{
+    {
+        lock_guard<mutex> lock(schedulerMutex);
+        schedulerExit = true;
+    }
+    schedulerAwaiter.notify_all();
+    if (timerThread.joinable()) {
+        timerThread.join();
+    }
+}
+
+ReconnectScheduler::clock_t::time_point
+ReconnectScheduler::next(IMqttClient const* client, clock_t::time_point now)
+{
+    auto  inserted{recoveries.emplace(client, Recovery())};
+    auto& recovery = inserted.first->second;
+    if (inserted.second) {
+        recovery.since = now;
+        if (1U == recoveries.size()) {
+            outages++;
+            outageStart = now;
+        }
+    }
+    /*the shift is limited, as the bound reaches the cap long before*/
+    auto bound{min(milliseconds(params.backoffBase.count() << min(recovery.attempts, 20U)), params.backoffCap)};
+    recovery.attempts++;
+    attempts++;
+    if (params.fullJitter) {
+        bound = milliseconds(uniform_int_distribution<milliseconds::rep>(0, bound.count())(rndGenerator));
+    }
+    return reserve(now + bound, now);
+}
+
+ReconnectScheduler::clock_t::time_point
+ReconnectScheduler::reserve(clock_t::time_point due, clock_t::time_point now)
+{
+    if (params.connectRate.rate <= 0.0) {
+        return due;
+    }
+    /*time is split into fixed windows, each taking up to burst attempts, which gives the rate on average*/
+    auto window{duration<double>(static_cast<double>(params.connectRate.burst) / params.connectRate.rate)};
+    auto windowOf = [this, &window](clock_t::time_point t) {
+        return static_cast<int64_t>(duration<double>(t - epoch).count() / window.count());
+    };
+    slots.erase(slots.begin(), slots.lower_bound(windowOf(now)));
+    auto wanted{windowOf(due)};
+    auto index{wanted};
+    while (slots[index] >= params.connectRate.burst) {
+        index++;
+    }
+    slots[index]++;
+    if (index == wanted) {
+        return due;
+    }
+    rateLimited++;
+    return epoch + duration_cast<clock_t::duration>(window * index);
+}
+
+void
+ReconnectScheduler::unschedule(IMqttClient const* client, Recovery& recovery)
+{
+    if (clock_t::time_point::max() != recovery.due) {
+        auto range{timeline.equal_range(recovery.due)};
+        for (auto it = range.first; it != range.second; it++) {
+            if (client == it->second) {
+                timeline.erase(it);
+                break;
+            }
+        }
+    }
+    recovery.due     = clock_t::time_point::max();
+    recovery.attempt = nullptr;
+}
+
+void
+ReconnectScheduler::timerWorker(void)
+{
+    unique_lock<mutex> lock(schedulerMutex);
+    while (!schedulerExit) {
+        if (timeline.empty()) {
+            schedulerAwaiter.wait(lock);
+            continue;
+        }
+        auto first{timeline.begin()};
+        if (first->first > clock_t::now()) {
+            schedulerAwaiter.wait_until(lock, first->first);
+            continue;
+        }
+        auto  client{first->second};
+        auto& recovery = recoveries[client];
+        timeline.erase(first);
+        auto attempt{move(recovery.attempt)};
+        recovery.due     = clock_t::time_point::max();
+        recovery.attempt = nullptr;
+        running          = client;
+        lock.unlock();
+        if (attempt) {
+            attempt();
+        }
+        lock.lock();
+        running = nullptr;
+        schedulerAwaiter.notify_all();
+    }
+}
+
+milliseconds
+ReconnectScheduler::NextAttempt(IMqttClient const* client)
+{
+    auto              now{clock_t::now()};
+    lock_guard<mutex> lock(schedulerMutex);
+    return duration_cast<milliseconds>(next(client, now) - now);
+}
+
+void
+ReconnectScheduler::ScheduleAttempt(IMqttClient const* client, function<void(void)> attempt)
+{
+    auto now{clock_t::now()};
+    {
+        lock_guard<mutex> lock(schedulerMutex);
+        auto              due{next(client, now)};
+        auto&             recovery = recoveries[client];
+        unschedule(client, recovery);
+        recovery.due     = due;
+        recovery.attempt = move(attempt);
+        timeline.emplace(due, client);
+    }
+    schedulerAwaiter.notify_all();
+}
+
+void
+ReconnectScheduler::Connected(IMqttClient const* client)
+{
+    auto              now{clock_t::now()};
+    lock_guard<mutex> lock(schedulerMutex);
+    auto              it{recoveries.find(client)};
+    if (recoveries.end() == it) {
+        return;
+    }
+    recoverTimes.Record(duration_cast<microseconds>(now - it->second.since));
+    unschedule(client, it->second);
+    recoveries.erase(it);
+    if (recoveries.empty()) {
+        lastOutage = duration_cast<milliseconds>(now - outageStart);
+    }
+}
+
+void
+ReconnectScheduler::Forget(IMqttClient const* client)
+{
+    unique_lock<mutex> lock(schedulerMutex);
+    schedulerAwaiter.wait(lock, [this, client] { return running != client; });
+    auto it{recoveries.find(client)};
+    if (recoveries.end() != it) {
+        unschedule(client, it->second);
+        recoveries.erase(it);
+    }
+}
+
+IReconnectScheduler::Status
+ReconnectScheduler::GetStatus(void) const
+{
+    Status            status;
+    lock_guard<mutex> lock(schedulerMutex);
+    status.disconnected = recoveries.size();
+    status.attempts     = attempts;
+    status.rateLimited  = rateLimited;
+    status.outages      = outages;
+    status.lastOutage   = lastOutage;
+    recoverTimes.Snapshot(status.timeToRecover);
+    status.timeToRecover.inFlight = recoveries.size();
+    return status;
+}
+
+shared_ptr<IReconnectScheduler>
+ReconnectSchedulerFactory::Create(IReconnectScheduler::Parameters const& params)
+{
+    return make_shared<ReconnectScheduler>(params);
+}
+}  // namespace i_mqtt_client
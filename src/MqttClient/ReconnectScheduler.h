@@ -0,0 +1,83 @@
+/**
+ * @file ReconnectScheduler.h
+ * @author Timo Lange
+ * @brief Class definition for the reconnect scheduler shared by many clients
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#include "IReconnectScheduler.h"
+#include "LatencyHistogram.h"
+
+namespace i_mqtt_client {
+class ReconnectScheduler final : public IReconnectScheduler {
+private:
+    using clock_t = std::chrono::steady_clock;
+
+    /*a client that lost its connection and did not recover yet*/
+    struct Recovery final {
+        clock_t::time_point       since;
+        unsigned                  attempts{0U};
+        clock_t::time_point       due{clock_t::time_point::max()};
+        std::function<void(void)> attempt;
+    };
+
+    Parameters const          params;
+    clock_t::time_point const epoch{clock_t::now()};
+
+    mutable std::mutex                                     schedulerMutex;
+    std::condition_variable                                schedulerAwaiter;
+    std::unordered_map<IMqttClient const*, Recovery>       recoveries;
+    std::multimap<clock_t::time_point, IMqttClient const*> timeline;
+    std::map<std::int64_t, unsigned>                       slots; /*reserved attempts per window of connectRate*/
+    std::default_random_engine                             rndGenerator{std::random_device()()};
+    IMqttClient const*                                     running{nullptr};
+    bool                                                   schedulerExit{false};
+    std::uint64_t                                          attempts{0U};
+    std::uint64_t                                          rateLimited{0U};
+    std::uint64_t                                          outages{0U};
+    clock_t::time_point                                    outageStart;
+    std::chrono::milliseconds                              lastOutage{0};
+    LatencyHistogram                                       recoverTimes;
+    std::thread                                            timerThread;
+
+    clock_t::time_point next(IMqttClient const*, clock_t::time_point);
+    clock_t::time_point reserve(clock_t::time_point, clock_t::time_point);
+    void                unschedule(IMqttClient const*, Recovery&);
+    void                timerWorker(void);
+
+    std::chrono::milliseconds NextAttempt(IMqttClient const*) override;
+    void                      ScheduleAttempt(IMqttClient const*, std::function<void(void)>) override;
+    void                      Connected(IMqttClient const*) override;
+    void                      Forget(IMqttClient const*) override;
+    Status                    GetStatus(void) const override;
+
+public:
+    explicit ReconnectScheduler(Parameters const&);
+    ~ReconnectScheduler() noexcept;
+};
+}  // namespace i_mqtt_client
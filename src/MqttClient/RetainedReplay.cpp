@@ -0,0 +1,69 @@
+/**
+ * @file RetainedReplay.cpp
+ * @author Timo Lange
+ * @brief Implementation of replaying cached messages to shared subscriptions
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "RetainedReplay.h"
+
+using namespace std;
+
+namespace i_mqtt_client {
+RetainedReplay::RetainedReplay(replay_t replayFn)
+  : replay(move(replayFn))
+  , replayThread(&RetainedReplay::replayWorker, this)
+{
+}
+
+RetainedReplay::~RetainedReplay() noexcept
+{
+    {
+        lock_guard<mutex> lock(replayMutex);
+        replayExit = true;
+    }
+    replayAwaiter.notify_all();
+    if (replayThread.joinable()) {
+        replayThread.join();
+    }
+}
+
+void
+RetainedReplay::Submit(string const& filter, uint64_t handlerId, handler_t handler)
+{
+    {
+        lock_guard<mutex> lock(replayMutex);
+        requests.push_back({filter, handlerId, move(handler)});
+    }
+    replayAwaiter.notify_one();
+}
+
+void
+RetainedReplay::replayWorker(void)
+{
+    unique_lock<mutex> lock(replayMutex);
+    while (!replayExit) {
+        replayAwaiter.wait(lock, [this] { return replayExit || !requests.empty(); });
+        if (!replayExit) {
+            auto request{move(requests.front())};
+            requests.pop_front();
+            lock.unlock();
+            replay(request.filter, request.handlerId, request.handler);
+            lock.lock();
+        }
+    }
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,65 @@
+/**
+ * @file RetainedReplay.h
+ * @author Timo Lange
+ * @brief Class definition for replaying cached messages to shared subscriptions
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/*Replays the messages cached for a topic filter by a thread of its own, so the handler joining a shared subscription
+ * never runs on the thread of the subscriber, while it is still within SubscribeAsync. The replay function is expected
+ * to hand the messages over to this one handler only, the others received them already.*/
+class RetainedReplay final {
+public:
+    using handler_t = IMqttClient::messageHandler_t;
+    using replay_t  = std::function<void(std::string const& filter, std::uint64_t handlerId, handler_t const&)>;
+
+private:
+    struct Request final {
+        std::string   filter;
+        std::uint64_t handlerId;
+        handler_t     handler;
+    };
+
+    replay_t const          replay;
+    std::mutex              replayMutex;
+    std::condition_variable replayAwaiter;
+    std::deque<Request>     requests;
+    bool                    replayExit{false};
+    std::thread             replayThread;
+
+    void replayWorker(void);
+
+public:
+    explicit RetainedReplay(replay_t);
+    ~RetainedReplay() noexcept;
+
+    /*queues a replay of the messages cached for the filter to the handler, returns immediately*/
+    void Submit(std::string const& filter, std::uint64_t handlerId, handler_t);
+};
+}  // namespace i_mqtt_client
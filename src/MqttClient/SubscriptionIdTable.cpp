@@ -0,0 +1,157 @@
+/**
+ * @file SubscriptionIdTable.cpp
+ * @author Timo Lange
+ * @brief Implementation for dispatching messages by MQTTv5 subscription identifiers
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "SubscriptionIdTable.h"
+
+using namespace std;
+
+namespace i_mqtt_client {
+constexpr uint32_t SubscriptionIdTable::maxId;
+constexpr uint32_t SubscriptionIdTable::chunkSize;
+
+SubscriptionIdTable::SubscriptionIdTable(void)
+  : chunks(make_shared<chunks_t>())
+  , references(1U, 0U)
+{
+    /*identifier 0 is not allowed by MQTTv5*/
+}
+
+void
+SubscriptionIdTable::store(uint32_t id, shared_ptr<Slot const> slot)
+{
+    auto current{atomic_load(&chunks)};
+    if (id / chunkSize >= current->size()) {
+        /*only the list of chunks is copied, the chunks are shared*/
+        auto copy{make_shared<chunks_t>(*current)};
+        while (id / chunkSize >= copy->size()) {
+            copy->push_back(make_shared<chunk_t>());
+        }
+        current = copy;
+        atomic_store(&chunks, shared_ptr<chunks_t const>(move(copy)));
+    }
+    atomic_store(&(*(*current)[id / chunkSize])[id % chunkSize], move(slot));
+}
+
+shared_ptr<SubscriptionIdTable::Slot const>
+SubscriptionIdTable::load(chunks_t const& snapshot, uint32_t id) const noexcept
+{
+    if (id / chunkSize >= snapshot.size()) {
+        return nullptr;
+    }
+    return atomic_load(&(*snapshot[id / chunkSize])[id % chunkSize]);
+}
+
+void
+SubscriptionIdTable::release(uint32_t id)
+{
+    if (references[id] && !--references[id]) {
+        store(id, nullptr);
+        freeIds.push_back(id);
+    }
+}
+
+uint32_t
+SubscriptionIdTable::Assign(vector<string> const& filters, bool useRouter, handlers_t handlers)
+{
+    lock_guard<mutex> lock(tableMutex);
+    uint32_t          id{0U};
+    if (!freeIds.empty()) {
+        id = freeIds.front();
+        freeIds.pop_front();
+    }
+    else if (references.size() <= maxId) {
+        id = static_cast<uint32_t>(references.size());
+        references.push_back(0U);
+    }
+    else {
+        return 0U;
+    }
+    store(id, shared_ptr<Slot const>(new Slot{useRouter, move(handlers)}));
+    for (auto const& filter : filters) {
+        auto filterId{filterIds.find(filter)};
+        if (filterId != filterIds.end()) {
+            if (filterId->second == id) {
+                continue;
+            }
+            /*subscribing again replaces the subscription at the broker, including its identifier*/
+            release(filterId->second);
+            filterId->second = id;
+        }
+        else {
+            filterIds[filter] = id;
+        }
+        references[id]++;
+    }
+    return id;
+}
+
+void
+SubscriptionIdTable::Release(string const& filter)
+{
+    lock_guard<mutex> lock(tableMutex);
+    auto              filterId{filterIds.find(filter)};
+    if (filterId != filterIds.end()) {
+        release(filterId->second);
+        filterIds.erase(filterId);
+    }
+}
+
+void
+SubscriptionIdTable::SetHandlers(string const& filter, handlers_t handlers)
+{
+    lock_guard<mutex> lock(tableMutex);
+    auto              filterId{filterIds.find(filter)};
+    if (filterId == filterIds.end()) {
+        return;
+    }
+    /*the handlers of an identifier shared with other filters can not be told apart any more*/
+    auto shared{references[filterId->second] > 1U};
+    store(filterId->second,
+          shared_ptr<Slot const>(shared ? new Slot{true, handlers_t()} : new Slot{false, move(handlers)}));
+}
+
+SubscriptionIdTable::DispatchResult
+SubscriptionIdTable::Dispatch(IMqttMessage const& msg) const
+{
+    if (msg.subscriptionIds.empty()) {
+        return DispatchResult::UNKNOWN;
+    }
+    auto snapshot{atomic_load(&chunks)};
+    for (auto id : msg.subscriptionIds) {
+        auto slot{load(*snapshot, id)};
+        if (!slot || slot->useRouter) {
+            return DispatchResult::UNKNOWN;
+        }
+    }
+    auto handled{false};
+    for (auto id : msg.subscriptionIds) {
+        /*a slot released in the meantime belongs to a subscription, that is gone*/
+        auto slot{load(*snapshot, id)};
+        if (!slot) {
+            continue;
+        }
+        for (auto const& handler : slot->handlers) {
+            handler(msg);
+            handled = true;
+        }
+    }
+    return handled ? DispatchResult::HANDLED : DispatchResult::NO_HANDLER;
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,82 @@
+/**
+ * @file SubscriptionIdTable.h
+ * @author Timo Lange
+ * @brief Class definition for dispatching messages by MQTTv5 subscription identifiers
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/*Assigns MQTTv5 subscription identifiers to SUBSCRIBE packets. The broker reports the identifiers of all matching
+ * subscriptions with each message, which allows to look up the handlers by index instead of matching the topic. Slots
+ * are kept in chunks and swapped atomically one by one, only the list of chunks is copied when it grows. Readers never
+ * block.*/
+class SubscriptionIdTable final {
+public:
+    using handlers_t = std::vector<IMqttClient::messageHandler_t>;
+
+    enum class DispatchResult {
+        UNKNOWN,    /*!< the message has to be routed by topic */
+        NO_HANDLER, /*!< there is no handler for the message */
+        HANDLED     /*!< the message was handed over to its handlers */
+    };
+
+    static constexpr std::uint32_t maxId{268435455U}; /*maximum of a variable byte integer*/
+
+private:
+    struct Slot final {
+        bool       useRouter; /*the identifier is shared by filters with different handlers*/
+        handlers_t handlers;
+    };
+    static constexpr std::uint32_t chunkSize{1024U};
+    /*the slots are only accessed via std::atomic_load and std::atomic_store*/
+    using chunk_t  = std::array<std::shared_ptr<Slot const>, chunkSize>;
+    using chunks_t = std::vector<std::shared_ptr<chunk_t>>;
+
+    std::mutex                                     tableMutex;
+    std::shared_ptr<chunks_t const>                chunks; /*only accessed via std::atomic_load and std::atomic_store*/
+    std::unordered_map<std::string, std::uint32_t> filterIds;
+    std::vector<unsigned>                          references;
+    /*released identifiers are reused oldest first, to not confuse them with messages still in flight*/
+    std::deque<std::uint32_t> freeIds;
+
+    void                        release(std::uint32_t);
+    void                        store(std::uint32_t, std::shared_ptr<Slot const>);
+    std::shared_ptr<Slot const> load(chunks_t const&, std::uint32_t) const noexcept;
+
+public:
+    SubscriptionIdTable(void);
+
+    /*returns the identifier for the filters of one SUBSCRIBE, 0 if all identifiers are in use*/
+    std::uint32_t  Assign(std::vector<std::string> const& filters, bool useRouter, handlers_t);
+    void           Release(std::string const& filter);
+    /*replaces the handlers of a filter subscribed already, e.g. when another handler shares the subscription*/
+    void           SetHandlers(std::string const& filter, handlers_t);
+    DispatchResult Dispatch(IMqttMessage const&) const;
+};
+}  // namespace i_mqtt_client
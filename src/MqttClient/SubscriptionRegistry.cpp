@@ -0,0 +1,241 @@
+/**
+ * @file SubscriptionRegistry.cpp
+ * @author Timo Lange
+ * @brief Implementation of restoring subscriptions after a reconnect
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "SubscriptionRegistry.h"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+SubscriptionRegistry::SubscriptionRegistry(size_t size, subscribeFunc_t func)
+  : batchSize(size)
+  , subscribeFunc(move(func))
+{
+    if (!batchSize) {
+        throw runtime_error("restoreBatchSize must not be 0");
+    }
+}
+
+void
+SubscriptionRegistry::Subscribing(void)
+{
+    lock_guard<mutex> lock(registryMutex);
+    submitting++;
+}
+
+void
+SubscriptionRegistry::Add(vector<IMqttClient::TopicSubscription> const& subscriptions,
+                          uint32_t                                      subscriptionId,
+                          int                                           token,
+                          bool                                          success)
+{
+    lock_guard<mutex> lock(registryMutex);
+    submitting--;
+    if (success) {
+        vector<string> topics;
+        for (auto const& subscription : subscriptions) {
+            entries[subscription.topic] = Entry{subscription, subscriptionId};
+            topics.push_back(subscription.topic);
+        }
+        /*the SUBACK may have overtaken us, while the token was not known yet*/
+        auto early{earlyCompletions.find(token)};
+        if (early != earlyCompletions.end()) {
+            removeFailed(topics, early->second);
+            earlyCompletions.erase(early);
+        }
+        else {
+            subscribeTokens[token] = move(topics);
+        }
+    }
+    if (!submitting) {
+        earlyCompletions.clear();
+    }
+}
+
+void
+SubscriptionRegistry::Remove(string const& topic)
+{
+    lock_guard<mutex> lock(registryMutex);
+    entries.erase(topic);
+}
+
+size_t
+SubscriptionRegistry::Connected(bool sessionPresent)
+{
+    vector<pair<vector<IMqttClient::TopicSubscription>, uint32_t>> batches;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        connectedAt       = clock_t::now();
+        messagesAtConnect = messages;
+        if (entries.empty() || sessionPresent) {
+            if (!entries.empty()) {
+                status.skipped++;
+            }
+            recovering = false;
+            return 0U;
+        }
+        /*filters subscribed together share their subscription identifier, which has to be kept*/
+        map<uint32_t, vector<IMqttClient::TopicSubscription>> byId;
+        for (auto const& entry : entries) {
+            byId[entry.second.subscriptionId].push_back(entry.second.subscription);
+        }
+        for (auto const& group : byId) {
+            for (size_t first{0U}; first < group.second.size(); first += batchSize) {
+                auto last{min(first + batchSize, group.second.size())};
+                batches.emplace_back(vector<IMqttClient::TopicSubscription>(group.second.begin() + first,
+                                                                            group.second.begin() + last),
+                                     group.first);
+            }
+        }
+        status.restores++;
+        submitting++;
+    }
+    /*no lock while submitting, as the MQTT library may report SUBACKs before returning*/
+    vector<pair<int, vector<string>>> submitted;
+    size_t                            restoring{0U};
+    size_t                            failed{0U};
+    for (auto const& batch : batches) {
+        int token{-1};
+        if (ReasonCode::OKAY == subscribeFunc(batch.first, batch.second, &token)) {
+            vector<string> topics;
+            for (auto const& subscription : batch.first) {
+                topics.push_back(subscription.topic);
+            }
+            submitted.emplace_back(token, move(topics));
+            restoring += batch.first.size();
+        }
+        else {
+            failed += batch.first.size();
+        }
+    }
+    lock_guard<mutex> lock(registryMutex);
+    submitting--;
+    status.failedFilters += failed;
+    for (auto& token : submitted) {
+        restoreTokens[token.first] = move(token.second);
+        /*the SUBACK may have overtaken us, while the token was not known yet*/
+        auto early{earlyCompletions.find(token.first)};
+        if (early != earlyCompletions.end()) {
+            completeRestore(token.first, early->second);
+            earlyCompletions.erase(early);
+        }
+    }
+    if (!submitting) {
+        earlyCompletions.clear();
+    }
+    if (restoreTokens.empty()) {
+        finishRecovery();
+    }
+    return restoring;
+}
+
+void
+SubscriptionRegistry::Disconnected(void)
+{
+    lock_guard<mutex> lock(registryMutex);
+    /*subscriptions not acknowledged yet are gone with the connection*/
+    subscribeTokens.clear();
+    restoreTokens.clear();
+    if (recovering) {
+        /*the gap lasts until the subscriptions are restored, even if the connection was lost again in between*/
+        return;
+    }
+    recovering     = true;
+    disconnectedAt = clock_t::now();
+    auto connected{duration_cast<duration<double>>(disconnectedAt - connectedAt).count()};
+    messageRate = connected > 0.0 ? static_cast<double>(messages - messagesAtConnect) / connected : 0.0;
+}
+
+void
+SubscriptionRegistry::MessageReceived(void) noexcept
+{
+    messages++;
+}
+
+void
+SubscriptionRegistry::Completed(int token, vector<Mqtt5ReasonCode> const& rcs)
+{
+    lock_guard<mutex> lock(registryMutex);
+    auto              subscribed{subscribeTokens.find(token)};
+    if (subscribed != subscribeTokens.end()) {
+        removeFailed(subscribed->second, rcs);
+        subscribeTokens.erase(subscribed);
+    }
+    else if (restoreTokens.count(token)) {
+        completeRestore(token, rcs);
+        if (restoreTokens.empty() && !submitting) {
+            finishRecovery();
+        }
+    }
+    else if (submitting) {
+        earlyCompletions[token] = rcs;
+    }
+}
+
+size_t
+SubscriptionRegistry::removeFailed(vector<string> const& topics, vector<Mqtt5ReasonCode> const& rcs)
+{
+    size_t failed{0U};
+    for (size_t i{0U}; i < topics.size(); i++) {
+        /*a failure might be reported with a single reason code for all topic filters*/
+        auto rc{i < rcs.size() ? rcs[i] : (rcs.empty() ? Mqtt5ReasonCode::UNSPECIFIED_ERROR : rcs.back())};
+        if (rc >= Mqtt5ReasonCode::UNSPECIFIED_ERROR) {
+            entries.erase(topics[i]);
+            failed++;
+        }
+    }
+    return failed;
+}
+
+void
+SubscriptionRegistry::completeRestore(int token, vector<Mqtt5ReasonCode> const& rcs)
+{
+    auto restore{restoreTokens.find(token)};
+    auto failed{removeFailed(restore->second, rcs)};
+    status.restoredFilters += restore->second.size() - failed;
+    status.failedFilters += failed;
+    restoreTokens.erase(restore);
+}
+
+void
+SubscriptionRegistry::finishRecovery(void)
+{
+    if (!recovering) {
+        return;
+    }
+    recovering = false;
+    auto gap{clock_t::now() - disconnectedAt};
+    status.lastGap = duration_cast<milliseconds>(gap);
+    status.estimatedMissedMessages += static_cast<uint64_t>(llround(messageRate * duration<double>(gap).count()));
+}
+
+IMqttClient::SubscriptionRestoreStatus
+SubscriptionRegistry::GetStatus(void) const
+{
+    lock_guard<mutex> lock(registryMutex);
+    auto              current{status};
+    current.subscriptions = entries.size();
+    current.pending       = restoreTokens.size();
+    return current;
+}
+}  // namespace i_mqtt_client
@@ -0,0 +1,88 @@
+/**
+ * @file SubscriptionRegistry.h
+ * @author Timo Lange
+ * @brief Class definition for restoring subscriptions after a reconnect
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/*Keeps the active subscriptions of a client, in order to restore them on CONNACK, if the broker did not keep the
+ * session. All SUBSCRIBE packets of a restore are submitted at once, without waiting for the SUBACKs in between.
+ * Topic filters rejected by the broker are removed, so they are not retried on every reconnect.*/
+class SubscriptionRegistry final {
+public:
+    using clock_t         = std::chrono::steady_clock;
+    using subscribeFunc_t = std::function<ReasonCode(std::vector<IMqttClient::TopicSubscription> const&,
+                                                     std::uint32_t subscriptionId,
+                                                     int*)>;
+
+private:
+    struct Entry final {
+        IMqttClient::TopicSubscription subscription;
+        std::uint32_t                  subscriptionId;
+    };
+
+    size_t const          batchSize;
+    subscribeFunc_t const subscribeFunc;
+
+    mutable std::mutex                                    registryMutex;
+    std::map<std::string, Entry>                          entries;
+    std::unordered_map<int, std::vector<std::string>>     subscribeTokens; /*token to topic filters*/
+    std::unordered_map<int, std::vector<std::string>>     restoreTokens;
+    std::unordered_map<int, std::vector<Mqtt5ReasonCode>> earlyCompletions;
+    unsigned                                              submitting{0U};
+    bool                                                  recovering{false};
+    clock_t::time_point                                   connectedAt;
+    clock_t::time_point                                   disconnectedAt;
+    std::uint64_t                                         messagesAtConnect{0U};
+    double                                                messageRate{0.0};
+    IMqttClient::SubscriptionRestoreStatus                status;
+    std::atomic<std::uint64_t>                            messages{0U};
+
+    size_t removeFailed(std::vector<std::string> const&, std::vector<Mqtt5ReasonCode> const&);
+    void   completeRestore(int token, std::vector<Mqtt5ReasonCode> const&);
+    void finishRecovery(void);
+
+public:
+    SubscriptionRegistry(size_t batchSize, subscribeFunc_t);
+
+    /*to be called right before handing a SUBSCRIBE over to the MQTT library*/
+    void Subscribing(void);
+    /*to be called once the MQTT library returned, also if it failed*/
+    void Add(std::vector<IMqttClient::TopicSubscription> const&, std::uint32_t subscriptionId, int token, bool success);
+    void Remove(std::string const&);
+    /*to be called on every successful CONNACK, returns the number of topic filters being restored*/
+    size_t Connected(bool sessionPresent);
+    void   Disconnected(void);
+    void   MessageReceived(void) noexcept;
+    /*to be called with the results of every SUBACK, tokens not belonging to a known SUBSCRIBE are ignored*/
+    void                                   Completed(int token, std::vector<Mqtt5ReasonCode> const&);
+    IMqttClient::SubscriptionRestoreStatus GetStatus(void) const;
+};
+}  // namespace i_mqtt_client
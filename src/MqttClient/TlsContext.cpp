@@ -0,0 +1,223 @@
+/**
+ * @file TlsContext.cpp
+ * @author Timo Lange
+ * @brief Implementation of a TLS context shared by many clients, with session resumption
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "TlsContext.h"
+
+#include <openssl/err.h>
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace i_mqtt_client {
+TlsContext::TlsContext(Parameters const& params)
+  : sessionCacheSize(params.sessionCacheSize)
+{
+    ctx = SSL_CTX_new(TLS_client_method());
+    if (nullptr == ctx) {
+        throw runtime_error("Was not able to create TLS context: " + lastError());
+    }
+    try {
+        configure(params);
+    }
+    catch (...) {
+        SSL_CTX_free(ctx);
+        throw;
+    }
+}
+
+TlsContext::~TlsContext() noexcept
+{
+    /*connections still referencing the context must not call back into this object*/
+    SSL_CTX_set_ex_data(ctx, exIndex(), nullptr);
+    for (auto& entry : sessions) {
+        SSL_SESSION_free(entry.second.session);
+    }
+    SSL_CTX_free(ctx);
+}
+
+int
+TlsContext::exIndex(void)
+{
+    static int const index{SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr)};
+    return index;
+}
+
+string
+TlsContext::lastError(void)
+{
+    /*the queue of the thread may still hold errors of other connections*/
+    char buf[256];
+    ERR_error_string_n(ERR_peek_last_error(), buf, sizeof(buf));
+    ERR_clear_error();
+    return string(buf);
+}
+
+string
+TlsContext::serverName(SSL const* ssl)
+{
+    auto name{SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name)};
+    return nullptr == name ? string() : string(name);
+}
+
+TlsContext*
+TlsContext::fromSsl(SSL const* ssl)
+{
+    return static_cast<TlsContext*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), exIndex()));
+}
+
+void
+TlsContext::configure(Parameters const& params)
+{
+    if (exIndex() < 0 || 1 != SSL_CTX_set_ex_data(ctx, exIndex(), this)) {
+        throw runtime_error("Was not able to attach TLS context: " + lastError());
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+    if (!params.caFilePath.empty() || !params.caDirPath.empty()) {
+        if (1 != SSL_CTX_load_verify_locations(ctx,
+                                               params.caFilePath.empty() ? nullptr : params.caFilePath.c_str(),
+                                               params.caDirPath.empty() ? nullptr : params.caDirPath.c_str())) {
+            throw runtime_error("Was not able to load CA certificates: " + lastError());
+        }
+    }
+    else if (1 != SSL_CTX_set_default_verify_paths(ctx)) {
+        throw runtime_error("Was not able to load default CA certificates: " + lastError());
+    }
+    if (!params.clientCertFilePath.empty() &&
+        1 != SSL_CTX_use_certificate_chain_file(ctx, params.clientCertFilePath.c_str())) {
+        throw runtime_error("Was not able to load client certificate: " + lastError());
+    }
+    if (!params.privateKeyFilePath.empty()) {
+        /*the password is only needed while loading the key, so it is not kept*/
+        SSL_CTX_set_default_passwd_cb_userdata(ctx, const_cast<string*>(&params.privateKeyPassword));
+        SSL_CTX_set_default_passwd_cb(ctx, [](char* buf, int size, int, void* pPassword) -> int {
+            return static_cast<int>(static_cast<string*>(pPassword)->copy(buf, static_cast<size_t>(size)));
+        });
+        auto rc{SSL_CTX_use_PrivateKey_file(ctx, params.privateKeyFilePath.c_str(), SSL_FILETYPE_PEM)};
+        SSL_CTX_set_default_passwd_cb(ctx, nullptr);
+        SSL_CTX_set_default_passwd_cb_userdata(ctx, nullptr);
+        if (1 != rc || 1 != SSL_CTX_check_private_key(ctx)) {
+            throw runtime_error("Was not able to load private key: " + lastError());
+        }
+    }
+    if (sessionCacheSize > 0U) {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(ctx, [](SSL* ssl, SSL_SESSION* session) -> int {
+            auto pThis{fromSsl(ssl)};
+            return nullptr == pThis ? 0 : pThis->onNewSession(ssl, session);
+        });
+    }
+    SSL_CTX_set_info_callback(ctx, [](SSL const* ssl, int where, int) {
+        auto pThis{fromSsl(ssl)};
+        if (nullptr != pThis) {
+            pThis->onInfo(ssl, where);
+        }
+    });
+}
+
+void
+TlsContext::prepare(SSL* ssl)
+{
+    auto name{serverName(ssl)};
+    if (name.empty()) {
+        return;
+    }
+    /*clients do not verify the host name on their own, when using a context they did not set up*/
+    if (1 != SSL_set1_host(ssl, name.c_str())) {
+        return;
+    }
+    if (0U == sessionCacheSize) {
+        return;
+    }
+    lock_guard<mutex> lock(cacheMutex);
+    auto              it{sessions.find(name)};
+    if (sessions.end() != it) {
+        /*takes its own reference of the session*/
+        SSL_set_session(ssl, it->second.session);
+        lru.splice(lru.begin(), lru, it->second.lruPos);
+    }
+}
+
+int
+TlsContext::onNewSession(SSL* ssl, SSL_SESSION* session)
+{
+    auto name{serverName(ssl)};
+    if (name.empty()) {
+        return 0;
+    }
+    lock_guard<mutex> lock(cacheMutex);
+    auto              it{sessions.find(name)};
+    if (sessions.end() != it) {
+        SSL_SESSION_free(it->second.session);
+        it->second.session = session;
+        lru.splice(lru.begin(), lru, it->second.lruPos);
+    }
+    else {
+        lru.push_front(name);
+        sessions.emplace(name, CachedSession{session, lru.begin()});
+        if (sessions.size() > sessionCacheSize) {
+            auto evicted{sessions.find(lru.back())};
+            SSL_SESSION_free(evicted->second.session);
+            sessions.erase(evicted);
+            lru.pop_back();
+        }
+    }
+    /*the reference passed in is kept by the cache*/
+    return 1;
+}
+
+void
+TlsContext::onInfo(SSL const* ssl, int where)
+{
+    /*a new connection has no session yet, renegotiations and post-handshake messages are skipped*/
+    if ((where & SSL_CB_HANDSHAKE_START) && nullptr == SSL_get_session(ssl)) {
+        prepare(const_cast<SSL*>(ssl));
+    }
+    if (where & SSL_CB_HANDSHAKE_DONE) {
+        handshakes++;
+        if (SSL_session_reused(const_cast<SSL*>(ssl))) {
+            resumed++;
+        }
+    }
+}
+
+void*
+TlsContext::NativeHandle(void) const noexcept
+{
+    return ctx;
+}
+
+IMqttTlsContext::Status
+TlsContext::GetStatus(void) const
+{
+    Status status;
+    status.handshakes = handshakes;
+    status.resumed    = resumed;
+    lock_guard<mutex> lock(cacheMutex);
+    status.cachedSessions = sessions.size();
+    return status;
+}
+
+shared_ptr<IMqttTlsContext>
+MqttTlsContextFactory::Create(IMqttTlsContext::Parameters const& params)
+{
+    return make_shared<TlsContext>(params);
+}
+}  // namespace i_mqtt_client
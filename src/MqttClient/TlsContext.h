@@ -0,0 +1,70 @@
+/**
+ * @file TlsContext.h
+ * @author Timo Lange
+ * @brief Class definition for the shared TLS context
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <openssl/ssl.h>
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "IMqttTlsContext.h"
+
+namespace i_mqtt_client {
+/*Wraps an OpenSSL client context. Sessions are cached outside of OpenSSL, keyed by the server name (SNI) of the
+ * connection, as the internal cache of OpenSSL is only used by servers. When the handshake of a new connection
+ * starts, the server name is set as host to verify and the cached session is handed to the connection.*/
+class TlsContext final : public IMqttTlsContext {
+private:
+    struct CachedSession final {
+        SSL_SESSION*                     session;
+        std::list<std::string>::iterator lruPos;
+    };
+
+    SSL_CTX*     ctx{nullptr};
+    size_t const sessionCacheSize;
+
+    mutable std::mutex                             cacheMutex;
+    std::unordered_map<std::string, CachedSession> sessions;
+    std::list<std::string>                         lru; /*most recently used first*/
+    std::atomic<std::uint64_t>                     handshakes{0U};
+    std::atomic<std::uint64_t>                     resumed{0U};
+
+    static int         exIndex(void);
+    static std::string lastError(void);
+    static std::string serverName(SSL const*);
+    static TlsContext* fromSsl(SSL const*);
+
+    void configure(Parameters const&);
+    void prepare(SSL*);
+    int  onNewSession(SSL*, SSL_SESSION*);
+    void onInfo(SSL const*, int);
+
+public:
+    explicit TlsContext(Parameters const&);
+    ~TlsContext() noexcept;
+
+    void*  NativeHandle(void) const noexcept override;
+    Status GetStatus(void) const override;
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,90 @@
+/**
+ * @file TokenBucket.cpp
+ * @author Timo Lange
+ * @brief Implementation of a token bucket
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "TokenBucket.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+TokenBucket::TokenBucket(double r, unsigned b)
+  : rate(r)
+  , burst(static_cast<double>(b))
+  , tokens(static_cast<double>(b))
+  , lastRefill(clock_t::now())
+{
+    if (rate < 0.0 || (rate > 0.0 && b == 0U)) {
+        throw runtime_error("token bucket not properly set");
+    }
+}
+
+void
+TokenBucket::refill(clock_t::time_point now)
+{
+    if (now > lastRefill) {
+        tokens     = min(burst, tokens + duration<double>(now - lastRefill).count() * rate);
+        lastRefill = now;
+    }
+}
+
+bool
+TokenBucket::IsEnabled(void) const noexcept
+{
+    return rate > 0.0;
+}
+
+bool
+TokenBucket::HasToken(clock_t::time_point now)
+{
+    if (!IsEnabled()) {
+        return true;
+    }
+    refill(now);
+    return tokens >= 1.0;
+}
+
+void
+TokenBucket::Take(void) noexcept
+{
+    if (IsEnabled()) {
+        tokens -= 1.0;
+    }
+}
+
+double
+TokenBucket::Tokens(clock_t::time_point now)
+{
+    refill(now);
+    return tokens;
+}
+
+microseconds
+TokenBucket::TimeUntilToken(clock_t::time_point now)
+{
+    if (HasToken(now)) {
+        return microseconds(0);
+    }
+    /*round up, to not wake up too early*/
+    return microseconds(static_cast<microseconds::rep>((1.0 - tokens) / rate * 1e6) + 1);
+}
+}  // namespace i_mqtt_client
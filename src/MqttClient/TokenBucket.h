@@ -0,0 +1,48 @@
+/**
+ * @file TokenBucket.h
+ * @author Timo Lange
+ * @brief Class definition for a token bucket
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+
+namespace i_mqtt_client {
+/*Not thread safe, users have to synchronize access*/
+class TokenBucket final {
+public:
+    using clock_t = std::chrono::steady_clock;
+
+private:
+    double              rate;
+    double              burst;
+    double              tokens;
+    clock_t::time_point lastRefill;
+
+    void refill(clock_t::time_point);
+
+public:
+    TokenBucket(double rate, unsigned burst);
+
+    bool                      IsEnabled(void) const noexcept;
+    bool                      HasToken(clock_t::time_point);
+    void                      Take(void) noexcept;
+    double                    Tokens(clock_t::time_point);
+    std::chrono::microseconds TimeUntilToken(clock_t::time_point);
+};
+}  // namespace i_mqtt_client
@@ -0,0 +1,111 @@
+/**
+ * @file TokenWaiters.cpp
+ * @author Timo Lange
+ * @brief Implementation for waiting on the completion of tokens
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "TokenWaiters.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace i_mqtt_client {
+Mqtt5ReasonCode
+TokenWaiters::Wait(submitFunc_t const& submit, bool waitForAck, milliseconds timeout, ReasonCode* pRc)
+{
+    {
+        lock_guard<mutex> lock(waitersMutex);
+        submitting++;
+        active++;
+    }
+    int  token{-1};
+    auto status{submit(&token)};
+    auto mqttRc{Mqtt5ReasonCode::SUCCESS};
+    auto wait{false};
+    auto result{future<Mqtt5ReasonCode>()};
+    auto key{slotKey_t(token, 0U)};
+    {
+        lock_guard<mutex> lock(waitersMutex);
+        submitting--;
+        /*the completion may have overtaken us, while the token was not known yet*/
+        auto early{earlyCompletions.find(token)};
+        /*a negative token means there is nothing to wait for (e.g. message was queued)*/
+        if (ReasonCode::OKAY == status && waitForAck && token >= 0) {
+            if (early != earlyCompletions.end()) {
+                mqttRc = early->second;
+            }
+            else {
+                key    = slotKey_t(token, nextSequence++);
+                result = slots[key].get_future();
+                wait   = true;
+            }
+        }
+        if (early != earlyCompletions.end()) {
+            earlyCompletions.erase(early);
+        }
+        if (!submitting) {
+            earlyCompletions.clear();
+        }
+        if (!wait) {
+            active--;
+        }
+    }
+    if (ReasonCode::OKAY != status) {
+        if (pRc) {
+            *pRc = status;
+        }
+        return Mqtt5ReasonCode::UNSPECIFIED_ERROR;
+    }
+    if (wait && result.wait_for(timeout) != future_status::ready) {
+        lock_guard<mutex> lock(waitersMutex);
+        if (slots.erase(key)) {
+            active--;
+            if (pRc) {
+                *pRc = ReasonCode::ERROR_TIMEOUT;
+            }
+            return Mqtt5ReasonCode::UNSPECIFIED_ERROR;
+        }
+        /*completed while timing out, result is ready*/
+    }
+    if (wait) {
+        mqttRc = result.get();
+    }
+    if (pRc) {
+        *pRc = ReasonCode::OKAY;
+    }
+    return mqttRc;
+}
+
+void
+TokenWaiters::Complete(int token, Mqtt5ReasonCode mqttRc) const
+{
+    if (!active) {
+        return;
+    }
+    lock_guard<mutex> lock(waitersMutex);
+    /*the longest waiting one, if the token is waited for more than once*/
+    auto slot{slots.lower_bound(slotKey_t(token, 0U))};
+    if (slot != slots.end() && slot->first.first == token) {
+        slot->second.set_value(mqttRc);
+        slots.erase(slot);
+        active--;
+    }
+    else if (submitting) {
+        earlyCompletions[token] = mqttRc;
+    }
+}
+}  // namespace i_mqtt_client
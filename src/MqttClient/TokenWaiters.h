@@ -0,0 +1,58 @@
+/**
+ * @file TokenWaiters.h
+ * @author Timo Lange
+ * @brief Class definition for waiting on the completion of tokens
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "IMqttClientDefines.h"
+
+namespace i_mqtt_client {
+/*Lets callers block until the MQTT library reports the completion of a token. Each waiter owns its own slot, so a
+ * completion only wakes up the one waiter it belongs to. Slots are keyed by token and a sequence number, as a token
+ * reused by the MQTT library may be waited for twice, such waiters are completed in the order they started.*/
+class TokenWaiters final {
+public:
+    using submitFunc_t = std::function<ReasonCode(int*)>;
+
+private:
+    using slotKey_t = std::pair<int, std::uint64_t>;
+
+    mutable std::mutex                                         waitersMutex;
+    mutable std::map<slotKey_t, std::promise<Mqtt5ReasonCode>> slots;
+    mutable std::unordered_map<int, Mqtt5ReasonCode>           earlyCompletions;
+    mutable unsigned                                           submitting{0U};
+    std::uint64_t                                              nextSequence{0U};
+    /*number of slots and submissions in progress, allows completing tokens without locking, if nobody waits*/
+    mutable std::atomic_uint active{0U};
+
+public:
+    Mqtt5ReasonCode Wait(submitFunc_t const&, bool waitForAck, std::chrono::milliseconds, ReasonCode*);
+    void            Complete(int token, Mqtt5ReasonCode) const;
+};
+}  // namespace i_mqtt_client
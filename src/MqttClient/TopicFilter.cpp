@@ -0,0 +1,87 @@
+/**
+ * @file TopicFilter.cpp
+ * @author Timo Lange
+ * @brief Implementation of helper functions for MQTT topic filters
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "TopicFilter.h"
+
+using namespace std;
+
+namespace i_mqtt_client {
+bool
+TopicMatchesFilter(string const& filter, string const& topic) noexcept
+{
+    /*topics starting with '$' are not matched by filters starting with a wildcard*/
+    if (!topic.empty() && topic[0] == '$' && !filter.empty() && (filter[0] == '+' || filter[0] == '#')) {
+        return false;
+    }
+    size_t f{0U};
+    size_t t{0U};
+    while (f < filter.size()) {
+        if (filter[f] == '#') {
+            return true;
+        }
+        if (filter[f] == '+') {
+            /*skip one topic level*/
+            while (t < topic.size() && topic[t] != '/') {
+                t++;
+            }
+            f++;
+        }
+        else {
+            if (t >= topic.size() || filter[f] != topic[t]) {
+                /*"a/#" also matches the parent level "a"*/
+                return t >= topic.size() && filter.compare(f, string::npos, "/#") == 0;
+            }
+            f++;
+            t++;
+        }
+    }
+    return t == topic.size();
+}
+
+vector<string>
+SplitTopic(string const& topic)
+{
+    vector<string> levels;
+    size_t         begin{0U};
+    while (true) {
+        auto end{topic.find('/', begin)};
+        if (end == string::npos) {
+            levels.push_back(topic.substr(begin));
+            return levels;
+        }
+        levels.push_back(topic.substr(begin, end - begin));
+        begin = end + 1U;
+    }
+}
+
+string
+StripSharePrefix(string const& filter)
+{
+    static string const sharePrefix{"$share/"};
+    if (filter.compare(0U, sharePrefix.size(), sharePrefix) != 0) {
+        return filter;
+    }
+    auto groupEnd{filter.find('/', sharePrefix.size())};
+    if (groupEnd == string::npos) {
+        return filter;
+    }
+    return filter.substr(groupEnd + 1U);
+}
+}  // namespace i_mqtt_client
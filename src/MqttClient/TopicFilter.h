@@ -0,0 +1,33 @@
+/**
+ * @file TopicFilter.h
+ * @author Timo Lange
+ * @brief Helper functions for MQTT topic filters
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace i_mqtt_client {
+/*Returns true, if topic matches the MQTT topic filter (including '+' and '#' wildcards)*/
+bool TopicMatchesFilter(std::string const& filter, std::string const& topic) noexcept;
+/*Splits a topic or topic filter into its levels, "a//b" results in "a", "", "b"*/
+std::vector<std::string> SplitTopic(std::string const&);
+/*Returns the topic filter without a leading "$share/<group>/", the filter itself, if it is no shared subscription*/
+std::string StripSharePrefix(std::string const& filter);
+}  // namespace i_mqtt_client
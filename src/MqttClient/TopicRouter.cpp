@@ -0,0 +1,253 @@
+/**
+ * @file TopicRouter.cpp
+ * @author Timo Lange
+ * @brief Implementation for routing messages to per subscription handlers
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "TopicRouter.h"
+
+#include <algorithm>
+
+#include "TopicFilter.h"
+
+using namespace std;
+
+namespace i_mqtt_client {
+size_t
+TopicRouter::hashLevel(string const& topic, size_t pos, size_t len) noexcept
+{
+    /*FNV-1a, std::hash would need a copy of the level*/
+    uint64_t hash{14695981039346656037ULL};
+    for (auto i{pos}; i < pos + len; i++) {
+        hash = (hash ^ static_cast<unsigned char>(topic[i])) * 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+}
+
+int
+TopicRouter::compare(Child const& child, size_t hash, string const& topic, size_t pos, size_t len) noexcept
+{
+    if (hash != child.hash) {
+        return hash < child.hash ? -1 : 1;
+    }
+    return topic.compare(pos, len, child.level);
+}
+
+TopicRouter::Child const*
+TopicRouter::find(spChild_t const& children, string const& topic, size_t pos, size_t len) noexcept
+{
+    auto hash{hashLevel(topic, pos, len)};
+    auto child{children.get()};
+    while (child) {
+        auto order{compare(*child, hash, topic, pos, len)};
+        if (!order) {
+            return child;
+        }
+        child = order < 0 ? child->left.get() : child->right.get();
+    }
+    return nullptr;
+}
+
+TopicRouter::spChild_t
+TopicRouter::removeMin(spChild_t const& tree, spChild_t& min)
+{
+    if (!tree->left) {
+        min = tree;
+        return tree->right;
+    }
+    auto copy{make_shared<Child>(*tree)};
+    copy->left = removeMin(tree->left, min);
+    return copy;
+}
+
+TopicRouter::spChild_t
+TopicRouter::setChild(spChild_t const& tree, size_t hash, string const& level, spNode_t node)
+{
+    if (!tree) {
+        return node ? make_shared<Child const>(Child{hash, level, move(node), nullptr, nullptr}) : nullptr;
+    }
+    auto order{compare(*tree, hash, level, 0U, level.size())};
+    if (order || node) {
+        auto copy{make_shared<Child>(*tree)};
+        if (order < 0) {
+            copy->left = setChild(tree->left, hash, level, move(node));
+        }
+        else if (order > 0) {
+            copy->right = setChild(tree->right, hash, level, move(node));
+        }
+        else {
+            copy->node = move(node);
+        }
+        return copy;
+    }
+    /*remove the child, its smallest successor takes its place*/
+    if (!tree->left || !tree->right) {
+        return tree->left ? tree->left : tree->right;
+    }
+    spChild_t min;
+    auto      right{removeMin(tree->right, min)};
+    auto      copy{make_shared<Child>(*min)};
+    copy->left  = tree->left;
+    copy->right = move(right);
+    return copy;
+}
+
+TopicRouter::spNode_t
+TopicRouter::insert(spNode_t const& node, vector<string> const& levels, size_t level, Entry const& entry)
+{
+    auto copy{node ? make_shared<Node>(*node) : make_shared<Node>()};
+    if (level == levels.size()) {
+        copy->entries.push_back(entry);
+    }
+    else {
+        auto const& name{levels[level]};
+        auto        child{find(copy->children, name, 0U, name.size())};
+        auto        inserted{insert(child ? child->node : nullptr, levels, level + 1U, entry)};
+        copy->children = setChild(copy->children, hashLevel(name, 0U, name.size()), name, move(inserted));
+    }
+    return copy;
+}
+
+TopicRouter::spNode_t
+TopicRouter::remove(spNode_t const& node, vector<string> const& levels, size_t level, uint64_t id)
+{
+    if (!node) {
+        return node;
+    }
+    auto copy{make_shared<Node>(*node)};
+    if (level == levels.size()) {
+        copy->entries.erase(remove_if(copy->entries.begin(),
+                                      copy->entries.end(),
+                                      [id](Entry const& entry) { return allEntries == id || entry.id == id; }),
+                            copy->entries.end());
+    }
+    else {
+        auto const& name{levels[level]};
+        auto        child{find(copy->children, name, 0U, name.size())};
+        if (!child) {
+            return node;
+        }
+        /*a pruned branch removes the child*/
+        copy->children = setChild(
+            copy->children, hashLevel(name, 0U, name.size()), name, remove(child->node, levels, level + 1U, id));
+    }
+    /*prune empty branches*/
+    if (copy->entries.empty() && !copy->children) {
+        return nullptr;
+    }
+    return copy;
+}
+
+bool
+TopicRouter::route(Node const& node, IMqttMessage const& msg, size_t pos)
+{
+    auto routed{false};
+    auto deliver = [&](Node const& n) {
+        for (auto const& entry : n.entries) {
+            entry.handler(msg);
+            routed = true;
+        }
+    };
+    static string const wildcards{"#+"};
+    auto                multiLevel{find(node.children, wildcards, 0U, 1U)};
+    /*npos once all levels of the topic are consumed*/
+    if (string::npos == pos) {
+        deliver(node);
+        /*"a/#" also matches the parent level "a"*/
+        if (multiLevel) {
+            deliver(*multiLevel->node);
+        }
+        return routed;
+    }
+    auto const& topic{msg.topic};
+    auto        end{topic.find('/', pos)};
+    auto        len{(string::npos == end ? topic.size() : end) - pos};
+    auto        next{string::npos == end ? string::npos : end + 1U};
+    auto        exact{find(node.children, topic, pos, len)};
+    if (exact) {
+        routed = route(*exact->node, msg, next);
+    }
+    /*topics starting with '$' are not matched by filters starting with a wildcard*/
+    if (0U == pos && len && '$' == topic[0]) {
+        return routed;
+    }
+    auto singleLevel{find(node.children, wildcards, 1U, 1U)};
+    if (singleLevel && route(*singleLevel->node, msg, next)) {
+        routed = true;
+    }
+    if (multiLevel) {
+        deliver(*multiLevel->node);
+    }
+    return routed;
+}
+
+uint64_t
+TopicRouter::Add(string const& filter, handler_t handler)
+{
+    lock_guard<mutex> lock(writerMutex);
+    Entry             entry{++nextId, move(handler)};
+    atomic_store(&root, insert(atomic_load(&root), SplitTopic(StripSharePrefix(filter)), 0U, entry));
+    return entry.id;
+}
+
+void
+TopicRouter::remove(string const& filter, uint64_t id)
+{
+    lock_guard<mutex> lock(writerMutex);
+    atomic_store(&root, remove(atomic_load(&root), SplitTopic(StripSharePrefix(filter)), 0U, id));
+}
+
+void
+TopicRouter::Remove(string const& filter)
+{
+    remove(filter, allEntries);
+}
+
+void
+TopicRouter::Remove(string const& filter, uint64_t id)
+{
+    remove(filter, id);
+}
+
+vector<TopicRouter::handler_t>
+TopicRouter::Handlers(string const& filter) const
+{
+    vector<handler_t> handlers;
+    auto              node{atomic_load(&root)};
+    for (auto const& level : SplitTopic(StripSharePrefix(filter))) {
+        if (!node) {
+            return handlers;
+        }
+        auto child{find(node->children, level, 0U, level.size())};
+        node = child ? child->node : nullptr;
+    }
+    if (node) {
+        for (auto const& entry : node->entries) {
+            handlers.push_back(entry.handler);
+        }
+    }
+    return handlers;
+}
+
+bool
+TopicRouter::Route(IMqttMessage const& msg) const
+{
+    /*the snapshot keeps the handlers alive, even if they are removed concurrently*/
+    auto snapshot{atomic_load(&root)};
+    return snapshot && route(*snapshot, msg, 0U);
+}
+}  // namespace i_mqtt_client
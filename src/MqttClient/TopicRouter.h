@@ -0,0 +1,91 @@
+/**
+ * @file TopicRouter.h
+ * @author Timo Lange
+ * @brief Class definition for routing messages to per subscription handlers
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "IMqttClient.h"
+
+namespace i_mqtt_client {
+/*Matches topics against the registered topic filters with a trie of topic levels, so the cost depends on the number
+ * of levels, not on the number of filters. The trie is immutable once published: writers copy the path they modify
+ * and swap the root atomically, readers never block. The children of a trie node are kept in a binary search tree
+ * ordered by the hash of their level, so adding a child only copies the tree nodes on the way to it, not all
+ * siblings.*/
+class TopicRouter final {
+public:
+    using handler_t = IMqttClient::messageHandler_t;
+
+private:
+    struct Entry final {
+        std::uint64_t id;
+        handler_t     handler;
+    };
+    struct Node;
+    using spNode_t = std::shared_ptr<Node const>;
+    struct Child final {
+        std::size_t                  hash;
+        std::string                  level;
+        spNode_t                     node;
+        std::shared_ptr<Child const> left;
+        std::shared_ptr<Child const> right;
+    };
+    using spChild_t = std::shared_ptr<Child const>;
+    struct Node final {
+        spChild_t          children;
+        std::vector<Entry> entries;
+    };
+
+    static constexpr std::uint64_t allEntries{0U};
+
+    std::mutex    writerMutex;
+    spNode_t      root; /*only accessed via std::atomic_load and std::atomic_store*/
+    std::uint64_t nextId{allEntries};
+
+    /*levels are addressed by offset and length into a topic, so routing does not copy any of them*/
+    static std::size_t  hashLevel(std::string const&, size_t pos, size_t len) noexcept;
+    static int          compare(Child const&, std::size_t hash, std::string const&, size_t pos, size_t len) noexcept;
+    static Child const* find(spChild_t const&, std::string const&, size_t pos, size_t len) noexcept;
+    /*returns the tree with the child of the level replaced, a nullptr node removes the child*/
+    static spChild_t setChild(spChild_t const&, std::size_t hash, std::string const&, spNode_t);
+    static spChild_t removeMin(spChild_t const&, spChild_t&);
+    static spNode_t  insert(spNode_t const&, std::vector<std::string> const&, size_t, Entry const&);
+    static spNode_t  remove(spNode_t const&, std::vector<std::string> const&, size_t, std::uint64_t);
+    static bool      route(Node const&, IMqttMessage const&, size_t pos);
+    void             remove(std::string const&, std::uint64_t);
+
+public:
+
+    /*returns an id, that can be used to remove the handler again*/
+    std::uint64_t Add(std::string const& filter, handler_t);
+    /*removes all handlers of the filter*/
+    void Remove(std::string const& filter);
+    void Remove(std::string const& filter, std::uint64_t id);
+    /*returns the handlers installed for exactly this filter*/
+    std::vector<handler_t> Handlers(std::string const& filter) const;
+    /*invokes all handlers matching the topic of the message, returns false if there are none*/
+    bool Route(IMqttMessage const&) const;
+};
+}  // namespace i_mqtt_client
@@ -30,7 +30,9 @@
 #endif
 
 #include "IDispatchQueue.h"
+#include "IMqttAsyncLog.h"
 #include "IMqttClient.h"
+#include "IMqttMetrics.h"
 
 using namespace std;
 using namespace i_mqtt_client;
@@ -48,6 +50,8 @@ private:
     mutable mutex coutMutex;
 
     IMqttClient::InitializeParameters params;
+    unique_ptr<IMqttAsyncLog>         logSink;
+    shared_ptr<IMqttMetrics>          metrics;
     unique_ptr<IMqttClient>           client;
     unique_ptr<IDispatchQueue>        dispatcher;
 
@@ -65,8 +69,12 @@ private:
 
 public:
     Sample(void)
+      /* Create a log sink, that writes the logs from its own thread, in order to not block the MQTT lib on cout */
+      : logSink(MqttAsyncLogFactory::Create(this, bind(&Sample::LogLib, this, _1, _2)))
+      /* Create a metrics registry shared by the client and the dispatcher queue */
+      , metrics(MqttMetricsFactory::Create())
       /* Create a dispatcher queue with logging provided by this and messages handed over to this */
-      : dispatcher(DispatchQueueFactory::Create(this, *this))
+      , dispatcher(DispatchQueueFactory::Create(this, *this, metrics))
     {
         signal(SIGINT, InterruptHandler);
         /*In debug we might want to get more logs from the underlying MQTT lib*/
@@ -77,16 +85,28 @@ public:
 #endif
         /* Set log callback for underlying mqtt lib logs with minimum log level. This has to be done before
          * instantiating the first client object and cannot be done a second time */
-        (void)IMqttClientCallbacks::InitLogMqttLib({bind(&Sample::LogLib, this, _1, _2), mqttLibLogLvl});
+        (void)IMqttClientCallbacks::InitLogMqttLib(
+            {bind(&IMqttAsyncLog::LogLib, logSink.get(), _1, _2), mqttLibLogLvl});
         params.clientId          = "myId";
         params.hostAddress       = "localhost";
         params.cleanSession      = true;
         params.keepAliveInterval = 10;
+        params.metrics           = metrics;
+        /* The MQTT library is chosen per client, take the first one the library was built with */
+        for (auto backend : {IMqttClient::Backend::MOSQUITTO,
+                             IMqttClient::Backend::PAHO,
+                             IMqttClient::Backend::NATIVE,
+                             IMqttClient::Backend::LOOPBACK}) {
+            if (MqttClientFactory::IsAvailable(backend)) {
+                params.backend = backend;
+                break;
+            }
+        }
 #ifdef IMQTT_WITH_TLS
-#ifdef IMQTT_USE_PAHO
-        params.hostAddress           = "ssl://" + params.hostAddress;
-        params.disableDefaultCaStore = true;
-#endif
+        if (IMqttClient::Backend::PAHO == params.backend) {
+            params.hostAddress                = "ssl://" + params.hostAddress;
+            params.paho.disableDefaultCaStore = true;
+        }
 #ifdef IMQTT_EXPERIMENTAL
         params.clientCert = CLIENT_CERT;
         params.privateKey = PRIVATE_KEY;
@@ -99,16 +119,16 @@ public:
 #else
         params.port = 1883;
 #endif
-        /* Finally create the client with received messages handled by dispatcher queue, logs by this, command callbacks
-         * and connection change callbacks not handled (for demo purpose done in two steps)*/
-        client = MqttClientFactory::Create(params, dispatcher.get(), this, nullptr, nullptr);
+        /* Finally create the client with received messages handled by dispatcher queue, logs by the log sink, command
+         * callbacks and connection change callbacks not handled (for demo purpose done in two steps)*/
+        client = MqttClientFactory::Create(params, dispatcher.get(), logSink.get(), nullptr, nullptr);
         /* Also set command and connection callbacks handled by this */
         client->SetCallbacks<IMqttConnectionCallbacks>(this);
         client->SetCallbacks<IMqttCommandCallbacks>(this);
         /* Disable logging */
         client->SetCallbacks<IMqttLogCallbacks>();
         /* Enable logging */
-        client->SetCallbacks<IMqttLogCallbacks>(this);
+        client->SetCallbacks<IMqttLogCallbacks>(logSink.get());
     };
     ~Sample() noexcept = default;
     void Run(void);
@@ -255,6 +275,7 @@ Sample::Run(void)
     /*Some time to allow the unsubscribe happen*/
     sleep_for(milliseconds(500));
     client->DisconnectAsync();
+    Log(LogLevel::INFO, "Metrics:\n" + metrics->ToPrometheus());
 }
 
 void
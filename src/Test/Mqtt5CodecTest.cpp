@@ -0,0 +1,201 @@
+/**
+ * @file Mqtt5CodecTest.cpp
+ * @author Timo Lange
+ * @brief Tests of the MQTTv5 encoding and decoding of the native client
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Native/Mqtt5Codec.h"
+#include "Native/RingBuffer.h"
+
+using namespace std;
+using namespace i_mqtt_client;
+
+/*the ring only receives from sockets, so the bytes are handed over via a pipe*/
+static void
+feed(RingBuffer& ring, vector<uint8_t> const& bytes)
+{
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    ASSERT_EQ(static_cast<ssize_t>(bytes.size()), write(fds[1], bytes.data(), bytes.size()));
+    EXPECT_EQ(static_cast<ssize_t>(bytes.size()), ring.Receive(fds[0]));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/*the encoded packet, without the room left for the fixed header*/
+static vector<uint8_t>
+encode(Mqtt5Writer& writer, uint8_t typeAndFlags)
+{
+    size_t offset{0U};
+    auto   buf{writer.Finish(typeAndFlags, 0U, offset)};
+    return vector<uint8_t>(buf.begin() + static_cast<ptrdiff_t>(offset), buf.end());
+}
+
+TEST(Mqtt5Codec, VarIntRoundTripAtDigitLimits)
+{
+    vector<pair<uint32_t, size_t>> values{
+        {0U, 1U}, {127U, 1U}, {128U, 2U}, {16383U, 2U}, {16384U, 3U}, {2097151U, 3U}, {2097152U, 4U}, {268435455U, 4U}};
+    for (auto const& value : values) {
+        Mqtt5Writer writer;
+        writer.VarInt(value.first);
+        ASSERT_TRUE(writer.Valid());
+        EXPECT_EQ(value.second, writer.Size());
+        auto       packet{encode(writer, 0x30U)};
+        RingBuffer ring(64U);
+        feed(ring, packet);
+        Mqtt5Reader reader(ring, packet.size() - value.second, packet.size());
+        EXPECT_EQ(value.first, reader.VarInt());
+        EXPECT_TRUE(reader.Valid());
+        EXPECT_EQ(0U, reader.Remaining());
+    }
+}
+
+TEST(Mqtt5Codec, VarIntAboveLimitIsRejected)
+{
+    Mqtt5Writer writer;
+    writer.VarInt(268435456U);
+    EXPECT_FALSE(writer.Valid());
+
+    RingBuffer ring(16U);
+    feed(ring, {0xFFU, 0xFFU, 0xFFU, 0xFFU, 0x01U});
+    Mqtt5Reader reader(ring, 0U, ring.Size());
+    (void)reader.VarInt();
+    EXPECT_FALSE(reader.Valid());
+}
+
+TEST(Mqtt5Codec, FixedHeaderIncompleteAndMalformed)
+{
+    uint8_t typeAndFlags{0U};
+    size_t  headerSize{0U};
+    size_t  remaining{0U};
+
+    RingBuffer incomplete(16U);
+    feed(incomplete, {0x30U, 0x80U});
+    EXPECT_EQ(Mqtt5Reader::FixedHeader::INCOMPLETE,
+              Mqtt5Reader::ReadFixedHeader(incomplete, typeAndFlags, headerSize, remaining));
+
+    RingBuffer malformed(16U);
+    feed(malformed, {0x30U, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0x01U});
+    EXPECT_EQ(Mqtt5Reader::FixedHeader::MALFORMED,
+              Mqtt5Reader::ReadFixedHeader(malformed, typeAndFlags, headerSize, remaining));
+}
+
+TEST(Mqtt5Codec, PacketSplitAcrossWrapAround)
+{
+    Mqtt5Writer writer;
+    writer.String("topic/split/across/the/wrap/around");
+    writer.TwoByte(0x1234U);
+    writer.Properties(Mqtt5Writer());
+    /*long enough for a two byte remaining length*/
+    vector<uint8_t> payload(100U, 0x55U);
+    writer.Binary(payload.data(), payload.size());
+    auto packet{encode(writer, 0x32U)};
+    ASSERT_EQ(0x80U, packet[1] & 0x80U);
+
+    RingBuffer ring(256U);
+    /*the type is the last byte before the wrap around, the remaining length follows behind it*/
+    feed(ring, vector<uint8_t>(255U, 0U));
+    ring.Consume(255U);
+    feed(ring, packet);
+
+    uint8_t typeAndFlags{0U};
+    size_t  headerSize{0U};
+    size_t  remaining{0U};
+    ASSERT_EQ(Mqtt5Reader::FixedHeader::COMPLETE,
+              Mqtt5Reader::ReadFixedHeader(ring, typeAndFlags, headerSize, remaining));
+    EXPECT_EQ(0x32U, typeAndFlags);
+    EXPECT_EQ(3U, headerSize);
+    EXPECT_EQ(packet.size() - headerSize, remaining);
+
+    Mqtt5Reader reader(ring, headerSize, headerSize + remaining);
+    EXPECT_EQ("topic/split/across/the/wrap/around", reader.String());
+    EXPECT_EQ(0x1234U, reader.TwoByte());
+    auto propertiesEnd{reader.PropertiesEnd()};
+    EXPECT_EQ(propertiesEnd, reader.Position());
+    vector<uint8_t> received;
+    reader.Binary(received);
+    EXPECT_EQ(payload, received);
+    EXPECT_TRUE(reader.Valid());
+    EXPECT_EQ(0U, reader.Remaining());
+}
+
+TEST(Mqtt5Codec, PropertiesBeyondPacketAreRejected)
+{
+    RingBuffer ring(16U);
+    /*10 bytes of properties announced, 2 present*/
+    feed(ring, {0x0AU, 0x01U, 0x01U});
+    Mqtt5Reader reader(ring, 0U, ring.Size());
+    (void)reader.PropertiesEnd();
+    EXPECT_FALSE(reader.Valid());
+}
+
+TEST(Mqtt5Codec, PropertyRunningPastPropertyLengthIsDetected)
+{
+    RingBuffer ring(16U);
+    /*2 bytes of properties announced, the content type in them is 5 bytes long and runs into the payload*/
+    feed(ring, {0x02U, 0x03U, 0x00U, 0x05U, 'h', 'e', 'l', 'l', 'o'});
+    Mqtt5Reader reader(ring, 0U, ring.Size());
+    auto        propertiesEnd{reader.PropertiesEnd()};
+    while (reader.Valid() && reader.Position() < propertiesEnd) {
+        reader.SkipProperty(reader.Byte());
+    }
+    EXPECT_TRUE(reader.Valid());
+    EXPECT_NE(propertiesEnd, reader.Position());
+}
+
+TEST(Mqtt5Codec, UnknownPropertyIsRejected)
+{
+    RingBuffer ring(16U);
+    feed(ring, {0x02U, 0x7FU, 0x00U});
+    Mqtt5Reader reader(ring, 0U, ring.Size());
+    (void)reader.PropertiesEnd();
+    reader.SkipProperty(reader.Byte());
+    EXPECT_FALSE(reader.Valid());
+}
+
+TEST(Mqtt5Codec, OversizedFieldsAreRejected)
+{
+    Mqtt5Writer writer;
+    writer.String(string(0x10000U, 'a'));
+    EXPECT_FALSE(writer.Valid());
+
+    Mqtt5Writer packet;
+    size_t      offset{0U};
+    (void)packet.Finish(0x30U, 268435456U, offset);
+    EXPECT_FALSE(packet.Valid());
+}
+
+TEST(Mqtt5Codec, RingGrowsKeepingWrappedContent)
+{
+    RingBuffer ring(16U);
+    feed(ring, vector<uint8_t>(12U, 0U));
+    ring.Consume(12U);
+    feed(ring, {1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U});
+    ring.Reserve(64U);
+    EXPECT_EQ(64U, ring.Capacity());
+    ASSERT_EQ(8U, ring.Size());
+    for (size_t i{0U}; i < ring.Size(); i++) {
+        EXPECT_EQ(i + 1U, ring[i]);
+    }
+}
@@ -0,0 +1,419 @@
+/**
+ * @file NativeClientTest.cpp
+ * @author Timo Lange
+ * @brief Tests of the native client against a scripted broker
+ * @date 2020
+ * @copyright    Copyright 2020 Timo Lange
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "IMqttClient.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace i_mqtt_client;
+
+namespace {
+constexpr int ioTimeoutMs{5000};
+
+struct Packet final {
+    uint8_t         typeAndFlags{0U};
+    vector<uint8_t> body;
+
+    uint8_t
+    Type(void) const noexcept
+    {
+        return static_cast<uint8_t>(typeAndFlags >> 4U);
+    }
+    uint16_t
+    TwoByte(size_t pos) const
+    {
+        return static_cast<uint16_t>((body.at(pos) << 8U) | body.at(pos + 1U));
+    }
+    /*packet identifier of a publish, behind its topic*/
+    uint16_t
+    PublishId(void) const
+    {
+        return TwoByte(2U + TwoByte(0U));
+    }
+};
+
+vector<uint8_t>
+encode(uint8_t typeAndFlags, vector<uint8_t> const& body)
+{
+    vector<uint8_t> packet{typeAndFlags};
+    auto            remaining{body.size()};
+    do {
+        auto digit{static_cast<uint8_t>(remaining & 0x7FU)};
+        remaining >>= 7U;
+        packet.push_back(remaining ? static_cast<uint8_t>(digit | 0x80U) : digit);
+    } while (remaining);
+    packet.insert(packet.end(), body.begin(), body.end());
+    return packet;
+}
+
+vector<uint8_t>
+connAck(bool sessionPresent, vector<uint8_t> const& props = {})
+{
+    vector<uint8_t> body{static_cast<uint8_t>(sessionPresent ? 1U : 0U), 0x00U, static_cast<uint8_t>(props.size())};
+    body.insert(body.end(), props.begin(), props.end());
+    return encode(0x20U, body);
+}
+
+vector<uint8_t>
+ack(uint8_t typeAndFlags, uint16_t id)
+{
+    return encode(typeAndFlags, {static_cast<uint8_t>(id >> 8U), static_cast<uint8_t>(id)});
+}
+
+/*Plays the broker on a loopback socket, each test scripts the packets it expects and sends*/
+class ScriptedBroker final {
+private:
+    int listenSock{-1};
+    int sock{-1};
+
+    bool
+    wait(int fd)
+    {
+        pollfd pfd{fd, POLLIN, 0};
+        return poll(&pfd, 1, ioTimeoutMs) > 0;
+    }
+    bool
+    receive(uint8_t* dst, size_t len)
+    {
+        while (len) {
+            if (!wait(sock)) {
+                return false;
+            }
+            auto received{recv(sock, dst, len, 0)};
+            if (received <= 0) {
+                return false;
+            }
+            dst += received;
+            len -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+
+public:
+    ScriptedBroker(void)
+    {
+        listenSock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = 0;
+        if (bind(listenSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) || listen(listenSock, 1)) {
+            throw runtime_error("scripted broker can not listen");
+        }
+    }
+    ~ScriptedBroker() noexcept
+    {
+        Close();
+        close(listenSock);
+    }
+
+    int
+    Port(void) const
+    {
+        sockaddr_in addr{};
+        socklen_t   len{sizeof(addr)};
+        (void)getsockname(listenSock, reinterpret_cast<sockaddr*>(&addr), &len);
+        return ntohs(addr.sin_port);
+    }
+    /*accepts the connection of the client and reads its CONNECT*/
+    bool
+    Accept(void)
+    {
+        Close();
+        if (!wait(listenSock)) {
+            return false;
+        }
+        sock = accept(listenSock, nullptr, nullptr);
+        Packet connect;
+        return sock >= 0 && Receive(connect) && 1U == connect.Type();
+    }
+    bool
+    Receive(Packet& packet)
+    {
+        size_t remaining{0U};
+        if (!receive(&packet.typeAndFlags, 1U)) {
+            return false;
+        }
+        for (unsigned shift{0U};; shift += 7U) {
+            uint8_t digit{0U};
+            if (shift > 21U || !receive(&digit, 1U)) {
+                return false;
+            }
+            remaining |= static_cast<size_t>(digit & 0x7FU) << shift;
+            if (!(digit & 0x80U)) {
+                break;
+            }
+        }
+        packet.body.resize(remaining);
+        return receive(packet.body.data(), remaining);
+    }
+    void
+    Send(vector<uint8_t> const& bytes)
+    {
+        ASSERT_EQ(static_cast<ssize_t>(bytes.size()), send(sock, bytes.data(), bytes.size(), MSG_NOSIGNAL));
+    }
+    void
+    Close(void)
+    {
+        if (sock >= 0) {
+            close(sock);
+            sock = -1;
+        }
+    }
+};
+
+/*Records what the client reports, tests wait for the reports they expect*/
+class Recorder final : public IMqttClientCallbacks {
+private:
+    mutable mutex              recorderMutex;
+    mutable condition_variable recorderAwaiter;
+
+    bool
+    waitFor(function<bool(void)> const& done) const
+    {
+        unique_lock<mutex> lock(recorderMutex);
+        return recorderAwaiter.wait_for(lock, milliseconds(ioTimeoutMs), done);
+    }
+
+public:
+    mutable unsigned                               connects{0U};
+    mutable vector<pair<token_t, Mqtt5ReasonCode>> publishes;
+    mutable vector<string>                         messages;
+
+    void
+    OnMqttMessage(upMqttMessage_t msg) const override
+    {
+        lock_guard<mutex> lock(recorderMutex);
+        messages.push_back(msg->topic);
+        recorderAwaiter.notify_all();
+    }
+    void
+    OnConnectionStatusChanged(ConnectionType type, Mqtt5ReasonCode rc) const override
+    {
+        lock_guard<mutex> lock(recorderMutex);
+        if (ConnectionType::CONNECT == type && Mqtt5ReasonCode::SUCCESS == rc) {
+            connects++;
+        }
+        recorderAwaiter.notify_all();
+    }
+    void
+    OnPublish(token_t token, Mqtt5ReasonCode rc) const override
+    {
+        lock_guard<mutex> lock(recorderMutex);
+        publishes.push_back(make_pair(token, rc));
+        recorderAwaiter.notify_all();
+    }
+
+    bool
+    WaitForConnects(unsigned count) const
+    {
+        return waitFor([this, count] { return connects >= count; });
+    }
+    bool
+    WaitForPublishes(size_t count) const
+    {
+        return waitFor([this, count] { return publishes.size() >= count; });
+    }
+    bool
+    WaitForMessages(size_t count) const
+    {
+        return waitFor([this, count] { return messages.size() >= count; });
+    }
+};
+
+class NativeClientTest : public ::testing::Test {
+protected:
+    ScriptedBroker                    broker;
+    Recorder                          recorder;
+    IMqttClient::InitializeParameters params;
+    unique_ptr<IMqttClient>           client;
+
+    NativeClientTest(void)
+    {
+        params.backend           = IMqttClient::Backend::NATIVE;
+        params.hostAddress       = "127.0.0.1";
+        params.port              = broker.Port();
+        params.clientId          = "test";
+        params.reconnectDelayMin = 0;
+    }
+
+    /*connects the client, the broker answers with the CONNACK given*/
+    void
+    connect(vector<uint8_t> const& ack)
+    {
+        client = MqttClientFactory::Create(params, &recorder, &recorder, &recorder, &recorder);
+        ASSERT_EQ(ReasonCode::OKAY, client->ConnectAsync());
+        ASSERT_TRUE(broker.Accept());
+        broker.Send(ack);
+        ASSERT_TRUE(recorder.WaitForConnects(1U));
+    }
+    /*expects the client to close the connection with a DISCONNECT carrying the reason code*/
+    void
+    expectDisconnect(Mqtt5ReasonCode rc)
+    {
+        Packet disconnect;
+        ASSERT_TRUE(broker.Receive(disconnect));
+        ASSERT_EQ(14U, disconnect.Type());
+        ASSERT_EQ(1U, disconnect.body.size());
+        EXPECT_EQ(static_cast<uint8_t>(rc), disconnect.body[0]);
+    }
+
+    void
+    TearDown(void) override
+    {
+        client.reset();
+    }
+};
+}  // namespace
+
+TEST_F(NativeClientTest, RefusedQosAndRetainAreRejected)
+{
+    /*Maximum QoS 0, Retain Available 0*/
+    connect(connAck(false, {0x24U, 0x00U, 0x25U, 0x00U}));
+
+    EXPECT_EQ(ReasonCode::ERROR_GENERAL,
+              client->PublishAsync(MqttMessageFactory::Create("a", {1U}, IMqttMessage::QOS::QOS_1)));
+    EXPECT_EQ(ReasonCode::ERROR_GENERAL,
+              client->PublishAsync(MqttMessageFactory::Create("a", {1U}, IMqttMessage::QOS::QOS_0, true)));
+    EXPECT_EQ(ReasonCode::OKAY, client->PublishAsync(MqttMessageFactory::Create("a", {1U}, IMqttMessage::QOS::QOS_0)));
+
+    Packet publish;
+    ASSERT_TRUE(broker.Receive(publish));
+    EXPECT_EQ(0x30U, publish.typeAndFlags);
+}
+
+TEST_F(NativeClientTest, Qos2PublishIsReleasedAndCompleted)
+{
+    connect(connAck(false));
+
+    int token{-1};
+    ASSERT_EQ(ReasonCode::OKAY,
+              client->PublishAsync(MqttMessageFactory::Create("a", {1U}, IMqttMessage::QOS::QOS_2), &token));
+    Packet publish;
+    ASSERT_TRUE(broker.Receive(publish));
+    ASSERT_EQ(0x34U, publish.typeAndFlags);
+    auto id{publish.PublishId()};
+    EXPECT_EQ(token, id);
+
+    broker.Send(ack(0x50U, id));
+    Packet release;
+    ASSERT_TRUE(broker.Receive(release));
+    ASSERT_EQ(0x62U, release.typeAndFlags);
+    EXPECT_EQ(id, release.TwoByte(0U));
+    EXPECT_TRUE(recorder.publishes.empty());
+
+    broker.Send(ack(0x70U, id));
+    ASSERT_TRUE(recorder.WaitForPublishes(1U));
+    EXPECT_EQ(token, recorder.publishes[0].first);
+    EXPECT_EQ(Mqtt5ReasonCode::SUCCESS, recorder.publishes[0].second);
+}
+
+TEST_F(NativeClientTest, Qos2MessageIsDeliveredOnce)
+{
+    connect(connAck(false));
+
+    /*topic "t", packet identifier 5, no properties*/
+    auto publish{encode(0x34U, {0x00U, 0x01U, 't', 0x00U, 0x05U, 0x00U, 0xAAU})};
+    broker.Send(publish);
+    Packet received;
+    ASSERT_TRUE(broker.Receive(received));
+    ASSERT_EQ(0x50U, received.typeAndFlags);
+    EXPECT_EQ(5U, received.TwoByte(0U));
+
+    /*the PUBREC got lost, the broker resends the message as duplicate*/
+    publish[0] |= 0x08U;
+    broker.Send(publish);
+    ASSERT_TRUE(broker.Receive(received));
+    ASSERT_EQ(0x50U, received.typeAndFlags);
+
+    broker.Send(ack(0x62U, 5U));
+    ASSERT_TRUE(broker.Receive(received));
+    ASSERT_EQ(0x70U, received.typeAndFlags);
+    EXPECT_EQ(5U, received.TwoByte(0U));
+
+    ASSERT_TRUE(recorder.WaitForMessages(1U));
+    EXPECT_EQ(1U, recorder.messages.size());
+}
+
+TEST_F(NativeClientTest, InFlightPublishIsResentAsDuplicate)
+{
+    params.cleanSession = false;
+    connect(connAck(false));
+
+    int token{-1};
+    ASSERT_EQ(ReasonCode::OKAY,
+              client->PublishAsync(MqttMessageFactory::Create("a", {1U}, IMqttMessage::QOS::QOS_1), &token));
+    Packet publish;
+    ASSERT_TRUE(broker.Receive(publish));
+    ASSERT_EQ(0x32U, publish.typeAndFlags);
+    auto id{publish.PublishId()};
+
+    /*the connection breaks before the PUBACK, the client reconnects and the broker kept the session*/
+    broker.Close();
+    ASSERT_TRUE(broker.Accept());
+    broker.Send(connAck(true));
+    ASSERT_TRUE(recorder.WaitForConnects(2U));
+
+    Packet resent;
+    ASSERT_TRUE(broker.Receive(resent));
+    EXPECT_EQ(0x3AU, resent.typeAndFlags);
+    EXPECT_EQ(id, resent.PublishId());
+
+    broker.Send(ack(0x40U, id));
+    ASSERT_TRUE(recorder.WaitForPublishes(1U));
+    EXPECT_EQ(token, recorder.publishes[0].first);
+    EXPECT_EQ(Mqtt5ReasonCode::SUCCESS, recorder.publishes[0].second);
+}
+
+TEST_F(NativeClientTest, PropertyOverrunIsMalformed)
+{
+    connect(connAck(false));
+
+    /*2 bytes of properties announced, the content type in them runs 3 bytes into the payload*/
+    broker.Send(encode(0x30U, {0x00U, 0x01U, 't', 0x02U, 0x03U, 0x00U, 0x05U, 'h', 'e', 'l', 'l', 'o'}));
+    expectDisconnect(Mqtt5ReasonCode::MALFORMED_PACKET);
+    EXPECT_TRUE(recorder.messages.empty());
+}
+
+TEST_F(NativeClientTest, OversizedPacketIsRejected)
+{
+    params.native.maxPacketSize = 1024U;
+    connect(connAck(false));
+
+    /*only the fixed header is sent, the size is known from it already*/
+    broker.Send({0x30U, 0xD0U, 0x0FU});
+    expectDisconnect(Mqtt5ReasonCode::PACKET_TOO_LARGE);
+}